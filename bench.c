@@ -0,0 +1,392 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o bench bench.c position.c movegen.c game.c zobrist.c tt.c search.c magic.c eval.c nnue.c book.c bitbase.c stats.c
+// ./bench                                      searches the bench positions to depth 9
+// ./bench -movetime 1000                       one second per position
+// ./bench -fen "<fen>" -depth 12 -hash 64      searches one position
+// ./bench -threads 8                           same with 8 search threads
+// ./bench -threads 8 -scaling                  time to depth and nps for 1 to 8 threads
+// ./bench -nnue net.bin                        searches with a neural network instead of the piece-square tables
+// ./bench -eval                                evaluations per second, add -march=native for the AVX2 kernels
+// ./bench -trace trace.json                    counters and a Chrome trace of the searches, built with -DCHESS_STATS
+
+/*
+ * Search benchmark: runs the engine on a fixed set of positions and prints
+ * every iteration with its score, nodes per second and principal variation.
+ * With one thread, the total node count at a fixed depth only changes when
+ * the search itself changes, so it doubles as a quick regression check.
+ * More threads make the counts vary from run to run.
+ *
+ * -eval times the evaluations instead, on positions taken from random
+ * games, and checks the incremental scores against full recomputations.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <time.h>
+#include "chess.h"
+
+// Positions the evaluation benchmark runs on, and how many times it goes over them
+#define EVAL_SAMPLES 4096
+#define EVAL_ROUNDS 200
+
+// Openings, middlegames and endgames, with tactics and a few long mates
+static const char* bench_positions[] = {
+	START_FEN,
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"rnbqkb1r/pp1p1ppp/2p5/4P3/2B5/8/PPP1NnPP/RNBQK2R w KQkq - 0 6",
+	"2r3k1/pp3ppp/8/3Q4/8/8/PPP2PPP/6K1 w - - 0 1",
+	"6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+	"8/8/8/4k3/8/8/8/4K2R w K - 0 1",
+	"8/k7/3p4/p2P1p2/P2P1P2/8/8/K7 w - - 0 1",
+};
+
+static void print_iteration(const struct SearchResult* result, void* data)
+{
+	(void) data;
+	char name[6];
+
+	printf("  depth %2d/%-2d ", result->depth, result->seldepth);
+	if (result->score >= SCORE_MATE_BOUND) {
+		printf("mate %-4d", (SCORE_MATE - result->score + 1) / 2);
+	} else if (result->score <= -SCORE_MATE_BOUND) {
+		printf("mate %-4d", -(SCORE_MATE + result->score) / 2);
+	} else {
+		printf("cp %-6d", result->score);
+	}
+	printf(" %10" PRIu64 " nodes %6" PRId64 " ms %9" PRIu64 " nps  pv", result->nodes, result->time_ms, result->nps);
+
+	for (int i = 0; i < result->pv_length; ++i) {
+		move_to_string(result->pv[i], name);
+		printf(" %s", name);
+	}
+	printf("\n");
+}
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next_random(uint64_t* state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+
+	return *state * 2685821657736338717ULL;
+}
+
+// Positions reached by random moves from the bench positions, each with a legal move to play from it
+static int sample_positions(const char** positions, size_t count, struct Position* samples, uint16_t* moves)
+{
+	uint64_t state = 0x9E3779B97F4A7C15ULL;
+	int sampled = 0;
+
+	while (sampled < EVAL_SAMPLES) {
+		struct Position pos;
+		struct MoveList list;
+		struct Undo undo;
+
+		position_from_fen(&pos, positions[sampled % count]);
+		int plies = (int) (next_random(&state) % 60);
+
+		for (int i = 0; i < plies; ++i) {
+			generate_legal_moves(&pos, &list);
+			if (list.count == 0) break;
+			make_move(&pos, list.moves[next_random(&state) % list.count], &undo);
+		}
+
+		generate_legal_moves(&pos, &list);
+		if (list.count == 0) continue;
+
+		samples[sampled] = pos;
+		moves[sampled++] = list.moves[next_random(&state) % list.count];
+	}
+
+	return sampled;
+}
+
+static void print_rate(const char* name, double seconds, uint64_t count)
+{
+	printf("%-36s %10.1f M/s  %6.1f ns\n", name, count / seconds / 1e6, seconds * 1e9 / count);
+}
+
+// Evaluations per second of the piece-square tables and of the network, 'network' being any, even random
+static bool run_eval_bench(const char** positions, size_t count, const struct NnueNetwork* network)
+{
+	static struct Position samples[EVAL_SAMPLES];
+	static uint16_t moves[EVAL_SAMPLES];
+	static struct Accumulator parents[EVAL_SAMPLES];
+	struct Accumulator child;
+	struct Accumulator check;
+	uint64_t total = (uint64_t) EVAL_SAMPLES * EVAL_ROUNDS;
+	volatile int sink = 0;
+	bool ok = true;
+
+	int n = sample_positions(positions, count, samples, moves);
+
+	// The incremental scores and accumulators must match the ones computed from scratch
+	for (int i = 0; i < n; ++i) {
+		struct Position after = samples[i];
+		struct Undo undo;
+
+		nnue_refresh(network, &samples[i], &parents[i]);
+		nnue_update(network, &parents[i], &child, &samples[i], moves[i]);
+		make_move(&after, moves[i], &undo);
+		nnue_refresh(network, &after, &check);
+
+		if (evaluate(&samples[i]) != evaluate_full(&samples[i]) || evaluate(&after) != evaluate_full(&after)) {
+			printf("piece-square scores differ from a full evaluation after %d samples\n", i);
+			ok = false;
+			break;
+		}
+		if (memcmp(&child, &check, sizeof(child)) != 0) {
+			printf("accumulator update differs from a refresh after %d samples\n", i);
+			ok = false;
+			break;
+		}
+	}
+
+	printf("%d positions, %d rounds, network kernels: %s\n", n, EVAL_ROUNDS, nnue_kernel());
+
+	double begin = now_seconds();
+	for (int round = 0; round < EVAL_ROUNDS; ++round) {
+		for (int i = 0; i < n; ++i) sink += evaluate(&samples[i]);
+	}
+	print_rate("piece-square, incremental", now_seconds() - begin, total);
+
+	begin = now_seconds();
+	for (int round = 0; round < EVAL_ROUNDS; ++round) {
+		for (int i = 0; i < n; ++i) sink += evaluate_full(&samples[i]);
+	}
+	print_rate("piece-square, every square", now_seconds() - begin, total);
+
+	begin = now_seconds();
+	for (int round = 0; round < EVAL_ROUNDS; ++round) {
+		for (int i = 0; i < n; ++i) {
+			nnue_update(network, &parents[i], &child, &samples[i], moves[i]);
+			sink += nnue_evaluate(network, &child, !samples[i].side);
+		}
+	}
+	print_rate("network, accumulator update", now_seconds() - begin, total);
+
+	begin = now_seconds();
+	for (int round = 0; round < EVAL_ROUNDS; ++round) {
+		for (int i = 0; i < n; ++i) {
+			nnue_refresh(network, &samples[i], &child);
+			sink += nnue_evaluate(network, &child, samples[i].side);
+		}
+	}
+	print_rate("network, accumulator refresh", now_seconds() - begin, total);
+
+	(void) sink;
+	return ok;
+}
+
+// Totals of one run over the positions
+struct BenchTotals {
+	uint64_t nodes;
+	int64_t time_ms;
+};
+
+// Searches every position with 'threads' threads, printing each iteration when 'verbose'
+static bool run_bench(const char** positions, size_t count, const struct SearchLimits* limits,
+	struct TranspositionTable* tt, const struct NnueNetwork* network, int threads, bool verbose, struct BenchTotals* totals)
+{
+	struct SearchPool pool;
+	static struct Game game;
+
+	if (!search_pool_init(&pool, threads, tt)) {
+		fprintf(stderr, "Can't start %d search threads\n", threads);
+		return false;
+	}
+	if (verbose) pool.searches[0].on_iteration = print_iteration;
+	search_pool_set_network(&pool, network);
+
+	totals->nodes = 0;
+	totals->time_ms = 0;
+
+	for (size_t i = 0; i < count; ++i) {
+		if (!game_init_fen(&game, positions[i])) {
+			fprintf(stderr, "Invalid FEN: %s\n", positions[i]);
+			search_pool_free(&pool);
+			return false;
+		}
+
+		// Every position starts from empty tables so the node counts don't depend on the order
+		tt_clear(tt);
+		search_pool_clear(&pool);
+		if (verbose) printf("%s\n", positions[i]);
+
+		struct SearchResult result;
+		search_pool_set_game(&pool, &game);
+		uint16_t best = search_pool_run(&pool, limits, &result);
+
+		if (verbose) {
+			char name[6] = "none";
+			if (best != MOVE_NONE) move_to_string(best, name);
+			printf("  bestmove %s, %" PRIu64 " nodes, %" PRIu64 " hits in %" PRIu64 " probes\n",
+				name, result.nodes, pool.searches[0].tt_stats.hits, pool.searches[0].tt_stats.probes);
+		}
+
+		totals->nodes += result.nodes;
+		totals->time_ms += result.time_ms;
+	}
+
+	search_pool_free(&pool);
+	return true;
+}
+
+// Totals of the counters and timers, and the trace in 'path'
+static void print_stats(const char* path)
+{
+	struct StatsTotals stats;
+	stats_totals(&stats);
+
+	for (int i = 0; i < STATS_COUNTER_COUNT; ++i) printf("%-24s %" PRIu64 "\n", stats_counter_names[i], stats.counters[i]);
+	for (int i = 0; i < STATS_TIMER_COUNT; ++i) {
+		const struct StatsTimerTotals* timer = &stats.timers[i];
+		if (timer->count == 0) continue;
+		printf("%-24s %" PRIu64 " runs, %.3f us on average, %.3f us at most\n", stats_timer_names[i], timer->count,
+			timer->total_ns / 1e3 / timer->count, timer->max_ns / 1e3);
+	}
+
+	if (!stats_write_trace(path)) fprintf(stderr, "Can't write %s\n", path);
+}
+
+int main(int argc, char* argv[])
+{
+	struct SearchLimits limits = {0};
+	const char* fen = NULL;
+	size_t hash_mb = 16;
+	const char* network_path = NULL;
+	int threads = 1;
+	bool scaling = false;
+	bool eval = false;
+	const char* trace_path = NULL;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc) {
+			limits.depth = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-nodes") == 0 && i + 1 < argc) {
+			limits.nodes = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "-movetime") == 0 && i + 1 < argc) {
+			limits.time_ms = atoll(argv[++i]);
+		} else if (strcmp(argv[i], "-fen") == 0 && i + 1 < argc) {
+			fen = argv[++i];
+		} else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc) {
+			hash_mb = (size_t) atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-scaling") == 0) {
+			scaling = true;
+		} else if (strcmp(argv[i], "-nnue") == 0 && i + 1 < argc) {
+			network_path = argv[++i];
+		} else if (strcmp(argv[i], "-eval") == 0) {
+			eval = true;
+		} else if (strcmp(argv[i], "-trace") == 0 && i + 1 < argc) {
+			trace_path = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: %s [-depth n] [-nodes n] [-movetime ms] [-fen \"<fen>\"] [-hash mb] [-threads n] [-scaling] [-nnue file] [-eval] [-trace file]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	// A polyglot_random.h with the numbers out of order builds fine but matches no other tool's book
+	if (book_polyglot_keys()) {
+		struct Position start;
+		position_from_fen(&start, START_FEN);
+		if (book_key(&start) != BOOK_POLYGLOT_START_KEY) {
+			fprintf(stderr, "The book key of the starting position is %016" PRIX64 " instead of %016" PRIX64 ", polyglot_random.h is wrong\n",
+				book_key(&start), (uint64_t) BOOK_POLYGLOT_START_KEY);
+			return 1;
+		}
+	}
+
+	if (trace_path != NULL && !stats_enabled()) {
+		fprintf(stderr, "-trace needs a build with -DCHESS_STATS\n");
+		return 1;
+	}
+
+	if (limits.depth == 0 && limits.nodes == 0 && limits.time_ms == 0) limits.depth = 9;
+	if (threads < 1) threads = 1;
+
+	const char** positions = fen != NULL ? &fen : bench_positions;
+	size_t count = fen != NULL ? 1 : sizeof(bench_positions) / sizeof(bench_positions[0]);
+
+	// Without a file, the evaluation benchmark times a random network of the same size
+	struct NnueNetwork* network = NULL;
+	if (network_path != NULL || eval) {
+		network = malloc(sizeof(*network));
+		if (network == NULL || (network_path != NULL && !nnue_load(network, network_path))) {
+			fprintf(stderr, "Can't load the network %s\n", network_path != NULL ? network_path : "");
+			free(network);
+			return 1;
+		}
+		if (network_path == NULL) nnue_randomize(network, 1);
+	}
+
+	if (eval) {
+		bool ok = run_eval_bench(positions, count, network);
+		free(network);
+		return ok ? 0 : 1;
+	}
+
+	struct TranspositionTable tt;
+	if (!tt_init(&tt, hash_mb)) {
+		fprintf(stderr, "Can't allocate a %zu MB hash table\n", hash_mb);
+		free(network);
+		return 1;
+	}
+
+	struct BenchTotals totals;
+
+	if (!scaling) {
+		bool ok = run_bench(positions, count, &limits, &tt, network, threads, true, &totals);
+		if (ok) {
+			printf("%" PRIu64 " nodes in %" PRId64 " ms, %" PRIu64 " nps\n", totals.nodes, totals.time_ms,
+				totals.nodes * 1000 / (totals.time_ms > 0 ? totals.time_ms : 1));
+		}
+		if (ok && trace_path != NULL) print_stats(trace_path);
+
+		tt_free(&tt);
+		free(network);
+		return ok ? 0 : 1;
+	}
+
+	// Time to depth is what matters for Lazy SMP: the extra threads search more
+	// nodes than needed, the question is how much sooner the depth is reached
+	int64_t base_ms = 0;
+	printf("threads %12s %10s %12s %8s\n", "nodes", "ms", "nps", "speedup");
+	for (int n = 1; n <= threads; ++n) {
+		if (!run_bench(positions, count, &limits, &tt, network, n, false, &totals)) {
+			tt_free(&tt);
+			free(network);
+			return 1;
+		}
+
+		int64_t ms = totals.time_ms > 0 ? totals.time_ms : 1;
+		if (n == 1) base_ms = ms;
+		printf("%7d %12" PRIu64 " %10" PRId64 " %12" PRIu64 " %8.2f\n", n, totals.nodes, totals.time_ms,
+			totals.nodes * 1000 / ms, (double) base_ms / ms);
+	}
+
+	tt_free(&tt);
+	free(network);
+	return 0;
+}
@@ -0,0 +1,231 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bitbase.h"
+#include "gamefile.h"
+
+const char* const bitbase_set_names[BITBASE_SET_COUNT] = {
+	"KQK", "KRK", "KPK", "KBNK", "KQKR", "KRKB", "KRKN",
+};
+
+static int piece_type_from_letter(char letter)
+{
+	switch (letter) {
+	case 'P': return PAWN;
+	case 'N': return KNIGHT;
+	case 'B': return BISHOP;
+	case 'R': return ROOK;
+	case 'Q': return QUEEN;
+	default: return EMPTY;
+	}
+}
+
+// One of the 8 symmetries of the board: bit 0 mirrors the columns, bit 1 the rows, bit 2 swaps them
+static int transform(int sq, int symmetry)
+{
+	int x = SQUARE_X(sq);
+	int y = SQUARE_Y(sq);
+
+	if (symmetry & 1) x = 7 - x;
+	if (symmetry & 2) y = 7 - y;
+	if (symmetry & 4) return SQUARE(y, x);
+
+	return SQUARE(x, y);
+}
+
+bool bitbase_table_init(struct BitbaseTable* table, const char* name)
+{
+	memset(table, 0, sizeof(*table));
+	if (strlen(name) >= sizeof(table->name) || name[0] != 'K') return false;
+
+	const char* black = strchr(name + 1, 'K');
+	if (black == NULL) return false;
+
+	strcpy(table->name, name);
+	for (const char* c = name; *c != '\0'; ++c) {
+		int color = c < black ? PLAYER_WHITE : PLAYER_BLACK;
+		int type = *c == 'K' ? KING : piece_type_from_letter(*c);
+		if (type == EMPTY || table->piece_count == BITBASE_MAX_PIECES) return false;
+		if (c != name && c != black && type == KING) return false;
+
+		table->pieces[table->piece_count++] = MAKE_PIECE(type, color);
+		if (type == PAWN) table->pawns = true;
+	}
+
+	// Pawns only allow the left-right mirror: the king goes on files a to d. Without
+	// them it goes in the triangle a8-d8-d5, where every square is the smallest of its images.
+	memset(table->king_index, -1, sizeof(table->king_index));
+	for (int sq = 0; sq < 64; ++sq) {
+		int x = SQUARE_X(sq);
+		int y = SQUARE_Y(sq);
+		bool kept = table->pawns ? x <= 3 : y <= x && x <= 3;
+		if (!kept) continue;
+
+		table->king_square[table->king_squares] = (int8_t) sq;
+		table->king_index[sq] = (int8_t) table->king_squares++;
+	}
+
+	table->entries = 2 * (uint64_t) table->king_squares;
+	for (int i = 1; i < table->piece_count; ++i) table->entries *= 64;
+
+	return true;
+}
+
+uint64_t bitbase_index(const struct BitbaseTable* table, const int* squares, int side)
+{
+	uint64_t best = UINT64_MAX;
+	int symmetries = table->pawns ? 2 : 8;
+
+	// The smallest index of all the images, so that every image gets the same one
+	for (int symmetry = 0; symmetry < symmetries; ++symmetry) {
+		int king = table->king_index[transform(squares[0], symmetry)];
+		if (king < 0) continue;
+
+		uint64_t index = (uint64_t) king;
+		for (int i = 1; i < table->piece_count; ++i) index = index * 64 + (uint64_t) transform(squares[i], symmetry);
+		index = index * 2 + (uint64_t) side;
+
+		if (index < best) best = index;
+	}
+
+	return best;
+}
+
+bool bitbase_decode(const struct BitbaseTable* table, uint64_t index, int* squares, int* side)
+{
+	uint64_t rest = index / 2;
+
+	*side = (int) (index % 2);
+	for (int i = table->piece_count - 1; i > 0; --i) {
+		squares[i] = (int) (rest % 64);
+		rest /= 64;
+	}
+	squares[0] = table->king_square[rest];
+
+	return bitbase_index(table, squares, *side) == index;
+}
+
+void bitbases_init(struct Bitbases* bitbases)
+{
+	for (int i = 0; i < BITBASE_SET_COUNT; ++i) bitbase_table_init(&bitbases->tables[i], bitbase_set_names[i]);
+}
+
+static bool map_table(struct BitbaseTable* table, const char* path)
+{
+	struct BitbaseFileHeader header;
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) return false;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size != sizeof(header) + (table->entries + 3) / 4) {
+		close(fd);
+		return false;
+	}
+
+	void* mapping = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	memcpy(&header, mapping, sizeof(header));
+	if (memcmp(header.magic, BITBASE_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != BITBASE_FILE_VERSION
+		|| strncmp(header.name, table->name, sizeof(header.name)) != 0 || header.entries != table->entries) {
+		munmap(mapping, (size_t) st.st_size);
+		return false;
+	}
+
+	// The search probes scattered positions, reading ahead would only load pages never used
+	posix_madvise(mapping, (size_t) st.st_size, POSIX_MADV_RANDOM);
+
+	table->mapping = mapping;
+	table->mapping_size = (size_t) st.st_size;
+	table->data = (const uint8_t*) mapping + sizeof(header);
+
+	return true;
+}
+
+int bitbases_open(struct Bitbases* bitbases, const char* directory)
+{
+	char path[4096];
+	int found = 0;
+
+	bitbases_init(bitbases);
+	for (int i = 0; i < BITBASE_SET_COUNT; ++i) {
+		struct BitbaseTable* table = &bitbases->tables[i];
+		snprintf(path, sizeof(path), "%s/%s.bb", directory, table->name);
+		if (map_table(table, path)) ++found;
+	}
+
+	return found;
+}
+
+void bitbases_close(struct Bitbases* bitbases)
+{
+	for (int i = 0; i < BITBASE_SET_COUNT; ++i) {
+		struct BitbaseTable* table = &bitbases->tables[i];
+		if (table->mapping != NULL) munmap((void*) table->mapping, table->mapping_size);
+		table->mapping = NULL;
+		table->data = NULL;
+	}
+}
+
+/*
+ * Squares of the pieces of 'table' in 'pos', with the colors swapped and
+ * the board turned upside down when 'flip' is set. False if the position
+ * doesn't have exactly these pieces, given it has as many.
+ */
+static bool table_squares(const struct BitbaseTable* table, const struct Position* pos, bool flip, int* squares)
+{
+	for (int i = 0; i < table->piece_count; ++i) {
+		int piece = table->pieces[i];
+		int color = flip ? !PIECE_COLOR(piece) : PIECE_COLOR(piece);
+		uint64_t bits = pos->pieces[MAKE_PIECE(PIECE_TYPE(piece), color)];
+		if (popcount(bits) != 1) return false;
+
+		squares[i] = flip ? lsb(bits) ^ 56 : lsb(bits);
+	}
+
+	return true;
+}
+
+int bitbase_probe(const struct Bitbases* bitbases, const struct Position* pos)
+{
+	int count = popcount(pos->occupied);
+	if (count > BITBASE_MAX_PIECES || pos->ep_square != -1) return BITBASE_NONE;
+
+	uint64_t minors = pos->pieces[MAKE_PIECE(KNIGHT, PLAYER_WHITE)] | pos->pieces[MAKE_PIECE(BISHOP, PLAYER_WHITE)]
+		| pos->pieces[MAKE_PIECE(KNIGHT, PLAYER_BLACK)] | pos->pieces[MAKE_PIECE(BISHOP, PLAYER_BLACK)];
+	if (count == 2 || (count == 3 && minors != 0)) return BITBASE_DRAW;
+
+	for (int i = 0; i < BITBASE_SET_COUNT; ++i) {
+		const struct BitbaseTable* table = &bitbases->tables[i];
+		if (table->data == NULL || table->piece_count != count) continue;
+
+		for (int flip = 0; flip < 2; ++flip) {
+			int squares[BITBASE_MAX_PIECES];
+			if (!table_squares(table, pos, flip, squares)) continue;
+
+			int side = flip ? !pos->side : pos->side;
+			int result = bitbase_entry(table, bitbase_index(table, squares, side));
+
+			return result == BITBASE_INVALID ? BITBASE_NONE : result;
+		}
+	}
+
+	return BITBASE_NONE;
+}
+
+int bitbase_result(const struct Bitbases* bitbases, const struct Position* pos)
+{
+	int result = bitbase_probe(bitbases, pos);
+
+	if (result == BITBASE_NONE) return GAME_RESULT_UNKNOWN;
+	if (result == BITBASE_DRAW) return GAME_RESULT_DRAW;
+
+	int winner = result == BITBASE_WIN ? pos->side : !pos->side;
+	return winner == PLAYER_WHITE ? GAME_RESULT_WHITE_WINS : GAME_RESULT_BLACK_WINS;
+}
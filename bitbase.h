@@ -0,0 +1,101 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "position.h"
+
+/*
+ * Endgame bitbases: whether the player to move wins, draws or loses, for
+ * every position of a few small material sets, worked out backwards from
+ * the mates by gen_bitbase and read through a memory mapping.
+ *
+ * A set is named by its pieces, the stronger side's first ("KRKB"). It is
+ * stored with that side as White; a position where it is Black is flipped
+ * before probing. Positions that are the same up to a symmetry of the
+ * board share an entry: mirroring and rotating put the white king on one
+ * of 10 squares when there are no pawns, mirroring left to right on one
+ * of 32 when there are. Each entry takes 2 bits.
+ *
+ * Castling rights don't matter in these sets; a position with an en
+ * passant square is never probed.
+ */
+#define BITBASE_MAX_PIECES 4
+
+// Results for the player to move. BITBASE_INVALID marks the entries of illegal and duplicate positions.
+#define BITBASE_NONE -1
+#define BITBASE_LOSS 0
+#define BITBASE_DRAW 1
+#define BITBASE_WIN 2
+#define BITBASE_INVALID 3
+
+#define BITBASE_FILE_MAGIC "BBAS"
+#define BITBASE_FILE_VERSION 1
+
+// Sets with a file, in an order where each one only leads (by a capture or a promotion) to the ones before it
+#define BITBASE_SET_COUNT 7
+extern const char* const bitbase_set_names[BITBASE_SET_COUNT];
+
+struct BitbaseFileHeader {
+	char magic[4];
+	uint32_t version;
+	char name[8];			// the set, terminated
+	uint64_t entries;
+};
+
+// A set's layout and, once generated or mapped, its entries
+struct BitbaseTable {
+	char name[8];
+	int piece_count;
+	int pieces[BITBASE_MAX_PIECES];	// piece codes: the white king, the other white pieces, the black king, the other black pieces
+	bool pawns;
+	int king_squares;				// squares the white king is put on by the symmetries: 10, or 32 with pawns
+	int8_t king_index[64];			// index among those squares, -1 for the others
+	int8_t king_square[32];			// the other way round
+	uint64_t entries;
+
+	const uint8_t* data;			// 4 entries a byte, the first in the low bits; NULL if not available
+	const void* mapping;			// the file's mapping, NULL if 'data' is owned by someone else
+	size_t mapping_size;
+};
+
+struct Bitbases {
+	struct BitbaseTable tables[BITBASE_SET_COUNT];
+};
+
+// Sets up the layout of the set named 'name', returns false if it isn't a valid set
+bool bitbase_table_init(struct BitbaseTable* table, const char* name);
+
+/*
+ * Entry of the position with the pieces of the table on 'squares' (in the
+ * order of 'pieces') and 'side' to move, after the symmetries.
+ */
+uint64_t bitbase_index(const struct BitbaseTable* table, const int* squares, int side);
+
+// The position of entry 'index', false if the entry is another one's duplicate under a symmetry
+bool bitbase_decode(const struct BitbaseTable* table, uint64_t index, int* squares, int* side);
+
+static inline int bitbase_entry(const struct BitbaseTable* table, uint64_t index)
+{
+	return table->data[index / 4] >> (index % 4 * 2) & 3;
+}
+
+// Layouts of every set, without entries
+void bitbases_init(struct Bitbases* bitbases);
+
+// Maps '<directory>/<set>.bb' for every set, returns how many were found
+int bitbases_open(struct Bitbases* bitbases, const char* directory);
+void bitbases_close(struct Bitbases* bitbases);
+
+/*
+ * Result for the player to move: BITBASE_WIN, BITBASE_DRAW or BITBASE_LOSS,
+ * or BITBASE_NONE when no available table has the position. Bare kings and
+ * a single minor piece are draws without a table.
+ */
+int bitbase_probe(const struct Bitbases* bitbases, const struct Position* pos);
+
+// Outcome of the game if both sides play on perfectly, as a GAME_RESULT_* of gamefile.h, or GAME_RESULT_UNKNOWN
+int bitbase_result(const struct Bitbases* bitbases, const struct Position* pos);
+
+#endif
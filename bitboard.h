@@ -0,0 +1,133 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/*
+ * 64-bit boards, one bit per square.
+ *
+ * Squares are numbered 'y * 8 + x' with the same layout as the board drawn on
+ * screen: square 0 is the top left corner (a8) and square 63 the bottom right
+ * one (h1). Moving one row up the screen is a shift right by 8, one column to
+ * the right is a shift left by 1.
+ */
+
+#define SQUARE(x, y) ((y) * 8 + (x))
+#define SQUARE_X(sq) ((sq) & 7)
+#define SQUARE_Y(sq) ((sq) >> 3)
+
+#define BIT(sq) (1ULL << (sq))
+
+#define FILE_A 0x0101010101010101ULL
+#define FILE_B 0x0202020202020202ULL
+#define FILE_G 0x4040404040404040ULL
+#define FILE_H 0x8080808080808080ULL
+
+// Rows as seen on screen, ROW(0) is the top row (rank 8) and ROW(7) the bottom one (rank 1)
+#define ROW(y) (0xFFULL << (8 * (y)))
+
+static inline int popcount(uint64_t b)
+{
+	return __builtin_popcountll(b);
+}
+
+// Index of the least significant set bit, 'b' must not be empty
+static inline int lsb(uint64_t b)
+{
+	return __builtin_ctzll(b);
+}
+
+// Returns the least significant set bit and clears it from 'b'
+static inline int pop_lsb(uint64_t* b)
+{
+	int sq = __builtin_ctzll(*b);
+	*b &= *b - 1;
+	return sq;
+}
+
+// Squares attacked by a set of pawns, black pawns attack downwards and white pawns upwards
+static inline uint64_t pawn_attacks(uint64_t pawns, int color)
+{
+	if (color == 0) {
+		return ((pawns << 7) & ~FILE_H) | ((pawns << 9) & ~FILE_A);
+	}
+
+	return ((pawns >> 9) & ~FILE_H) | ((pawns >> 7) & ~FILE_A);
+}
+
+static inline uint64_t knight_attacks(uint64_t knights)
+{
+	uint64_t l1 = (knights >> 1) & ~FILE_H;
+	uint64_t l2 = (knights >> 2) & ~(FILE_G | FILE_H);
+	uint64_t r1 = (knights << 1) & ~FILE_A;
+	uint64_t r2 = (knights << 2) & ~(FILE_A | FILE_B);
+	uint64_t h1 = l1 | r1;
+	uint64_t h2 = l2 | r2;
+
+	return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+}
+
+static inline uint64_t king_attacks(uint64_t kings)
+{
+	uint64_t row = kings | ((kings >> 1) & ~FILE_H) | ((kings << 1) & ~FILE_A);
+
+	return (row | (row << 8) | (row >> 8)) & ~kings;
+}
+
+/*
+ * Slider attacks are looked up: the blockers on the squares the piece
+ * could reach are packed into an index into a table of attack sets built
+ * by gen_magic. Packing is a multiplication by a magic number that brings
+ * the blocker bits to the top of the product, or the PEXT instruction when
+ * the build targets BMI2 (-mbmi2 or -march=native on a processor that has it).
+ */
+struct Magic {
+	uint64_t mask;			// squares whose blockers matter, the edges are left out
+	uint64_t magic;
+	uint32_t offset;		// where the square's attack sets start in slider_attacks
+	uint32_t shift;			// 64 minus the number of bits in 'mask'
+};
+
+extern const struct Magic bishop_magics[64];
+extern const struct Magic rook_magics[64];
+extern const uint64_t slider_attacks[];
+
+static inline uint64_t magic_index(const struct Magic* m, uint64_t occupied)
+{
+#ifdef __BMI2__
+	return _pext_u64(occupied, m->mask);
+#else
+	return ((occupied & m->mask) * m->magic) >> m->shift;
+#endif
+}
+
+static inline uint64_t bishop_attacks(int sq, uint64_t occupied)
+{
+	const struct Magic* m = &bishop_magics[sq];
+
+	return slider_attacks[m->offset + magic_index(m, occupied)];
+}
+
+static inline uint64_t rook_attacks(int sq, uint64_t occupied)
+{
+	const struct Magic* m = &rook_magics[sq];
+
+	return slider_attacks[m->offset + magic_index(m, occupied)];
+}
+
+static inline uint64_t queen_attacks(int sq, uint64_t occupied)
+{
+	return bishop_attacks(sq, occupied) | rook_attacks(sq, occupied);
+}
+
+// "pext" or "magic", whichever this build uses
+const char* slider_attacks_method(void);
+
+// False when the build uses PEXT and the processor doesn't have it, programs should check it first
+bool slider_attacks_supported(void);
+
+#endif
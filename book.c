@@ -0,0 +1,219 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "book.h"
+#include "move.h"
+#include "movegen.h"
+
+/*
+ * Polyglot's Random64 numbers once gen_polyglot.c has written them from
+ * Polyglot's sources. Without them the book keys are the engine's own
+ * Zobrist keys: the tree still builds and mkbook's books still work with
+ * uci, but books made by other Polyglot tools find nothing.
+ */
+#if __has_include("polyglot_random.h")
+#include "polyglot_random.h"
+#define POLYGLOT_KEYS
+#endif
+
+// Where the other numbers start after the 64 squares of the 12 pieces
+#define POLYGLOT_CASTLING 768
+#define POLYGLOT_EN_PASSANT 772
+#define POLYGLOT_TURN 780
+
+static uint64_t read_big_endian(const uint8_t* data, int bytes)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < bytes; ++i) value = value << 8 | data[i];
+
+	return value;
+}
+
+static void write_big_endian(uint8_t* data, uint64_t value, int bytes)
+{
+	for (int i = bytes - 1; i >= 0; --i) {
+		data[i] = (uint8_t) value;
+		value >>= 8;
+	}
+}
+
+void book_entry_read(const uint8_t* data, struct BookEntry* entry)
+{
+	entry->key = read_big_endian(data, 8);
+	entry->move = (uint16_t) read_big_endian(data + 8, 2);
+	entry->weight = (uint16_t) read_big_endian(data + 10, 2);
+	entry->learn = (uint32_t) read_big_endian(data + 12, 4);
+}
+
+void book_entry_write(const struct BookEntry* entry, uint8_t* data)
+{
+	write_big_endian(data, entry->key, 8);
+	write_big_endian(data + 8, entry->move, 2);
+	write_big_endian(data + 10, entry->weight, 2);
+	write_big_endian(data + 12, entry->learn, 4);
+}
+
+uint64_t book_key(const struct Position* pos)
+{
+#ifdef POLYGLOT_KEYS
+	uint64_t key = 0;
+
+	// Black then white for each type of piece, and squares counted from a1
+	for (uint64_t pieces = pos->occupied; pieces != 0;) {
+		int sq = pop_lsb(&pieces);
+		int piece = pos->squares[sq];
+		key ^= polyglot_random[64 * (2 * PIECE_TYPE(piece) + PIECE_COLOR(piece)) + (sq ^ 56)];
+	}
+
+	// The CASTLE_* bits are in Polyglot's order
+	for (int i = 0; i < 4; ++i) {
+		if (pos->castling & (1 << i)) key ^= polyglot_random[POLYGLOT_CASTLING + i];
+	}
+
+	// Like Polyglot, the position only has an en passant square when a pawn can take there
+	if (pos->ep_square >= 0) key ^= polyglot_random[POLYGLOT_EN_PASSANT + SQUARE_X(pos->ep_square)];
+	if (pos->side == PLAYER_WHITE) key ^= polyglot_random[POLYGLOT_TURN];
+
+	return key;
+#else
+	return pos->key;
+#endif
+}
+
+bool book_polyglot_keys(void)
+{
+#ifdef POLYGLOT_KEYS
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool book_open(struct Book* book, const char* path)
+{
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) return false;
+	if (fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size % BOOK_ENTRY_SIZE != 0) {
+		close(fd);
+		return false;
+	}
+
+	void* mapping = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	// Each probe touches a few scattered pages, reading ahead would only load ones never used
+	posix_madvise(mapping, (size_t) st.st_size, POSIX_MADV_RANDOM);
+
+	book->data = mapping;
+	book->size = (size_t) st.st_size;
+	book->count = book->size / BOOK_ENTRY_SIZE;
+
+	return true;
+}
+
+void book_close(struct Book* book)
+{
+	munmap((void*) book->data, book->size);
+	book->data = NULL;
+	book->size = 0;
+	book->count = 0;
+}
+
+uint16_t book_move_to_polyglot(uint16_t m)
+{
+	int from = MOVE_FROM(m);
+	int to = MOVE_TO(m);
+	int flags = MOVE_FLAGS(m);
+
+	// The king goes to the rook's square, our squares count ranks from the 8th
+	if (flags == FLAG_KING_CASTLE) to += 1;
+	if (flags == FLAG_QUEEN_CASTLE) to -= 2;
+
+	int promotion = MOVE_IS_PROMOTION(m) ? MOVE_PROMOTION_TYPE(m) - KNIGHT + 1 : 0;
+
+	return (uint16_t) ((to ^ 56) | (from ^ 56) << 6 | promotion << 12);
+}
+
+// Index of the first entry whose key is not below 'key'
+static size_t lower_bound(const struct Book* book, uint64_t key)
+{
+	size_t low = 0;
+	size_t high = book->count;
+
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+		if (read_big_endian(book->data + middle * BOOK_ENTRY_SIZE, 8) < key) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+int book_probe(const struct Book* book, const struct Position* pos, uint16_t* moves, uint16_t* weights, int max)
+{
+	struct MoveList legal;
+	uint16_t polyglot[MAX_MOVES];
+	uint64_t key = book_key(pos);
+	int count = 0;
+
+	if (book->count == 0) return 0;
+
+	generate_legal_moves(pos, &legal);
+	for (int i = 0; i < legal.count; ++i) polyglot[i] = book_move_to_polyglot(legal.moves[i]);
+
+	for (size_t i = lower_bound(book, key); i < book->count && count < max; ++i) {
+		struct BookEntry entry;
+		book_entry_read(book->data + i * BOOK_ENTRY_SIZE, &entry);
+		if (entry.key != key) break;
+
+		for (int j = 0; j < legal.count; ++j) {
+			if (polyglot[j] != entry.move) continue;
+
+			// Insertion by weight, the book is only sorted by key
+			int k = count++;
+			for (; k > 0 && weights[k - 1] < entry.weight; --k) {
+				moves[k] = moves[k - 1];
+				weights[k] = weights[k - 1];
+			}
+			moves[k] = legal.moves[j];
+			weights[k] = entry.weight;
+			break;
+		}
+	}
+
+	return count;
+}
+
+uint16_t book_pick(const struct Book* book, const struct Position* pos, uint64_t* random_state)
+{
+	uint16_t moves[BOOK_MAX_MOVES];
+	uint16_t weights[BOOK_MAX_MOVES];
+	int count = book_probe(book, pos, moves, weights, BOOK_MAX_MOVES);
+	uint64_t total = 0;
+
+	for (int i = 0; i < count; ++i) total += weights[i];
+	if (total == 0) return MOVE_NONE;
+
+	// xorshift64*
+	*random_state ^= *random_state >> 12;
+	*random_state ^= *random_state << 25;
+	*random_state ^= *random_state >> 27;
+	uint64_t pick = (*random_state * 2685821657736338717ULL >> 11) % total;
+
+	for (int i = 0; i < count; ++i) {
+		if (pick < weights[i]) return moves[i];
+		pick -= weights[i];
+	}
+
+	return MOVE_NONE;
+}
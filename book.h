@@ -0,0 +1,75 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "position.h"
+
+/*
+ * Opening book in the Polyglot layout: 16-byte entries, big-endian,
+ * sorted by key, each a position's key, one of its moves and a weight.
+ * A move is the book's choice in proportion to its weight among the
+ * moves of its position.
+ *
+ * The keys are Polyglot's when its Random64 numbers are compiled in (see
+ * book_key), so books made by other Polyglot tools work as well as the
+ * ones mkbook builds.
+ */
+#define BOOK_ENTRY_SIZE 16
+
+// Most moves a position can have in the book
+#define BOOK_MAX_MOVES 64
+
+struct BookEntry {
+	uint64_t key;
+	uint16_t move;		// Polyglot encoding, see book_move_to_polyglot
+	uint16_t weight;
+	uint32_t learn;		// unused, 0
+};
+
+// A book mapped in memory
+struct Book {
+	const uint8_t* data;
+	size_t size;
+	size_t count;
+};
+
+/*
+ * Key of 'pos' in a book. With Polyglot's Random64 numbers (see
+ * gen_polyglot.c) it is Polyglot's key: the pieces, the castling rights,
+ * the side to move, and the en passant file only when a pawn can take
+ * there. Without them it is the engine's Zobrist key.
+ */
+uint64_t book_key(const struct Position* pos);
+
+// Whether book_key gives Polyglot's keys
+bool book_polyglot_keys(void);
+
+// Polyglot's key of the starting position, from the description of its book format
+#define BOOK_POLYGLOT_START_KEY 0x463B96181691FC9CULL
+
+bool book_open(struct Book* book, const char* path);
+void book_close(struct Book* book);
+
+/*
+ * Legal moves of 'pos' in the book, with their weights, best first.
+ * Entries whose move isn't legal in the position (a key collision or
+ * another engine's book) are left out. Returns how many there are.
+ */
+int book_probe(const struct Book* book, const struct Position* pos, uint16_t* moves, uint16_t* weights, int max);
+
+// A move of the book picked at random in proportion to the weights, or MOVE_NONE
+uint16_t book_pick(const struct Book* book, const struct Position* pos, uint64_t* random_state);
+
+/*
+ * Polyglot moves: the target file and rank in bits 0-5, the origin in
+ * bits 6-11 (rank 1 is 0), the promotion from knight = 1 to queen = 4 in
+ * bits 12-14. Castling is written as the king taking its own rook.
+ */
+uint16_t book_move_to_polyglot(uint16_t m);
+
+void book_entry_read(const uint8_t* data, struct BookEntry* entry);
+void book_entry_write(const struct BookEntry* entry, uint8_t* data);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CHESS_H
+#define CHESS_H
+
+/*
+ * Chess rules and engine library, everything except the window and the sounds.
+ * It doesn't depend on raylib and has no global state, but for the
+ * counters of a -DCHESS_STATS build (see stats.h).
+ *
+ * gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+ * gcc -O2 -c position.c movegen.c game.c zobrist.c tt.c search.c magic.c scheduler.c notation.c gamefile.c eval.c nnue.c session.c book.c bitbase.c stats.c mailbox.c engine.c
+ * ar rcs libchess.a position.o movegen.o game.o zobrist.o tt.o search.o magic.o scheduler.o notation.o gamefile.o eval.o nnue.o session.o book.o bitbase.o stats.o mailbox.o engine.o
+ *
+ * magic_tables.h is generated, not kept in the repository, and so are the
+ * optional polyglot_random.h (see gen_polyglot.c, book keys compatible
+ * with other Polyglot tools) and endgame bitbases (see gen_bitbase.c). Building with
+ * -mbmi2 or -march=native switches the slider lookups to PEXT, and
+ * -mavx2 or -march=native the network kernels to AVX2. The search
+ * threads, the scheduler and the engine thread need -pthread when linking.
+ */
+
+#include "bitboard.h"
+#include "position.h"
+#include "move.h"
+#include "movegen.h"
+#include "game.h"
+#include "zobrist.h"
+#include "tt.h"
+#include "eval.h"
+#include "nnue.h"
+#include "search.h"
+#include "scheduler.h"
+#include "notation.h"
+#include "gamefile.h"
+#include "session.h"
+#include "book.h"
+#include "bitbase.h"
+#include "stats.h"
+#include "mailbox.h"
+#include "engine.h"
+
+#endif
@@ -0,0 +1,193 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include "engine.h"
+
+// Requests waiting at once: the engine takes them all as soon as it wakes, only the last one counts
+#define REQUEST_CAPACITY 4
+
+// Reports waiting at once, far more iterations than a search ever completes between two frames
+#define REPORT_CAPACITY 256
+
+static int64_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool is_stale(struct Engine* engine)
+{
+	return atomic_load_explicit(&engine->generation, memory_order_acquire) != engine->current.generation;
+}
+
+static void fill_report(const struct Engine* engine, const struct SearchResult* result, bool final, struct EngineReport* report)
+{
+	memset(report, 0, sizeof(*report));
+	report->generation = engine->current.generation;
+	report->task = engine->current.task;
+	report->final = final;
+	report->best_move = result->best_move;
+	report->ponder_move = result->pv_length > 1 && result->pv[0] == result->best_move ? result->pv[1] : MOVE_NONE;
+	report->score = result->score;
+	report->depth = result->depth;
+	report->nodes = result->nodes;
+	report->nps = result->nps;
+}
+
+/*
+ * After every iteration, on the engine thread: stops a search that is no
+ * longer wanted, or that used half of its time since the ponder hit (the
+ * next iteration would take longer than the rest), and reports the others.
+ */
+static void on_iteration(const struct SearchResult* result, void* data)
+{
+	struct Engine* engine = data;
+
+	if (is_stale(engine)) {
+		search_pool_stop(&engine->pool);
+		return;
+	}
+
+	if (atomic_load_explicit(&engine->hit_generation, memory_order_acquire) == engine->current.generation) {
+		int64_t deadline = atomic_load_explicit(&engine->hit_deadline_ms, memory_order_relaxed);
+		int64_t budget = atomic_load_explicit(&engine->hit_budget_ms, memory_order_relaxed);
+		if (now_ms() >= deadline - budget / 2) search_pool_stop(&engine->pool);
+	}
+
+	// Dropped if the caller is behind, a later one will do
+	struct EngineReport report;
+	fill_report(engine, result, false, &report);
+	mailbox_send(&engine->reports, &report);
+}
+
+static void run_request(struct Engine* engine)
+{
+	struct SearchLimits limits = {0};
+	struct SearchResult result;
+	struct EngineReport report;
+
+	if (engine->current.task == ENGINE_PLAY) limits.time_ms = engine->current.time_ms;
+
+	search_pool_set_game(&engine->pool, &engine->current.game);
+	search_pool_run(&engine->pool, &limits, &result);
+
+	// The final report can't be dropped, the caller may be waiting for its move
+	fill_report(engine, &result, true, &report);
+	while (!mailbox_send(&engine->reports, &report) && !is_stale(engine)) {
+		nanosleep(&(struct timespec) {0, 1000000}, NULL);
+	}
+}
+
+static void* engine_main(void* data)
+{
+	struct Engine* engine = data;
+
+	for (;;) {
+		if (sem_wait(&engine->wakeup) != 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+
+		// Several requests may have come during the last search, only the newest one is still wanted
+		bool received = false;
+		while (mailbox_receive(&engine->requests, &engine->current)) received = true;
+		if (!received) continue;
+
+		if (engine->current.task == ENGINE_QUIT) break;
+		if (engine->current.task == ENGINE_IDLE || is_stale(engine)) continue;
+
+		run_request(engine);
+	}
+
+	return NULL;
+}
+
+bool engine_init(struct Engine* engine, size_t hash_mb, int threads)
+{
+	memset(engine, 0, sizeof(*engine));
+	atomic_init(&engine->generation, 0);
+	atomic_init(&engine->hit_generation, 0);
+	atomic_init(&engine->hit_deadline_ms, 0);
+	atomic_init(&engine->hit_budget_ms, 0);
+
+	if (!tt_init(&engine->tt, hash_mb)) return false;
+	if (!search_pool_init(&engine->pool, threads, &engine->tt)) {
+		tt_free(&engine->tt);
+		return false;
+	}
+	engine->pool.searches[0].on_iteration = on_iteration;
+	engine->pool.searches[0].callback_data = engine;
+
+	bool ok = mailbox_init(&engine->requests, REQUEST_CAPACITY, sizeof(struct EngineRequest));
+	ok = mailbox_init(&engine->reports, REPORT_CAPACITY, sizeof(struct EngineReport)) && ok;
+	ok = ok && sem_init(&engine->wakeup, 0, 0) == 0;
+	if (ok && pthread_create(&engine->thread, NULL, engine_main, engine) != 0) {
+		sem_destroy(&engine->wakeup);
+		ok = false;
+	}
+
+	if (!ok) {
+		mailbox_free(&engine->requests);
+		mailbox_free(&engine->reports);
+		search_pool_free(&engine->pool);
+		tt_free(&engine->tt);
+	}
+
+	return ok;
+}
+
+void engine_free(struct Engine* engine)
+{
+	// The engine takes every request as soon as the search stops, there is room again right away
+	while (engine_start(engine, &engine->outgoing.game, ENGINE_QUIT, 0) == 0) {
+		nanosleep(&(struct timespec) {0, 1000000}, NULL);
+	}
+	pthread_join(engine->thread, NULL);
+
+	sem_destroy(&engine->wakeup);
+	mailbox_free(&engine->requests);
+	mailbox_free(&engine->reports);
+	search_pool_free(&engine->pool);
+	tt_free(&engine->tt);
+}
+
+uint64_t engine_start(struct Engine* engine, const struct Game* game, int task, int64_t time_ms)
+{
+	uint64_t generation = atomic_load_explicit(&engine->generation, memory_order_relaxed) + 1;
+
+	engine->outgoing.generation = generation;
+	engine->outgoing.task = task;
+	engine->outgoing.time_ms = time_ms;
+	if (game != &engine->outgoing.game) engine->outgoing.game = *game;
+
+	// The new generation goes first, so the engine never takes the request for a stale one
+	atomic_store_explicit(&engine->generation, generation, memory_order_release);
+	search_pool_stop(&engine->pool);
+	if (!mailbox_send(&engine->requests, &engine->outgoing)) return 0;
+
+	sem_post(&engine->wakeup);
+	return generation;
+}
+
+void engine_ponder_hit(struct Engine* engine, uint64_t generation, int64_t time_ms)
+{
+	atomic_store_explicit(&engine->hit_budget_ms, time_ms, memory_order_relaxed);
+	atomic_store_explicit(&engine->hit_deadline_ms, now_ms() + time_ms, memory_order_relaxed);
+	atomic_store_explicit(&engine->hit_generation, generation, memory_order_release);
+}
+
+bool engine_poll(struct Engine* engine, struct EngineReport* report)
+{
+	// The search only looks at the deadline between iterations, a long one is cut here
+	uint64_t generation = atomic_load_explicit(&engine->generation, memory_order_relaxed);
+	if (atomic_load_explicit(&engine->hit_generation, memory_order_acquire) == generation
+		&& now_ms() >= atomic_load_explicit(&engine->hit_deadline_ms, memory_order_relaxed)) {
+		search_pool_stop(&engine->pool);
+	}
+
+	return mailbox_receive(&engine->reports, report);
+}
@@ -0,0 +1,100 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "game.h"
+#include "tt.h"
+#include "search.h"
+#include "mailbox.h"
+
+/*
+ * A search pool driven from a thread that must never wait for it, like
+ * the window's frame loop. The caller sends the game and what to do with
+ * it, and collects reports on the next frames; neither call blocks.
+ *
+ * Requests and reports travel through two mailboxes (see mailbox.h), one
+ * each way. A request stops the search in progress: every request gets a
+ * generation, and a search whose generation is no longer the latest one
+ * stops at its next iteration, even if it only started after the stop.
+ * Reports carry the generation of their search, so old ones can be told
+ * apart and dropped.
+ *
+ * Every function is for the caller's thread, the engine runs on its own.
+ */
+
+enum EngineTask {
+	ENGINE_IDLE,		// stop searching
+	ENGINE_ANALYZE,		// search until the next request, reporting every iteration
+	ENGINE_PLAY,		// search for 'time_ms' then report the move to play
+	ENGINE_PONDER,		// search the position expected after the opponent's reply until the next request or engine_ponder_hit
+	ENGINE_QUIT
+};
+
+struct EngineRequest {
+	uint64_t generation;
+	int task;					// ENGINE_*
+	int64_t time_ms;			// ENGINE_PLAY only
+	struct Game game;
+};
+
+// Sent after every iteration and once more, with 'final' set, when the search ends
+struct EngineReport {
+	uint64_t generation;
+	int task;
+	bool final;
+	uint16_t best_move;			// MOVE_NONE if the position has no legal move
+	uint16_t ponder_move;		// expected reply, MOVE_NONE if unknown
+	int score;					// for the player to move in the searched position
+	int depth;
+	uint64_t nodes;
+	uint64_t nps;
+};
+
+struct Engine {
+	struct TranspositionTable tt;
+	struct SearchPool pool;
+	pthread_t thread;
+	sem_t wakeup;				// posted with every request
+
+	struct Mailbox requests;	// from the caller to the engine
+	struct Mailbox reports;		// from the engine to the caller
+	_Atomic uint64_t generation;	// of the latest request
+
+	// Set by engine_ponder_hit: the ponder search of 'hit_generation' plays its move by the deadline
+	_Atomic uint64_t hit_generation;
+	_Atomic int64_t hit_deadline_ms;
+	_Atomic int64_t hit_budget_ms;
+
+	struct EngineRequest outgoing;	// the caller's copy of the request being sent
+	struct EngineRequest current;	// the engine's copy of the request being searched
+};
+
+// Starts the engine thread with its own hash table and search threads
+bool engine_init(struct Engine* engine, size_t hash_mb, int threads);
+
+// Stops the search, ends the thread and frees everything
+void engine_free(struct Engine* engine);
+
+/*
+ * Stops what the engine is doing and starts 'task' on 'game'. Returns the
+ * generation of the new search, or 0 if the request couldn't be sent, in
+ * which case the caller should try again on a later frame.
+ */
+uint64_t engine_start(struct Engine* engine, const struct Game* game, int task, int64_t time_ms);
+
+/*
+ * The opponent played the expected move: the ponder search of 'generation'
+ * goes on for at most 'time_ms' more and ends with a final report, like
+ * an ENGINE_PLAY search. A search that already ended sent its final
+ * report before.
+ */
+void engine_ponder_hit(struct Engine* engine, uint64_t generation, int64_t time_ms);
+
+// Takes the oldest report not taken yet, false if there is none. Call it every frame: it also keeps the ponder deadline.
+bool engine_poll(struct Engine* engine, struct EngineReport* report);
+
+#endif
@@ -0,0 +1,320 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o epd epd.c position.c movegen.c game.c zobrist.c tt.c search.c magic.c notation.c eval.c nnue.c bitbase.c stats.c
+// ./epd perftsuite.epd                         perft of every line to the depths it lists (;D1 20 ;D2 400 ...)
+// ./epd -depth 4 perftsuite.epd                same, stopping at depth 4
+// ./epd -search -movetime 500 wac.epd          searches every line and checks its bm or am moves
+// zcat suite.epd.gz | ./epd -search -depth 8 - reads the standard input
+
+/*
+ * Runs a test suite in Extended Position Description format: each line
+ * is the first four fields of a FEN followed by operations such as
+ * 'bm Nf3;' (best move), 'am e4;' (move to avoid), 'id "name";' or the
+ * 'D5 4865609;' perft counts. Every line prints its result and time.
+ *
+ * Lines are read one at a time into a fixed buffer, so a suite of any
+ * size runs in the same memory and its results start coming right away.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include "chess.h"
+
+// Longest line read, longer ones are reported and skipped
+#define EPD_LINE_MAX 4096
+#define EPD_MAX_DEPTH 16
+
+// What one line asks for
+struct EpdLine {
+	struct Position pos;
+	char id[64];
+	char best_moves[256];			// 'bm' operand, SAN moves separated by spaces
+	char avoid_moves[256];			// 'am' operand
+	uint64_t perft[EPD_MAX_DEPTH + 1];	// expected count at each depth, 0 when not given
+	int perft_depth;				// deepest count given
+};
+
+struct EpdTotals {
+	uint64_t lines;
+	uint64_t failures;
+	uint64_t errors;
+	uint64_t nodes;
+	double seconds;
+};
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Copies the operand without the surrounding spaces and quotes
+static void copy_operand(char* dst, size_t size, const char* src)
+{
+	while (*src == ' ' || *src == '"') ++src;
+
+	size_t length = strlen(src);
+	while (length > 0 && (src[length - 1] == ' ' || src[length - 1] == '"' || src[length - 1] == '\r')) --length;
+	if (length >= size) length = size - 1;
+
+	memcpy(dst, src, length);
+	dst[length] = '\0';
+}
+
+// Reads one operation, 'op' is the text between two semicolons
+static void parse_operation(struct EpdLine* epd, char* op)
+{
+	while (*op == ' ' || *op == '\t') ++op;
+
+	char* operand = op;
+	while (*operand && *operand != ' ') ++operand;
+	if (*operand) *operand++ = '\0';
+
+	if (op[0] == 'D' && isdigit((unsigned char) op[1])) {
+		int depth = atoi(op + 1);
+		if (depth < 1 || depth > EPD_MAX_DEPTH) return;
+
+		epd->perft[depth] = strtoull(operand, NULL, 10);
+		if (depth > epd->perft_depth) epd->perft_depth = depth;
+	} else if (strcmp(op, "id") == 0) {
+		copy_operand(epd->id, sizeof(epd->id), operand);
+	} else if (strcmp(op, "bm") == 0) {
+		copy_operand(epd->best_moves, sizeof(epd->best_moves), operand);
+	} else if (strcmp(op, "am") == 0) {
+		copy_operand(epd->avoid_moves, sizeof(epd->avoid_moves), operand);
+	} else if (strcmp(op, "hmvc") == 0) {
+		epd->pos.halfmove_clock = atoi(operand);
+	} else if (strcmp(op, "fmvn") == 0) {
+		epd->pos.fullmove = atoi(operand);
+	}
+}
+
+// Splits the line into the position and its operations, returns false if the position can't be read
+static bool parse_line(struct EpdLine* epd, char* line)
+{
+	char* c = line;
+
+	memset(epd, 0, sizeof(*epd));
+
+	// The position is the first four fields
+	for (int field = 0; field < 4; ++field) {
+		while (*c == ' ') ++c;
+		while (*c && *c != ' ' && *c != ';' && *c != '\n') ++c;
+	}
+
+	char saved = *c;
+	*c = '\0';
+	bool ok = position_from_fen(&epd->pos, line);
+	*c = saved;
+	if (!ok) return false;
+
+	while (*c) {
+		char* end = c;
+		while (*end && *end != ';' && *end != '\n') ++end;
+
+		bool last = *end != ';';
+		*end = '\0';
+		parse_operation(epd, c);
+		if (last) break;
+		c = end + 1;
+	}
+
+	return true;
+}
+
+// True when 'san' is one of the moves listed in 'moves', check marks and annotations aside
+static bool san_in_list(const char* san, const char* moves)
+{
+	size_t length = strcspn(san, "+#");
+
+	while (*moves) {
+		while (*moves == ' ') ++moves;
+		size_t token = strcspn(moves, " ");
+		size_t bare = strcspn(moves, "+#!? ");
+		if (bare > token) bare = token;
+
+		if (bare == length && strncmp(san, moves, length) == 0) return true;
+		moves += token;
+	}
+
+	return false;
+}
+
+static void run_perft(struct EpdLine* epd, int max_depth, struct EpdTotals* totals)
+{
+	int depth_limit = epd->perft_depth > 0 ? epd->perft_depth : max_depth;
+	if (max_depth > 0 && max_depth < depth_limit) depth_limit = max_depth;
+	bool failed = false;
+
+	if (depth_limit == 0) {
+		printf(" no perft count to check, use -depth");
+		return;
+	}
+
+	for (int depth = 1; depth <= depth_limit; ++depth) {
+		if (epd->perft_depth > 0 && epd->perft[depth] == 0) continue;
+
+		uint64_t nodes = perft(&epd->pos, depth);
+		totals->nodes += nodes;
+
+		printf(" D%d %" PRIu64, depth, nodes);
+		if (epd->perft[depth] != 0 && nodes != epd->perft[depth]) {
+			printf(" FAILED (expected %" PRIu64 ")", epd->perft[depth]);
+			failed = true;
+			break;
+		}
+	}
+
+	if (failed) ++totals->failures;
+	else if (epd->perft_depth > 0) printf(" ok");
+}
+
+static void run_search(struct EpdLine* epd, struct SearchPool* pool, const struct SearchLimits* limits, struct EpdTotals* totals)
+{
+	static struct Game game;
+	struct SearchResult result;
+	char san[SAN_MAX_LENGTH];
+
+	game_init(&game, &epd->pos);
+	search_pool_set_game(pool, &game);
+	uint16_t best = search_pool_run(pool, limits, &result);
+	totals->nodes += result.nodes;
+
+	if (best == MOVE_NONE) {
+		printf(" no legal move");
+		return;
+	}
+
+	move_to_san(&epd->pos, best, san);
+	printf(" %s", san);
+	if (result.score >= SCORE_MATE_BOUND) printf(" mate %d", (SCORE_MATE - result.score + 1) / 2);
+	else if (result.score <= -SCORE_MATE_BOUND) printf(" mate %d", -(SCORE_MATE + result.score) / 2);
+	else printf(" cp %d", result.score);
+	printf(" depth %d nodes %" PRIu64, result.depth, result.nodes);
+
+	bool failed = (epd->best_moves[0] && !san_in_list(san, epd->best_moves))
+		|| (epd->avoid_moves[0] && san_in_list(san, epd->avoid_moves));
+
+	if (epd->best_moves[0]) printf(" bm %s", epd->best_moves);
+	if (epd->avoid_moves[0]) printf(" am %s", epd->avoid_moves);
+	if (epd->best_moves[0] || epd->avoid_moves[0]) printf(failed ? " FAILED" : " ok");
+	if (failed) ++totals->failures;
+}
+
+int main(int argc, char* argv[])
+{
+	struct SearchLimits limits = {0};
+	const char* path = NULL;
+	bool search = false;
+	int threads = 1;
+	size_t hash_mb = 16;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-search") == 0) {
+			search = true;
+		} else if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc) {
+			limits.depth = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-nodes") == 0 && i + 1 < argc) {
+			limits.nodes = strtoull(argv[++i], NULL, 10);
+		} else if (strcmp(argv[i], "-movetime") == 0 && i + 1 < argc) {
+			limits.time_ms = atoll(argv[++i]);
+		} else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc) {
+			hash_mb = (size_t) atoi(argv[++i]);
+		} else if (path == NULL && (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)) {
+			path = argv[i];
+		} else {
+			path = NULL;
+			break;
+		}
+	}
+
+	if (path == NULL) {
+		fprintf(stderr, "Usage: %s [-search] [-depth n] [-nodes n] [-movetime ms] [-threads n] [-hash mb] <file.epd | ->\n", argv[0]);
+		return 1;
+	}
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Can't open %s\n", path);
+		return 1;
+	}
+
+	struct TranspositionTable tt;
+	struct SearchPool pool;
+	if (search) {
+		if (limits.depth == 0 && limits.nodes == 0 && limits.time_ms == 0) limits.time_ms = 1000;
+		if (!tt_init(&tt, hash_mb) || !search_pool_init(&pool, threads < 1 ? 1 : threads, &tt)) {
+			fprintf(stderr, "Can't start the search\n");
+			return 1;
+		}
+	}
+
+	static char line[EPD_LINE_MAX];
+	static struct EpdLine epd;
+	struct EpdTotals totals = {0};
+	uint64_t line_number = 0;
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		++line_number;
+
+		// A line that doesn't fit is skipped up to its end
+		if (strchr(line, '\n') == NULL && !feof(file)) {
+			int c;
+			while ((c = fgetc(file)) != EOF && c != '\n') {}
+			printf("%" PRIu64 ": line too long\n", line_number);
+			++totals.errors;
+			continue;
+		}
+
+		// Blank lines and comments
+		char* start = line;
+		while (*start == ' ' || *start == '\t') ++start;
+		if (*start == '\n' || *start == '\r' || *start == '\0' || *start == '#') continue;
+
+		if (!parse_line(&epd, start)) {
+			printf("%" PRIu64 ": invalid position\n", line_number);
+			++totals.errors;
+			continue;
+		}
+
+		printf("%" PRIu64 ":", line_number);
+		if (epd.id[0]) printf(" \"%s\"", epd.id);
+
+		double begin = now_seconds();
+		if (search) run_search(&epd, &pool, &limits, &totals);
+		else run_perft(&epd, limits.depth, &totals);
+		double seconds = now_seconds() - begin;
+
+		printf(" %.3f s\n", seconds);
+		fflush(stdout);
+
+		++totals.lines;
+		totals.seconds += seconds;
+	}
+
+	if (file != stdin) fclose(file);
+	if (search) {
+		search_pool_free(&pool);
+		tt_free(&tt);
+	}
+
+	printf("%" PRIu64 " positions, %" PRIu64 " failed, %" PRIu64 " unreadable, %" PRIu64 " nodes in %.3f s\n",
+		totals.lines, totals.failures, totals.errors, totals.nodes, totals.seconds);
+
+	return totals.failures > 0 || totals.errors > 0 ? 1 : 0;
+}
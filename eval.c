@@ -0,0 +1,164 @@
+#include "eval.h"
+
+// Each row is a rank, from the 8th down to the 1st
+const int8_t pst_mg[6][64] = {
+	{	// pawn: hold the center, keep the pawns in front of the castled king
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		 50,  50,  50,  50,  50,  50,  50,  50,
+		 10,  10,  20,  30,  30,  20,  10,  10,
+		  5,   5,  10,  25,  25,  10,   5,   5,
+		  0,   0,   0,  20,  20,   0,   0,   0,
+		  5,  -5, -10,   0,   0, -10,  -5,   5,
+		  5,  10,  10, -20, -20,  10,  10,   5,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+	},
+	{	// knight: worth little on the rim
+		-50, -40, -30, -30, -30, -30, -40, -50,
+		-40, -20,   0,   0,   0,   0, -20, -40,
+		-30,   0,  10,  15,  15,  10,   0, -30,
+		-30,   5,  15,  20,  20,  15,   5, -30,
+		-30,   0,  15,  20,  20,  15,   0, -30,
+		-30,   5,  10,  15,  15,  10,   5, -30,
+		-40, -20,   0,   5,   5,   0, -20, -40,
+		-50, -40, -30, -30, -30, -30, -40, -50,
+	},
+	{	// bishop: long diagonals, away from the corners
+		-20, -10, -10, -10, -10, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,  10,  10,   5,   0, -10,
+		-10,   5,   5,  10,  10,   5,   5, -10,
+		-10,   0,  10,  10,  10,  10,   0, -10,
+		-10,  10,  10,  10,  10,  10,  10, -10,
+		-10,   5,   0,   0,   0,   0,   5, -10,
+		-20, -10, -10, -10, -10, -10, -10, -20,
+	},
+	{	// rook: the 7th rank, and the center files after castling
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  5,  10,  10,  10,  10,  10,  10,   5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		 -5,   0,   0,   0,   0,   0,   0,  -5,
+		  0,   0,   0,   5,   5,   0,   0,   0,
+	},
+	{	// queen
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,   5,   5,   5,   0, -10,
+		 -5,   0,   5,   5,   5,   5,   0,  -5,
+		  0,   0,   5,   5,   5,   5,   0,  -5,
+		-10,   5,   5,   5,   5,   5,   0, -10,
+		-10,   0,   5,   0,   0,   0,   0, -10,
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+	},
+	{	// king: stay behind the pawns while the queens are on
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-30, -40, -40, -50, -50, -40, -40, -30,
+		-20, -30, -30, -40, -40, -30, -30, -20,
+		-10, -20, -20, -20, -20, -20, -20, -10,
+		 20,  20,   0,   0,   0,   0,  20,  20,
+		 20,  30,  10,   0,   0,  10,  30,  20,
+	},
+};
+
+const int8_t pst_eg[6][64] = {
+	{	// pawn: the closer to promotion the better
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		 80,  80,  80,  80,  80,  80,  80,  80,
+		 50,  50,  50,  50,  50,  50,  50,  50,
+		 30,  30,  30,  30,  30,  30,  30,  30,
+		 15,  15,  15,  15,  15,  15,  15,  15,
+		  5,   5,   5,   5,   5,   5,   5,   5,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+	},
+	{	// knight
+		-50, -40, -30, -30, -30, -30, -40, -50,
+		-40, -20,   0,   0,   0,   0, -20, -40,
+		-30,   0,  10,  15,  15,  10,   0, -30,
+		-30,   5,  15,  20,  20,  15,   5, -30,
+		-30,   0,  15,  20,  20,  15,   0, -30,
+		-30,   5,  10,  15,  15,  10,   5, -30,
+		-40, -20,   0,   5,   5,   0, -20, -40,
+		-50, -40, -30, -30, -30, -30, -40, -50,
+	},
+	{	// bishop
+		-20, -10, -10, -10, -10, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,  10,  10,   5,   0, -10,
+		-10,   5,   5,  10,  10,   5,   5, -10,
+		-10,   0,  10,  10,  10,  10,   0, -10,
+		-10,  10,  10,  10,  10,  10,  10, -10,
+		-10,   5,   0,   0,   0,   0,   5, -10,
+		-20, -10, -10, -10, -10, -10, -10, -20,
+	},
+	{	// rook: the 7th rank still counts
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		 10,  10,  10,  10,  10,  10,  10,  10,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+		  0,   0,   0,   0,   0,   0,   0,   0,
+	},
+	{	// queen
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-10,   0,   5,   5,   5,   5,   0, -10,
+		 -5,   0,   5,   5,   5,   5,   0,  -5,
+		 -5,   0,   5,   5,   5,   5,   0,  -5,
+		-10,   0,   5,   5,   5,   5,   0, -10,
+		-10,   0,   0,   0,   0,   0,   0, -10,
+		-20, -10, -10,  -5,  -5, -10, -10, -20,
+	},
+	{	// king: come to the center once it is safe
+		-50, -40, -30, -20, -20, -30, -40, -50,
+		-30, -20, -10,   0,   0, -10, -20, -30,
+		-30, -10,  20,  30,  30,  20, -10, -30,
+		-30, -10,  30,  40,  40,  30, -10, -30,
+		-30, -10,  30,  40,  40,  30, -10, -30,
+		-30, -10,  20,  30,  30,  20, -10, -30,
+		-30, -30,   0,   0,   0,   0, -30, -30,
+		-50, -30, -30, -30, -30, -30, -30, -50,
+	},
+};
+
+const int piece_values_eg[6] = {120, 300, 320, 520, 950, 0};
+
+const int phase_weights[6] = {0, 1, 1, 2, 4, 0};
+
+static int blend(int mg, int eg, int phase, int side)
+{
+	if (phase > PHASE_MAX) phase = PHASE_MAX;
+
+	int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
+
+	return side == PLAYER_WHITE ? score : -score;
+}
+
+int evaluate(const struct Position* pos)
+{
+	return blend(pos->score_mg, pos->score_eg, pos->phase, pos->side);
+}
+
+int evaluate_full(const struct Position* pos)
+{
+	int mg = 0;
+	int eg = 0;
+	int phase = 0;
+
+	for (int sq = 0; sq < 64; ++sq) {
+		int piece = pos->squares[sq];
+		if (piece == EMPTY) continue;
+
+		mg += pst_score_mg(piece, sq);
+		eg += pst_score_eg(piece, sq);
+		phase += phase_weights[PIECE_TYPE(piece)];
+	}
+
+	return blend(mg, eg, phase, pos->side);
+}
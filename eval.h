@@ -0,0 +1,52 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include <stdint.h>
+#include "position.h"
+
+// Sum of the phase weights of the pieces at the start, where the middlegame scores count in full
+#define PHASE_MAX 24
+
+/*
+ * Piece-square bonuses, from White's point of view with a8 first; Black
+ * reads them upside down. The position keeps the sum of the piece values
+ * and bonuses of its pieces for the middlegame and the endgame, updated as
+ * pieces are put, removed and moved, so evaluating never scans the board.
+ */
+extern const int8_t pst_mg[6][64];
+extern const int8_t pst_eg[6][64];
+
+// Piece values once most pieces are gone, piece_values being the middlegame ones
+extern const int piece_values_eg[6];
+
+// How much each piece type weighs towards the middlegame
+extern const int phase_weights[6];
+
+// Square of 'sq' in the tables for a piece of 'color'
+#define PST_SQUARE(color, sq) ((color) == PLAYER_WHITE ? (sq) : (sq) ^ 56)
+
+// Value and bonus of 'piece' on 'sq', positive for White
+static inline int pst_score_mg(int piece, int sq)
+{
+	int score = piece_values[PIECE_TYPE(piece)] + pst_mg[PIECE_TYPE(piece)][PST_SQUARE(PIECE_COLOR(piece), sq)];
+
+	return PIECE_COLOR(piece) == PLAYER_WHITE ? score : -score;
+}
+
+static inline int pst_score_eg(int piece, int sq)
+{
+	int score = piece_values_eg[PIECE_TYPE(piece)] + pst_eg[PIECE_TYPE(piece)][PST_SQUARE(PIECE_COLOR(piece), sq)];
+
+	return PIECE_COLOR(piece) == PLAYER_WHITE ? score : -score;
+}
+
+/*
+ * Blend of the middlegame and endgame scores, weighted by the phase, from
+ * the point of view of the player to move.
+ */
+int evaluate(const struct Position* pos);
+
+// Same as evaluate, summed again over every square, to check the incremental scores
+int evaluate_full(const struct Position* pos);
+
+#endif
@@ -0,0 +1,94 @@
+#include "game.h"
+
+/*
+ * Number of earlier times the current position came up. Only positions
+ * since the last capture or pawn move can repeat, and only with the same
+ * player to move, so every other key is skipped. The key before each move
+ * is in its undo record.
+ */
+static int game_repetitions(const struct Game* game)
+{
+	int count = 0;
+	int limit = game->pos.halfmove_clock < game->ply ? game->pos.halfmove_clock : game->ply;
+
+	for (int back = 4; back <= limit; back += 2) {
+		if (game->undo[game->ply - back].key == game->pos.key) ++count;
+	}
+
+	return count;
+}
+
+// Generates the legal moves and looks for check, checkmate and stalemate, once for every new position
+static void game_update(struct Game* game)
+{
+	generate_legal_moves(&game->pos, &game->legal_moves);
+	game->checkers = position_checkers(&game->pos);
+
+	if (game->legal_moves.count > 0) {
+		game->status = game_repetitions(game) >= 2 ? STATUS_DRAW_REPETITION : STATUS_PLAYING;
+	} else {
+		game->status = game->checkers ? STATUS_CHECKMATE : STATUS_STALEMATE;
+	}
+}
+
+void game_init(struct Game* game, const struct Position* pos)
+{
+	game->pos = *pos;
+	game->last_move = MOVE_NONE;
+	game->ply = 0;
+	game_update(game);
+}
+
+bool game_init_fen(struct Game* game, const char* fen)
+{
+	struct Position pos;
+	if (!position_from_fen(&pos, fen)) return false;
+
+	game_init(game, &pos);
+	return true;
+}
+
+bool game_play(struct Game* game, uint16_t m)
+{
+	if (game->status != STATUS_PLAYING || !movelist_contains(&game->legal_moves, m)) return false;
+	if (game->ply == MAX_GAME_PLIES) return false;
+
+	make_move(&game->pos, m, &game->undo[game->ply]);
+	game->moves[game->ply++] = m;
+	game->last_move = m;
+	game_update(game);
+
+	return true;
+}
+
+bool game_undo(struct Game* game)
+{
+	if (game->ply == 0) return false;
+
+	--game->ply;
+	unmake_move(&game->pos, game->moves[game->ply], &game->undo[game->ply]);
+	game->last_move = game->ply > 0 ? game->moves[game->ply - 1] : MOVE_NONE;
+	game_update(game);
+
+	return true;
+}
+
+void game_moves_from(const struct Game* game, int from, struct MoveList* list)
+{
+	movelist_clear(list);
+
+	for (int i = 0; i < game->legal_moves.count; ++i) {
+		if (MOVE_FROM(game->legal_moves.moves[i]) == from) movelist_add(list, game->legal_moves.moves[i]);
+	}
+}
+
+uint16_t game_find_move(const struct Game* game, int from, int to)
+{
+	// Promotions are generated queen first
+	for (int i = 0; i < game->legal_moves.count; ++i) {
+		uint16_t m = game->legal_moves.moves[i];
+		if (MOVE_FROM(m) == from && MOVE_TO(m) == to) return m;
+	}
+
+	return MOVE_NONE;
+}
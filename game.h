@@ -0,0 +1,44 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "position.h"
+#include "move.h"
+#include "movegen.h"
+
+// Longest game that can be played, in moves of either player
+#define MAX_GAME_PLIES 1024
+
+/*
+ * A game in progress: the position plus what the rules derive from it.
+ * Everything lives in the struct, so any number of games can be played
+ * at once from any number of threads, one thread per game at a time.
+ */
+struct Game {
+	struct Position pos;
+	struct MoveList legal_moves;	// every legal move of the player to move
+	uint64_t checkers;				// pieces giving check to the player to move
+	int status;						// STATUS_PLAYING until a checkmate or stalemate
+	uint16_t last_move;				// MOVE_NONE before the first move
+	int ply;						// moves played since game_init
+	uint16_t moves[MAX_GAME_PLIES];	// every move played, to take them back
+	struct Undo undo[MAX_GAME_PLIES];
+};
+
+void game_init(struct Game* game, const struct Position* pos);
+bool game_init_fen(struct Game* game, const char* fen);
+
+// Plays 'm' if it is one of the legal moves, returns false otherwise
+bool game_play(struct Game* game, uint16_t m);
+
+// Takes back the last move, returns false at the start of the game
+bool game_undo(struct Game* game);
+
+// Legal moves of the piece on 'from'
+void game_moves_from(const struct Game* game, int from, struct MoveList* list);
+
+// Legal move going from 'from' to 'to', promoting to a queen if it is a promotion, or MOVE_NONE
+uint16_t game_find_move(const struct Game* game, int from, int to);
+
+#endif
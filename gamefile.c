@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "gamefile.h"
+#include "movegen.h"
+
+// Bytes taken by a record, padding included
+static size_t record_size(const struct GameRecordHeader* header)
+{
+	size_t size = sizeof(*header) + ((header->fen_length + 1u) & ~1u) + 2 * (size_t) header->ply_count;
+
+	return (size + 3) & ~(size_t) 3;
+}
+
+void game_buffer_init(struct GameBuffer* buffer)
+{
+	buffer->data = NULL;
+	buffer->size = 0;
+	buffer->capacity = 0;
+	buffer->count = 0;
+}
+
+void game_buffer_free(struct GameBuffer* buffer)
+{
+	free(buffer->data);
+	game_buffer_init(buffer);
+}
+
+void game_buffer_clear(struct GameBuffer* buffer)
+{
+	buffer->size = 0;
+	buffer->count = 0;
+}
+
+bool game_buffer_add(struct GameBuffer* buffer, const struct Position* start, const uint16_t* moves, uint32_t ply_count, int result)
+{
+	char fen[FEN_MAX_LENGTH];
+	struct GameRecordHeader header = {ply_count, (uint8_t) result, 0, 0};
+
+	if (start != NULL) {
+		position_to_fen(start, fen);
+		header.fen_length = (uint8_t) strlen(fen);
+	}
+
+	size_t size = record_size(&header);
+	if (buffer->size + size > buffer->capacity) {
+		size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+		while (capacity < buffer->size + size) capacity *= 2;
+
+		uint8_t* data = realloc(buffer->data, capacity);
+		if (data == NULL) return false;
+		STATS_ALLOCATION(capacity);
+
+		buffer->data = data;
+		buffer->capacity = capacity;
+	}
+
+	// Padding is zeroed so the same games always give the same bytes
+	uint8_t* record = buffer->data + buffer->size;
+	memset(record, 0, size);
+	memcpy(record, &header, sizeof(header));
+	memcpy(record + sizeof(header), fen, header.fen_length);
+	memcpy(record + sizeof(header) + ((header.fen_length + 1u) & ~1u), moves, 2 * (size_t) ply_count);
+
+	buffer->size += size;
+	++buffer->count;
+
+	return true;
+}
+
+bool game_writer_open(struct GameWriter* writer, const char* path)
+{
+	struct GameFileHeader header = {0};
+
+	writer->file = fopen(path, "wb");
+	if (writer->file == NULL) return false;
+
+	// The header is written again at the end, once the counts are known
+	writer->offset = sizeof(header);
+	writer->index = NULL;
+	writer->count = 0;
+	writer->capacity = 0;
+	writer->failed = fwrite(&header, sizeof(header), 1, writer->file) != 1;
+
+	return true;
+}
+
+bool game_writer_add(struct GameWriter* writer, const struct GameBuffer* buffer)
+{
+	if (writer->count + buffer->count > writer->capacity) {
+		uint64_t capacity = writer->capacity ? writer->capacity : 1024;
+		while (capacity < writer->count + buffer->count) capacity *= 2;
+
+		uint64_t* index = realloc(writer->index, capacity * sizeof(*index));
+		if (index == NULL) {
+			writer->failed = true;
+			return false;
+		}
+		STATS_ALLOCATION(capacity * sizeof(*index));
+
+		writer->index = index;
+		writer->capacity = capacity;
+	}
+
+	for (size_t at = 0; at < buffer->size; ) {
+		struct GameRecordHeader header;
+		memcpy(&header, buffer->data + at, sizeof(header));
+
+		writer->index[writer->count++] = writer->offset + at;
+		at += record_size(&header);
+	}
+
+	if (buffer->size > 0 && fwrite(buffer->data, buffer->size, 1, writer->file) != 1) writer->failed = true;
+	writer->offset += buffer->size;
+
+	return !writer->failed;
+}
+
+bool game_writer_close(struct GameWriter* writer)
+{
+	static const uint8_t zeros[8];
+	size_t padding = (8 - writer->offset % 8) % 8;
+	struct GameFileHeader header = {{0}, GAME_FILE_VERSION, writer->count, writer->offset + padding};
+	memcpy(header.magic, GAME_FILE_MAGIC, sizeof(header.magic));
+
+	if (padding > 0 && fwrite(zeros, padding, 1, writer->file) != 1) writer->failed = true;
+	if (writer->count > 0 && fwrite(writer->index, writer->count * sizeof(*writer->index), 1, writer->file) != 1) writer->failed = true;
+	if (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, writer->file) != 1) writer->failed = true;
+	if (fclose(writer->file) != 0) writer->failed = true;
+
+	free(writer->index);
+	writer->index = NULL;
+	writer->file = NULL;
+
+	return !writer->failed;
+}
+
+bool game_file_open(struct GameFile* file, const char* path)
+{
+	struct GameFileHeader header;
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0) return false;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(header)) {
+		close(fd);
+		return false;
+	}
+
+	void* mapping = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	file->data = mapping;
+	file->size = (size_t) st.st_size;
+	memcpy(&header, file->data, sizeof(header));
+
+	bool valid = memcmp(header.magic, GAME_FILE_MAGIC, sizeof(header.magic)) == 0
+		&& header.version == GAME_FILE_VERSION
+		&& header.index_offset % 8 == 0
+		&& header.index_offset <= file->size
+		&& header.game_count <= (file->size - header.index_offset) / sizeof(uint64_t);
+
+	if (!valid) {
+		munmap(mapping, file->size);
+		return false;
+	}
+
+	file->count = header.game_count;
+	file->index = (const uint64_t*) (file->data + header.index_offset);
+
+	return true;
+}
+
+void game_file_close(struct GameFile* file)
+{
+	munmap((void*) file->data, file->size);
+	file->data = NULL;
+	file->index = NULL;
+	file->count = 0;
+}
+
+bool game_file_get(const struct GameFile* file, uint64_t n, struct GameRecord* record)
+{
+	if (n >= file->count) return false;
+
+	uint64_t offset = file->index[n];
+	if (offset % 4 != 0 || offset > file->size || file->size - offset < sizeof(struct GameRecordHeader)) return false;
+
+	const struct GameRecordHeader* header = (const struct GameRecordHeader*) (file->data + offset);
+	if (record_size(header) > file->size - offset) return false;
+
+	const char* fen = (const char*) (header + 1);
+	record->fen = header->fen_length > 0 ? fen : NULL;
+	record->fen_length = header->fen_length;
+	record->result = header->result;
+	record->ply_count = header->ply_count;
+	record->moves = (const uint16_t*) (fen + ((header->fen_length + 1u) & ~1u));
+
+	return true;
+}
+
+bool game_record_start(const struct GameRecord* record, struct Position* pos)
+{
+	char fen[FEN_MAX_LENGTH];
+
+	if (record->fen == NULL) return position_from_fen(pos, START_FEN);
+	if (record->fen_length >= FEN_MAX_LENGTH) return false;
+
+	memcpy(fen, record->fen, record->fen_length);
+	fen[record->fen_length] = '\0';
+
+	return position_from_fen(pos, fen);
+}
+
+uint32_t game_record_replay(const struct GameRecord* record, struct Position* pos, uint32_t plies, bool checked)
+{
+	struct Undo undo;
+
+	if (!game_record_start(record, pos)) return 0;
+	if (plies > record->ply_count) plies = record->ply_count;
+
+	for (uint32_t ply = 0; ply < plies; ++ply) {
+		uint16_t m = record->moves[ply];
+
+		if (checked) {
+			struct MoveList list;
+			int i = 0;
+
+			generate_legal_moves(pos, &list);
+			while (i < list.count && list.moves[i] != m) ++i;
+			if (i == list.count) return ply;
+		}
+
+		make_move(pos, m, &undo);
+	}
+
+	return plies;
+}
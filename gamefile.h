@@ -0,0 +1,113 @@
+#ifndef GAMEFILE_H
+#define GAMEFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "position.h"
+
+#define GAME_RESULT_UNKNOWN 0
+#define GAME_RESULT_WHITE_WINS 1
+#define GAME_RESULT_BLACK_WINS 2
+#define GAME_RESULT_DRAW 3
+
+/*
+ * Binary game file, in the byte order of the machine that wrote it:
+ *
+ *   header    struct GameFileHeader
+ *   records   one per game, each starting on a multiple of 4 bytes:
+ *             struct GameRecordHeader, the FEN of the start position
+ *             padded to an even length (nothing for the standard one),
+ *             then the moves, 16 bits each in the encoding of move.h
+ *   index     one 64-bit offset per game, on a multiple of 8 bytes
+ *
+ * A ply costs 2 bytes against 5 to 8 in PGN. Moves don't need to be
+ * parsed, and the file is read through a memory mapping, so a record is
+ * used where it lies in the file.
+ */
+#define GAME_FILE_MAGIC "CGMS"
+#define GAME_FILE_VERSION 1
+
+struct GameFileHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t game_count;
+	uint64_t index_offset;
+};
+
+struct GameRecordHeader {
+	uint32_t ply_count;
+	uint8_t result;
+	uint8_t fen_length;		// 0 for the standard start position
+	uint16_t reserved;
+};
+
+// One game, pointing into the file or buffer it comes from
+struct GameRecord {
+	const char* fen;			// not terminated, NULL for the standard start position
+	int fen_length;
+	int result;
+	uint32_t ply_count;
+	const uint16_t* moves;
+};
+
+// Records built in memory, so threads can encode games on their own and write them in order
+struct GameBuffer {
+	uint8_t* data;
+	size_t size;
+	size_t capacity;
+	uint64_t count;
+};
+
+struct GameWriter {
+	FILE* file;
+	uint64_t offset;			// where the next record goes
+	uint64_t* index;
+	uint64_t count;
+	uint64_t capacity;
+	bool failed;				// a write or an allocation failed
+};
+
+// A game file mapped in memory
+struct GameFile {
+	const uint8_t* data;
+	size_t size;
+	uint64_t count;
+	const uint64_t* index;
+};
+
+void game_buffer_init(struct GameBuffer* buffer);
+void game_buffer_free(struct GameBuffer* buffer);
+void game_buffer_clear(struct GameBuffer* buffer);
+
+// Encodes a game, 'start' being NULL for the standard start position. Returns false when out of memory.
+bool game_buffer_add(struct GameBuffer* buffer, const struct Position* start, const uint16_t* moves, uint32_t ply_count, int result);
+
+bool game_writer_open(struct GameWriter* writer, const char* path);
+
+// Appends every record of 'buffer'
+bool game_writer_add(struct GameWriter* writer, const struct GameBuffer* buffer);
+
+// Writes the index and the header, returns false if anything failed since game_writer_open
+bool game_writer_close(struct GameWriter* writer);
+
+// Maps the file and checks its header and index
+bool game_file_open(struct GameFile* file, const char* path);
+void game_file_close(struct GameFile* file);
+
+// Game 'n', counting from 0. Returns false if there is no such game or it runs past the end of the file.
+bool game_file_get(const struct GameFile* file, uint64_t n, struct GameRecord* record);
+
+// Sets 'pos' to the start of the game, returns false if its FEN can't be read
+bool game_record_start(const struct GameRecord* record, struct Position* pos);
+
+/*
+ * Sets 'pos' to the start of the game and plays its first 'plies' moves
+ * with make_move. With 'checked', each move must be one of the legal
+ * moves of its position. Returns the number of moves played, less than
+ * asked if the start position can't be read or a move isn't legal.
+ */
+uint32_t game_record_replay(const struct GameRecord* record, struct Position* pos, uint32_t plies, bool checked);
+
+#endif
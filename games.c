@@ -0,0 +1,178 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o games games.c position.c movegen.c zobrist.c magic.c notation.c gamefile.c eval.c stats.c
+// ./games games.bin                            replays every game, checking each move
+// ./games -unchecked games.bin                 same, trusting the moves
+// ./games -game 1234 games.bin                 prints game 1234 in PGN
+// ./games -pgn games.bin > games.pgn           converts the whole file to PGN
+
+/*
+ * Reads binary game files written by 'pgn -o' (see gamefile.h). The file
+ * is mapped in memory and any game is found through the index, so
+ * printing one game of millions doesn't read the others.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include "position.h"
+#include "movegen.h"
+#include "notation.h"
+#include "gamefile.h"
+
+// PGN lines are kept under 80 characters
+#define PGN_LINE_LENGTH 79
+
+static const char* result_names[] = {"*", "1-0", "0-1", "1/2-1/2"};
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Writes game 'n' in PGN, returns false if a move isn't legal
+static bool write_pgn(FILE* out, const struct GameRecord* record, uint64_t n)
+{
+	const char* result = result_names[record->result & 3];
+	struct Position pos;
+	struct Undo undo;
+	bool legal = game_record_start(record, &pos);
+	int column = 0;
+
+	fprintf(out, "[Event \"?\"]\n[Site \"?\"]\n[Date \"????.??.??\"]\n[Round \"%" PRIu64 "\"]\n", n + 1);
+	fprintf(out, "[White \"?\"]\n[Black \"?\"]\n[Result \"%s\"]\n", result);
+	if (record->fen != NULL) fprintf(out, "[SetUp \"1\"]\n[FEN \"%.*s\"]\n", record->fen_length, record->fen);
+	fputc('\n', out);
+
+	for (uint32_t ply = 0; legal && ply < record->ply_count; ++ply) {
+		uint16_t m = record->moves[ply];
+		struct MoveList list;
+		char token[32];
+		char san[SAN_MAX_LENGTH];
+		int length = 0;
+		int i = 0;
+
+		generate_legal_moves(&pos, &list);
+		while (i < list.count && list.moves[i] != m) ++i;
+		if (i == list.count) {
+			legal = false;
+			break;
+		}
+
+		move_to_san(&pos, m, san);
+		if (pos.side == PLAYER_WHITE) length = sprintf(token, "%d. %s", pos.fullmove, san);
+		else if (ply == 0) length = sprintf(token, "%d... %s", pos.fullmove, san);
+		else length = sprintf(token, "%s", san);
+
+		if (column > 0 && column + 1 + length > PGN_LINE_LENGTH) {
+			fputc('\n', out);
+			column = 0;
+		}
+		column += fprintf(out, "%s%s", column > 0 ? " " : "", token);
+
+		make_move(&pos, m, &undo);
+	}
+
+	fprintf(out, "%s%s\n\n", column > 0 ? " " : "", result);
+
+	return legal;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* path = NULL;
+	int64_t game = -1;
+	bool pgn = false;
+	bool checked = true;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-game") == 0 && i + 1 < argc) {
+			// Games are counted from 1, anything else is a usage error rather than the whole file
+			char* end;
+			long long n = strtoll(argv[++i], &end, 10);
+			if (end == argv[i] || *end != '\0' || n < 1) {
+				path = NULL;
+				break;
+			}
+			game = n - 1;
+		} else if (strcmp(argv[i], "-pgn") == 0) {
+			pgn = true;
+		} else if (strcmp(argv[i], "-unchecked") == 0) {
+			checked = false;
+		} else if (path == NULL && argv[i][0] != '-') {
+			path = argv[i];
+		} else {
+			path = NULL;
+			break;
+		}
+	}
+
+	if (path == NULL) {
+		fprintf(stderr, "Usage: %s [-unchecked | -game n | -pgn] <games.bin>\n", argv[0]);
+		return 1;
+	}
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	struct GameFile file;
+	if (!game_file_open(&file, path)) {
+		fprintf(stderr, "Can't read %s as a game file\n", path);
+		return 1;
+	}
+
+	struct GameRecord record;
+	uint64_t errors = 0;
+
+	if (game >= 0) {
+		if (!game_file_get(&file, (uint64_t) game, &record)) {
+			fprintf(stderr, "%s has %" PRIu64 " games\n", path, file.count);
+			game_file_close(&file);
+			return 1;
+		}
+		if (!write_pgn(stdout, &record, (uint64_t) game)) ++errors;
+	} else if (pgn) {
+		for (uint64_t n = 0; n < file.count; ++n) {
+			if (!game_file_get(&file, n, &record) || !write_pgn(stdout, &record, n)) {
+				fprintf(stderr, "game %" PRIu64 ": invalid record\n", n + 1);
+				++errors;
+			}
+		}
+	} else {
+		struct Position pos;
+		uint64_t plies = 0;
+		double begin = now_seconds();
+
+		for (uint64_t n = 0; n < file.count; ++n) {
+			uint32_t played = 0;
+			bool valid = game_file_get(&file, n, &record);
+
+			if (valid) played = game_record_replay(&record, &pos, record.ply_count, checked);
+			plies += played;
+
+			if (!valid || played < record.ply_count) {
+				printf("game %" PRIu64 ": invalid record", n + 1);
+				if (valid) printf(", illegal move at ply %" PRIu32, played + 1);
+				printf("\n");
+				++errors;
+			}
+		}
+
+		double seconds = now_seconds() - begin;
+		printf("%" PRIu64 " games, %" PRIu64 " plies, %" PRIu64 " errors in %.3f s: %.0f games/s, %.1f Mplies/s\n",
+			file.count, plies, errors, seconds, file.count / seconds, plies / seconds / 1e6);
+	}
+
+	game_file_close(&file);
+
+	return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,88 @@
+// export LD_LIBRARY_PATH=$LD_LIBRARY_PATH:./lib
+// gcc -o gen_assets gen_assets.c -L./lib -I./include -lraylib -lm -lpthread -ldl -lrt -lX11
+// ./gen_assets                                 writes piece_atlas.h, capture_sound.h and move_sound.h
+
+/*
+ * Turns the images and sounds into C headers that main.c compiles in, so
+ * the game starts without reading a file and from any directory:
+ *
+ *   piece_atlas.h    the 12 piece images side by side in one RGBA image,
+ *                    in the order of the piece codes, one square each
+ *   capture_sound.h  the sounds decoded to 16-bit PCM, so nothing is
+ *   move_sound.h     decoded at startup
+ *
+ * Run it from the repository root after changing anything in images/ or
+ * sounds/. The headers are generated, not kept in the repository.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "include/raylib.h"
+
+// Side of one piece image, and of one cell of the atlas
+#define PIECE_SIZE 60
+
+// Piece images in the order of the piece codes: the black pieces, then the white ones
+static const char* piece_files[12] = {
+	"images/pawn_b.png", "images/knight_b.png", "images/bishop_b.png",
+	"images/rook_b.png", "images/queen_b.png", "images/king_b.png",
+	"images/pawn_w.png", "images/knight_w.png", "images/bishop_w.png",
+	"images/rook_w.png", "images/queen_w.png", "images/king_w.png",
+};
+
+static bool export_atlas(const char* path)
+{
+	Image atlas = GenImageColor(12 * PIECE_SIZE, PIECE_SIZE, BLANK);
+	bool ok = true;
+
+	for (int piece = 0; piece < 12 && ok; ++piece) {
+		Image image = LoadImage(piece_files[piece]);
+		if (image.data == NULL) {
+			fprintf(stderr, "Can't read %s\n", piece_files[piece]);
+			ok = false;
+			break;
+		}
+
+		Rectangle source = {0, 0, (float) image.width, (float) image.height};
+		Rectangle cell = {(float) (piece * PIECE_SIZE), 0, PIECE_SIZE, PIECE_SIZE};
+		ImageDraw(&atlas, image, source, cell, WHITE);
+		UnloadImage(image);
+	}
+
+	ImageFormat(&atlas, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+	if (ok) ok = ExportImageAsCode(atlas, path);
+	UnloadImage(atlas);
+
+	return ok;
+}
+
+static bool export_sound(const char* source, const char* path)
+{
+	Wave wave = LoadWave(source);
+	if (wave.data == NULL) {
+		fprintf(stderr, "Can't read %s\n", source);
+		return false;
+	}
+
+	WaveFormat(&wave, wave.sampleRate, 16, wave.channels);
+	bool ok = ExportWaveAsCode(wave, path);
+	UnloadWave(wave);
+
+	return ok;
+}
+
+int main(void)
+{
+	SetTraceLogLevel(LOG_WARNING);
+
+	bool ok = export_atlas("piece_atlas.h")
+		&& export_sound("sounds/capture.mp3", "capture_sound.h")
+		&& export_sound("sounds/move.mp3", "move_sound.h");
+
+	if (!ok) {
+		fprintf(stderr, "Run from the repository root, next to images/ and sounds/\n");
+		return 1;
+	}
+
+	return 0;
+}
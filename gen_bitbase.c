@@ -0,0 +1,389 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o gen_bitbase gen_bitbase.c bitbase.c position.c movegen.c zobrist.c magic.c eval.c stats.c
+// ./gen_bitbase                 writes KQK.bb, KRK.bb, ... to the current directory
+// ./gen_bitbase -o bitbases -verify
+
+/*
+ * Writes the endgame bitbases read by bitbase.c, one file per set, in
+ * the order of bitbase_set_names so that the sets a capture or a
+ * promotion leads to are done (and kept in memory) first.
+ *
+ * Each set is solved backwards. A first pass plays the moves of every
+ * position: a mate is a loss, a stalemate a draw, a capture or promotion
+ * is looked up in the sets already done, and whatever stays in the set is
+ * counted. Then, from every won and lost position, the moves are taken
+ * back: the position before a loss is a win, and the position before a
+ * win loses once every one of its moves has been seen to lead to a win,
+ * unless one of them left the set for a draw. What is never settled is a
+ * draw.
+ *
+ * -verify checks afterwards that every entry agrees with its moves.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include "position.h"
+#include "movegen.h"
+#include "bitbase.h"
+
+#define UNKNOWN 4
+
+#define DRAW_EXIT 0x80		// in 'remaining', a move leaves the set for a draw
+#define MOVES_MASK 0x7F
+
+// A set being solved
+struct Solver {
+	struct BitbaseTable* table;
+	const struct Bitbases* done;	// the sets before this one
+	uint8_t* value;				// BITBASE_* or UNKNOWN, an entry a byte
+	uint8_t* remaining;			// moves staying in the set not yet known to lead to a win for the opponent
+	uint32_t* queue;			// won and lost entries whose moves are still to be taken back
+	uint64_t queue_head;
+	uint64_t queue_tail;
+};
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Sets up the position, false if it isn't a legal one
+static bool setup_position(const struct BitbaseTable* table, const int* squares, int side, struct Position* pos)
+{
+	position_clear(pos);
+	for (int i = 0; i < table->piece_count; ++i) {
+		int sq = squares[i];
+		if (pos->squares[sq] != EMPTY) return false;
+		if (PIECE_TYPE(table->pieces[i]) == PAWN && (SQUARE_Y(sq) == 0 || SQUARE_Y(sq) == 7)) return false;
+		position_put(pos, table->pieces[i], sq);
+	}
+	pos->side = side;
+	pos->key = position_compute_key(pos);
+
+	// The player who just moved can't have left their king in check
+	return attackers_of(pos, king_square(pos, !side), side, pos->occupied) == 0;
+}
+
+// Squares of the pieces of a position with the material of the table
+static void position_squares(const struct BitbaseTable* table, const struct Position* pos, int* squares)
+{
+	for (int i = 0; i < table->piece_count; ++i) squares[i] = lsb(pos->pieces[table->pieces[i]]);
+}
+
+static bool add_unique(uint64_t* indexes, int* count, uint64_t index)
+{
+	for (int i = 0; i < *count; ++i) {
+		if (indexes[i] == index) return false;
+	}
+	indexes[(*count)++] = index;
+
+	return true;
+}
+
+/*
+ * Value of the position from its moves alone, as known from the values of
+ * the set so far and of the sets before: UNKNOWN if it depends on moves
+ * staying in the set that aren't settled. 'children' receives the distinct
+ * entries those moves lead to.
+ */
+static int evaluate_moves(const struct Solver* solver, struct Position* pos, uint64_t* children, int* child_count, bool* draw_exit)
+{
+	struct MoveList moves;
+	bool unsettled = false;
+
+	*child_count = 0;
+	*draw_exit = false;
+
+	generate_legal_moves(pos, &moves);
+	if (moves.count == 0) return position_checkers(pos) != 0 ? BITBASE_LOSS : BITBASE_DRAW;
+
+	for (int i = 0; i < moves.count; ++i) {
+		uint16_t m = moves.moves[i];
+		struct Undo undo;
+		int result;
+
+		make_move(pos, m, &undo);
+		if (MOVE_IS_CAPTURE(m) || MOVE_IS_PROMOTION(m)) {
+			result = bitbase_probe(solver->done, pos);
+			if (result == BITBASE_NONE) {
+				char fen[FEN_MAX_LENGTH];
+				position_to_fen(pos, fen);
+				fprintf(stderr, "%s: no set before it has %s\n", solver->table->name, fen);
+				exit(1);
+			}
+		} else {
+			int squares[BITBASE_MAX_PIECES];
+			position_squares(solver->table, pos, squares);
+			uint64_t index = bitbase_index(solver->table, squares, pos->side);
+			add_unique(children, child_count, index);
+			result = solver->value[index];
+		}
+		unmake_move(pos, m, &undo);
+
+		if (result == BITBASE_LOSS) return BITBASE_WIN;
+		if (result == BITBASE_DRAW) *draw_exit = true;
+		if (result == UNKNOWN) unsettled = true;
+	}
+
+	if (unsettled) return UNKNOWN;
+	return *draw_exit ? BITBASE_DRAW : BITBASE_LOSS;
+}
+
+static void settle(struct Solver* solver, uint64_t index, int value)
+{
+	solver->value[index] = (uint8_t) value;
+	if (value != BITBASE_DRAW) solver->queue[solver->queue_tail++] = (uint32_t) index;
+}
+
+// Marks the illegal and duplicate entries, settles the positions decided by their moves and counts the others' moves
+static void initialize(struct Solver* solver)
+{
+	const struct BitbaseTable* table = solver->table;
+
+	// The moves staying in the set lead to legal entries, unknown until the whole set is set up
+	memset(solver->value, UNKNOWN, table->entries);
+	for (uint64_t index = 0; index < table->entries; ++index) {
+		int squares[BITBASE_MAX_PIECES];
+		int side;
+		struct Position pos;
+
+		solver->value[index] = BITBASE_INVALID;
+		if (!bitbase_decode(table, index, squares, &side) || !setup_position(table, squares, side, &pos)) continue;
+
+		solver->value[index] = UNKNOWN;
+		solver->remaining[index] = 0;
+
+		// Nothing in the set is settled yet, so only mates and moves out of the set decide
+		uint64_t children[MAX_MOVES];
+		int child_count;
+		bool draw_exit;
+		int value = evaluate_moves(solver, &pos, children, &child_count, &draw_exit);
+
+		if (value != UNKNOWN) {
+			settle(solver, index, value);
+		} else {
+			solver->remaining[index] = (uint8_t) (child_count | (draw_exit ? DRAW_EXIT : 0));
+		}
+	}
+}
+
+// Distinct entries of the positions one move before this one, with a move staying in the set
+static int find_predecessors(const struct Solver* solver, uint64_t index, uint64_t* predecessors)
+{
+	const struct BitbaseTable* table = solver->table;
+	int squares[BITBASE_MAX_PIECES];
+	int side;
+	int count = 0;
+
+	bitbase_decode(table, index, squares, &side);
+
+	uint64_t occupied = 0;
+	for (int i = 0; i < table->piece_count; ++i) occupied |= BIT(squares[i]);
+
+	int mover = !side;
+	for (int i = 0; i < table->piece_count; ++i) {
+		int piece = table->pieces[i];
+		if (PIECE_COLOR(piece) != mover) continue;
+
+		int to = squares[i];
+		uint64_t origins;
+
+		switch (PIECE_TYPE(piece)) {
+		case PAWN: {
+			// Pushes only: captures and promotions come from other sets
+			int back = mover == PLAYER_WHITE ? 8 : -8;
+			int start_row = mover == PLAYER_WHITE ? 6 : 1;
+			int one = to + back;
+			origins = 0;
+			if (SQUARE_Y(one) != 0 && SQUARE_Y(one) != 7 && !(occupied & BIT(one))) {
+				origins |= BIT(one);
+				int two = one + back;
+				if (SQUARE_Y(two) == start_row && !(occupied & BIT(two))) origins |= BIT(two);
+			}
+			break;
+		}
+		case KNIGHT: origins = knight_attacks(BIT(to)); break;
+		case BISHOP: origins = bishop_attacks(to, occupied); break;
+		case ROOK: origins = rook_attacks(to, occupied); break;
+		case QUEEN: origins = queen_attacks(to, occupied); break;
+		default: origins = king_attacks(BIT(to)); break;
+		}
+		origins &= ~occupied;
+
+		while (origins) {
+			int from = pop_lsb(&origins);
+			int before[BITBASE_MAX_PIECES];
+			struct Position pos;
+
+			memcpy(before, squares, sizeof(before));
+			before[i] = from;
+			if (!setup_position(table, before, mover, &pos)) continue;
+
+			add_unique(predecessors, &count, bitbase_index(table, before, mover));
+		}
+	}
+
+	return count;
+}
+
+// Takes back the moves of every won and lost entry until none is left
+static void propagate(struct Solver* solver)
+{
+	while (solver->queue_head < solver->queue_tail) {
+		uint64_t index = solver->queue[solver->queue_head++];
+		int value = solver->value[index];
+		uint64_t predecessors[4 * MAX_MOVES];
+		int count = find_predecessors(solver, index, predecessors);
+
+		for (int i = 0; i < count; ++i) {
+			uint64_t before = predecessors[i];
+			if (solver->value[before] != UNKNOWN) continue;
+
+			if (value == BITBASE_LOSS) {
+				settle(solver, before, BITBASE_WIN);
+			} else if ((--solver->remaining[before] & MOVES_MASK) == 0) {
+				settle(solver, before, solver->remaining[before] & DRAW_EXIT ? BITBASE_DRAW : BITBASE_LOSS);
+			}
+		}
+	}
+
+	for (uint64_t index = 0; index < solver->table->entries; ++index) {
+		if (solver->value[index] == UNKNOWN) solver->value[index] = BITBASE_DRAW;
+	}
+}
+
+// Checks that every entry is what its moves say, returns the number of those that aren't
+static uint64_t verify(const struct Solver* solver)
+{
+	const struct BitbaseTable* table = solver->table;
+	uint64_t errors = 0;
+
+	for (uint64_t index = 0; index < table->entries; ++index) {
+		int squares[BITBASE_MAX_PIECES];
+		int side;
+		struct Position pos;
+		uint64_t children[MAX_MOVES];
+		int child_count;
+		bool draw_exit;
+
+		if (solver->value[index] == BITBASE_INVALID) continue;
+		if (!bitbase_decode(table, index, squares, &side) || !setup_position(table, squares, side, &pos)) {
+			++errors;
+			continue;
+		}
+
+		// With everything settled, this is the value the position's moves give
+		int value = evaluate_moves(solver, &pos, children, &child_count, &draw_exit);
+		if (value != solver->value[index] || bitbase_probe(solver->done, &pos) != value) ++errors;
+	}
+
+	return errors;
+}
+
+static bool write_table(const struct BitbaseTable* table, const uint8_t* data, const char* directory)
+{
+	char path[4096];
+	struct BitbaseFileHeader header = {0};
+
+	memcpy(header.magic, BITBASE_FILE_MAGIC, sizeof(header.magic));
+	header.version = BITBASE_FILE_VERSION;
+	strcpy(header.name, table->name);
+	header.entries = table->entries;
+
+	snprintf(path, sizeof(path), "%s/%s.bb", directory, table->name);
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) return false;
+
+	size_t size = (size_t) (table->entries + 3) / 4;
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(data, 1, size, file) == size;
+
+	return fclose(file) == 0 && ok;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* directory = ".";
+	bool check = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			directory = argv[++i];
+		} else if (strcmp(argv[i], "-verify") == 0) {
+			check = true;
+		} else {
+			fprintf(stderr, "Usage: %s [-o directory] [-verify]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	struct Bitbases done;
+	uint8_t* packed[BITBASE_SET_COUNT] = {0};
+	bool ok = true;
+
+	bitbases_init(&done);
+	for (int n = 0; n < BITBASE_SET_COUNT && ok; ++n) {
+		struct BitbaseTable* table = &done.tables[n];
+		struct Solver solver = {table, &done, NULL, NULL, NULL, 0, 0};
+		double start = now_seconds();
+
+		solver.value = malloc(table->entries);
+		solver.remaining = malloc(table->entries);
+		solver.queue = malloc(table->entries * sizeof(*solver.queue));
+		packed[n] = calloc((size_t) (table->entries + 3) / 4, 1);
+		if (solver.value == NULL || solver.remaining == NULL || solver.queue == NULL || packed[n] == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			ok = false;
+		}
+
+		if (ok) {
+			initialize(&solver);
+			propagate(&solver);
+
+			uint64_t counts[4] = {0};
+			for (uint64_t index = 0; index < table->entries; ++index) {
+				packed[n][index / 4] |= (uint8_t) (solver.value[index] << (index % 4 * 2));
+				++counts[solver.value[index]];
+			}
+
+			// From here on the set answers probes, its own included
+			table->data = packed[n];
+
+			printf("%-5s %9" PRIu64 " positions: %9" PRIu64 " won, %9" PRIu64 " drawn, %9" PRIu64 " lost in %.2f s\n",
+				table->name, counts[BITBASE_WIN] + counts[BITBASE_DRAW] + counts[BITBASE_LOSS],
+				counts[BITBASE_WIN], counts[BITBASE_DRAW], counts[BITBASE_LOSS], now_seconds() - start);
+
+			if (check) {
+				uint64_t errors = verify(&solver);
+				printf("      %" PRIu64 " wrong\n", errors);
+				if (errors > 0) ok = false;
+			}
+
+			if (!write_table(table, packed[n], directory)) {
+				fprintf(stderr, "Can't write %s/%s.bb\n", directory, table->name);
+				ok = false;
+			}
+		}
+
+		free(solver.value);
+		free(solver.remaining);
+		free(solver.queue);
+	}
+
+	for (int n = 0; n < BITBASE_SET_COUNT; ++n) free(packed[n]);
+
+	return ok ? 0 : 1;
+}
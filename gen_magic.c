@@ -0,0 +1,201 @@
+// gcc -O2 -o gen_magic gen_magic.c
+// ./gen_magic > magic_tables.h
+
+/*
+ * Writes the slider attack tables compiled into magic.c, so nothing is
+ * computed when a program starts. For each square and each set of
+ * blockers on the squares a bishop or rook on it can reach, the table
+ * holds the attacked squares, found here the slow way by walking the rays.
+ *
+ * The blockers are turned into an index by a multiplication with a magic
+ * number that gathers their bits at the top of the product. The magics
+ * are searched with a fixed seed, so the output is always the same. On
+ * processors with BMI2, PEXT gathers the bits directly; both orders are
+ * written and magic.c keeps the one its build uses.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BISHOP_TABLE_SIZE 5248
+#define ROOK_TABLE_SIZE 102400
+
+struct MagicEntry {
+	uint64_t mask;
+	uint64_t magic;
+	int shift;
+	int offset;
+};
+
+static struct MagicEntry bishop_entries[64];
+static struct MagicEntry rook_entries[64];
+static uint64_t magic_table[BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE];
+static uint64_t pext_table[BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE];
+
+static const int bishop_directions[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+static const int rook_directions[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+// Walks each ray from 'sq' until it leaves the board or hits a blocker, which is included
+static uint64_t slow_attacks(int sq, uint64_t occupied, const int directions[4][2])
+{
+	uint64_t attacks = 0;
+
+	for (int d = 0; d < 4; ++d) {
+		int x = sq % 8 + directions[d][0];
+		int y = sq / 8 + directions[d][1];
+
+		while (x >= 0 && x < 8 && y >= 0 && y < 8) {
+			attacks |= 1ULL << (y * 8 + x);
+			if (occupied & (1ULL << (y * 8 + x))) break;
+			x += directions[d][0];
+			y += directions[d][1];
+		}
+	}
+
+	return attacks;
+}
+
+// Squares whose blockers matter: the rays without their last square, a piece there changes nothing
+static uint64_t relevant_mask(int sq, const int directions[4][2])
+{
+	uint64_t mask = 0;
+
+	for (int d = 0; d < 4; ++d) {
+		int x = sq % 8 + directions[d][0];
+		int y = sq / 8 + directions[d][1];
+
+		while (x + directions[d][0] >= 0 && x + directions[d][0] < 8
+			&& y + directions[d][1] >= 0 && y + directions[d][1] < 8) {
+			mask |= 1ULL << (y * 8 + x);
+			x += directions[d][0];
+			y += directions[d][1];
+		}
+	}
+
+	return mask;
+}
+
+// Portable PEXT: packs the bits of 'b' selected by 'mask' into the low bits
+static uint64_t software_pext(uint64_t b, uint64_t mask)
+{
+	uint64_t result = 0;
+
+	for (uint64_t bit = 1; mask; bit <<= 1) {
+		if (b & mask & -mask) result |= bit;
+		mask &= mask - 1;
+	}
+
+	return result;
+}
+
+// xorshift64*, fixed seed
+static uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t random_u64(void)
+{
+	random_state ^= random_state >> 12;
+	random_state ^= random_state << 25;
+	random_state ^= random_state >> 27;
+
+	return random_state * 0x2545F4914F6CDD1DULL;
+}
+
+// Finds a magic for the square and fills both tables at 'offset', returns the number of entries
+static int find_magic(int sq, const int directions[4][2], struct MagicEntry* entry, int offset)
+{
+	static uint64_t blockers[4096];
+	static uint64_t attacks[4096];
+	static uint64_t used[4096];
+
+	uint64_t mask = relevant_mask(sq, directions);
+	int bits = __builtin_popcountll(mask);
+	int count = 0;
+
+	// Every subset of the mask, with the carry-rippler trick
+	uint64_t subset = 0;
+	do {
+		blockers[count] = subset;
+		attacks[count] = slow_attacks(sq, subset, directions);
+		pext_table[offset + software_pext(subset, mask)] = attacks[count];
+		++count;
+		subset = (subset - mask) & mask;
+	} while (subset);
+
+	for (;;) {
+		// Sparse candidates work best
+		uint64_t magic = random_u64() & random_u64() & random_u64();
+		if (__builtin_popcountll((mask * magic) >> 56) < 6) continue;
+
+		bool ok = true;
+		for (int i = 0; i < count; ++i) used[i] = 0;
+
+		// Two blocker sets may share an index only if they give the same attacks
+		for (int i = 0; i < count && ok; ++i) {
+			uint64_t index = (blockers[i] * magic) >> (64 - bits);
+			if (used[index] == 0) {
+				used[index] = attacks[i];
+			} else if (used[index] != attacks[i]) {
+				ok = false;
+			}
+		}
+
+		if (!ok) continue;
+
+		for (int i = 0; i < count; ++i) magic_table[offset + i] = used[i];
+
+		entry->mask = mask;
+		entry->magic = magic;
+		entry->shift = 64 - bits;
+		entry->offset = offset;
+
+		return count;
+	}
+}
+
+static void print_entries(const char* name, const struct MagicEntry* entries)
+{
+	printf("const struct Magic %s[64] = {\n", name);
+	for (int sq = 0; sq < 64; ++sq) {
+		printf("\t{0x%016llxULL, 0x%016llxULL, %d, %d},\n", (unsigned long long) entries[sq].mask,
+			(unsigned long long) entries[sq].magic, entries[sq].offset, entries[sq].shift);
+	}
+	printf("};\n\n");
+}
+
+static void print_table(const uint64_t* table)
+{
+	printf("const uint64_t slider_attacks[%d] = {\n", BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE);
+	for (int i = 0; i < BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE; i += 4) {
+		printf("\t0x%016llxULL, 0x%016llxULL, 0x%016llxULL, 0x%016llxULL,\n",
+			(unsigned long long) table[i], (unsigned long long) table[i + 1],
+			(unsigned long long) table[i + 2], (unsigned long long) table[i + 3]);
+	}
+	printf("};\n");
+}
+
+int main(void)
+{
+	int offset = 0;
+
+	for (int sq = 0; sq < 64; ++sq) offset += find_magic(sq, bishop_directions, &bishop_entries[sq], offset);
+	for (int sq = 0; sq < 64; ++sq) offset += find_magic(sq, rook_directions, &rook_entries[sq], offset);
+
+	if (offset != BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE) {
+		fprintf(stderr, "Unexpected table size %d\n", offset);
+		return 1;
+	}
+
+	printf("// Generated by gen_magic.c, do not edit. Only included by magic.c.\n\n");
+	print_entries("bishop_magics", bishop_entries);
+	print_entries("rook_magics", rook_entries);
+
+	printf("#ifdef __BMI2__\n");
+	print_table(pext_table);
+	printf("#else\n");
+	print_table(magic_table);
+	printf("#endif\n");
+
+	return 0;
+}
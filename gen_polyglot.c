@@ -0,0 +1,141 @@
+// gcc -O2 -o gen_polyglot gen_polyglot.c
+// ./gen_polyglot pg_key.c > polyglot_random.h     then rebuild anything with book.c
+
+/*
+ * Writes Polyglot's Random64 table, optional: book.c uses it when it is
+ * there for the keys of book positions (see book_key), and the engine's
+ * Zobrist keys otherwise. The 781 numbers are Polyglot's own and can't
+ * be computed: they come with its sources (pg_key.c) and the description
+ * of its book format. Unlike gen_magic this needs that file as input. It
+ * reads any file listing the numbers in order, taking every 64-bit
+ * hexadecimal constant it finds, and checks them against the key the
+ * format gives for the starting position before writing anything; bench
+ * checks the compiled table the same way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#define RANDOM_COUNT 781
+
+// Key of the starting position in the book format description
+#define START_KEY 0x463B96181691FC9CULL
+
+// The first 'max' constants written as 0x and exactly 16 hexadecimal digits, returns how many were found
+static int read_constants(const char* text, uint64_t* values, int max)
+{
+	int count = 0;
+
+	for (const char* c = text; *c && count < max; ++c) {
+		if (c[0] != '0' || (c[1] != 'x' && c[1] != 'X')) continue;
+		if (c > text && (isalnum((unsigned char) c[-1]) || c[-1] == '_')) continue;
+
+		// Shorter or longer constants are something else
+		int length = (int) strspn(c + 2, "0123456789abcdefABCDEF");
+		if (length == 16) values[count++] = strtoull(c + 2, NULL, 16);
+		c += 1 + length;
+	}
+
+	return count;
+}
+
+// The whole file, NULL if it can't be read
+static char* read_file(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) return NULL;
+
+	char* text = NULL;
+	size_t length = 0;
+	size_t capacity = 0;
+	size_t n;
+
+	do {
+		if (capacity - length < 4096) {
+			capacity = capacity > 0 ? capacity * 2 : 65536;
+			char* grown = realloc(text, capacity + 1);
+			if (grown == NULL) {
+				free(text);
+				fclose(file);
+				return NULL;
+			}
+			text = grown;
+		}
+		n = fread(text + length, 1, capacity - length, file);
+		length += n;
+	} while (n > 0);
+
+	fclose(file);
+	text[length] = '\0';
+	return text;
+}
+
+/*
+ * The key of the starting position from the table alone: 64 squares for
+ * each piece, black then white for each of pawn to king, the squares
+ * counted from a1, then the four castling rights and the side to move.
+ */
+static uint64_t start_key(const uint64_t* random)
+{
+	static const char* const rows[8] = {
+		"rnbqkbnr", "pppppppp", "........", "........", "........", "........", "PPPPPPPP", "RNBQKBNR"
+	};
+	static const char types[] = "pnbrqk";
+	uint64_t key = 0;
+
+	for (int y = 0; y < 8; ++y) {
+		for (int x = 0; x < 8; ++x) {
+			char letter = rows[y][x];
+			if (letter == '.') continue;
+
+			int type = (int) (strchr(types, tolower((unsigned char) letter)) - types);
+			int kind = 2 * type + (isupper((unsigned char) letter) ? 1 : 0);
+			key ^= random[64 * kind + 8 * (7 - y) + x];
+		}
+	}
+
+	for (int i = 768; i < 772; ++i) key ^= random[i];
+
+	return key ^ random[780];
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s pg_key.c > polyglot_random.h\n", argv[0]);
+		return 1;
+	}
+
+	char* text = read_file(argv[1]);
+	if (text == NULL) {
+		fprintf(stderr, "Can't read %s\n", argv[1]);
+		return 1;
+	}
+
+	static uint64_t random[RANDOM_COUNT];
+	int count = read_constants(text, random, RANDOM_COUNT);
+	free(text);
+
+	if (count != RANDOM_COUNT) {
+		fprintf(stderr, "%s has %d 64-bit constants, Random64 has %d\n", argv[1], count, RANDOM_COUNT);
+		return 1;
+	}
+
+	if (start_key(random) != START_KEY) {
+		fprintf(stderr, "The starting position's key is %016llX instead of %016llX, %s doesn't have Random64 in order\n",
+			(unsigned long long) start_key(random), START_KEY, argv[1]);
+		return 1;
+	}
+
+	printf("// Generated by gen_polyglot.c, do not edit. Only included by book.c.\n\n");
+	printf("static const uint64_t polyglot_random[%d] = {\n", RANDOM_COUNT);
+	for (int i = 0; i < RANDOM_COUNT; ++i) {
+		printf("%s0x%016llXULL,%s", i % 4 == 0 ? "\t" : " ", (unsigned long long) random[i], i % 4 == 3 || i == RANDOM_COUNT - 1 ? "\n" : "");
+	}
+	printf("};\n");
+
+	return 0;
+}
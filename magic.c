@@ -0,0 +1,22 @@
+#include "bitboard.h"
+
+// Generated tables, see gen_magic.c
+#include "magic_tables.h"
+
+const char* slider_attacks_method(void)
+{
+#ifdef __BMI2__
+	return "pext";
+#else
+	return "magic";
+#endif
+}
+
+bool slider_attacks_supported(void)
+{
+#ifdef __BMI2__
+	return __builtin_cpu_supports("bmi2");
+#else
+	return true;
+#endif
+}
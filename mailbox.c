@@ -0,0 +1,53 @@
+#include <stdlib.h>
+#include <string.h>
+#include "mailbox.h"
+#include "stats.h"
+
+bool mailbox_init(struct Mailbox* mailbox, uint32_t capacity, size_t message_size)
+{
+	uint32_t rounded = 1;
+	while (rounded < capacity) rounded *= 2;
+
+	mailbox->messages = malloc((size_t) rounded * message_size);
+	if (mailbox->messages == NULL) return false;
+	STATS_ALLOCATION((size_t) rounded * message_size);
+
+	mailbox->capacity = rounded;
+	mailbox->message_size = message_size;
+	atomic_init(&mailbox->head, 0);
+	atomic_init(&mailbox->tail, 0);
+
+	return true;
+}
+
+void mailbox_free(struct Mailbox* mailbox)
+{
+	free(mailbox->messages);
+	mailbox->messages = NULL;
+}
+
+bool mailbox_send(struct Mailbox* mailbox, const void* message)
+{
+	uint32_t tail = atomic_load_explicit(&mailbox->tail, memory_order_relaxed);
+	uint32_t head = atomic_load_explicit(&mailbox->head, memory_order_acquire);
+	if (tail - head == mailbox->capacity) return false;
+
+	// The release publishes the copy along with the new tail
+	memcpy(mailbox->messages + (size_t) (tail & (mailbox->capacity - 1)) * mailbox->message_size, message, mailbox->message_size);
+	atomic_store_explicit(&mailbox->tail, tail + 1, memory_order_release);
+
+	return true;
+}
+
+bool mailbox_receive(struct Mailbox* mailbox, void* message)
+{
+	uint32_t head = atomic_load_explicit(&mailbox->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&mailbox->tail, memory_order_acquire);
+	if (head == tail) return false;
+
+	// The slot can only be reused once the release of the new head says it was copied out
+	memcpy(message, mailbox->messages + (size_t) (head & (mailbox->capacity - 1)) * mailbox->message_size, mailbox->message_size);
+	atomic_store_explicit(&mailbox->head, head + 1, memory_order_release);
+
+	return true;
+}
@@ -0,0 +1,34 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Queue of fixed-size messages from exactly one producer thread to exactly
+ * one consumer thread, without locks: each side only writes its own index,
+ * so neither ever waits for the other. Sending into a full mailbox fails
+ * instead of blocking. The indexes live on separate cache lines so the
+ * two threads don't pass one back and forth.
+ */
+struct Mailbox {
+	_Alignas(64) _Atomic uint32_t head;		// next message to receive, written by the consumer
+	_Alignas(64) _Atomic uint32_t tail;		// next free slot, written by the producer
+	_Alignas(64) uint32_t capacity;			// a power of two
+	size_t message_size;
+	unsigned char* messages;
+};
+
+// Room for 'capacity' messages, rounded up to a power of two
+bool mailbox_init(struct Mailbox* mailbox, uint32_t capacity, size_t message_size);
+void mailbox_free(struct Mailbox* mailbox);
+
+// Producer side: copies the message in, false if the mailbox is full
+bool mailbox_send(struct Mailbox* mailbox, const void* message);
+
+// Consumer side: copies the oldest message out, false if there is none
+bool mailbox_receive(struct Mailbox* mailbox, void* message);
+
+#endif
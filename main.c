@@ -1,21 +1,28 @@
 // export LD_LIBRARY_PATH=$LD_LIBRARY_PATH:./lib
-// gcc -o main main.c -L./lib -I./include -lraylib -lm -lpthread -ldl -lrt -lX11 
-// ./main
-
-/* TODO:
- * En passant of pawns
- * Checkmate
- * Check mechanic:
- *	1. If a king is in check, movement should be defined based on the check position
- *	2. The king can't move to a position that would get itself into check
- *	3. Pieces can't be moved to a position that would make their king get into check
- */
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -o gen_assets gen_assets.c -L./lib -I./include -lraylib -lm -lpthread -ldl -lrt -lX11 && ./gen_assets
+// gcc -o main main.c position.c movegen.c game.c zobrist.c tt.c search.c magic.c eval.c nnue.c bitbase.c engine.c mailbox.c stats.c -L./lib -I./include -lraylib -lm -lpthread -ldl -lrt -lX11 
+// ./main                                       starts from the usual position
+// ./main "<fen>"                               starts from any position
+// ./main -computer black                       plays against the engine, which takes black
+// ./main -computer white -movetime 3000 -threads 4 "<fen>"
+// H shows the engine's best move and evaluation for the player to move
+// Ctrl+C copies the position as a FEN, Ctrl+V loads the FEN in the clipboard
+// F3 shows the counters and timers of a build with -DCHESS_STATS, written to chess_trace.json on exit
 
 #include <stdio.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "include/raylib.h"
+#include "chess.h"
+
+// Images and sounds compiled in by gen_assets, nothing is read from disk
+#include "piece_atlas.h"
+#include "capture_sound.h"
+#include "move_sound.h"
 
 #define SCREEN_WIDTH 480
 #define SCREEN_HEIGHT 480
@@ -23,22 +30,40 @@
 #define BOARD_SIZE 8
 #define SQUARE_SIZE 60
 
-// Last positions that were moved
-// Used to draw a different color on the board
-int last_moves[2][2] = {{-1, -1}, {-1, -1}};
+// The atlas holds one square cell per piece code, side by side
+#define ATLAS_CELL_SIZE PIECE_ATLAS_HEIGHT
+
+// Most frames drawn per second, only reached while events keep coming in (mouse moves, keys)
+#define MAX_FPS 30
+
+// Where a -DCHESS_STATS build writes its Chrome trace on exit
+#define STATS_TRACE_PATH "chess_trace.json"
 
-// Load audio files
+// The engine's defaults: time per move of the computer, hash table and search threads
+#define DEFAULT_MOVE_TIME_MS 1000
+#define ENGINE_HASH_MB 64
+
+// Sounds made from the embedded samples
 Sound capture_sound;
 Sound move_sound;
 
+// What the player is doing on screen, the rules are kept by 'struct Game'
 struct GameState {
-	int turn; 					// 0 = white, 1 = black
 	bool clicked_piece; 		// rather a piece has been selected or not
 	int clicked_piece_pos[2]; 	// position of the selected piece
-	int num_moves;
-	int** possible_moves;		// possible moves to draw on screen
-	bool is_in_check;
-	int attacker_position[2]; 	// Piece attacking the king making the check
+	uint64_t targets;			// squares the selected piece can move to, one bit each
+	bool dirty;					// the board changed since it was last drawn into its texture
+	bool show_stats;			// F3 overlay, drawn every frame on top of the board
+
+	// The engine searches on its own thread (see engine.h), the frames only send it the game and read its reports
+	int computer;				// side the engine plays, -1 for none
+	int64_t move_time_ms;
+	bool show_hint;				// H: the engine analyses the position for the player to move
+	bool engine_dirty;			// the game changed since the engine was last told
+	uint64_t engine_generation;	// of the last request, 0 before the first
+	int engine_task;			// ENGINE_* of that request, ENGINE_PLAY too once a ponder search hits
+	uint16_t ponder_move;		// reply the computer expects to its last move
+	struct EngineReport report;	// latest report of the last request
 };
 
 // This function takes an array to store the coordinates of the clicked square
@@ -61,317 +86,16 @@ bool handle_click(int* coordinate)
 	return false;
 }
 
-int** add_move(int** possible_moves, int* num_moves, int x, int y)
-{
-	// Increment the count of the number of possible moves
-	++(*num_moves);
-
-	// Resize the `possible_moves` array to make space for the new move
-	int** temp = (int**) realloc(possible_moves, (*num_moves) * sizeof(int*));
-
-	// If the reallocation was successful, update the `possible_moves` pointer
-	if (temp) {
-		possible_moves = temp;
-
-		// Allocate space for the new move and add it to the end of the list
-		possible_moves[(*num_moves) - 1] = (int*) malloc(2 * sizeof(int));
-		possible_moves[(*num_moves) - 1][0] = x;
-		possible_moves[(*num_moves) - 1][1] = y;
-	}
-
-	// Return a pointer to the updated `possible_moves` array
-	return possible_moves;
-}
-
-// TODO: en passant
-int** find_pawn_moves(int board[][8], int** possible_moves, int* num_moves, int piece, int player, int x, int y)
-{
-	// Black pawns move in the +y direction, white pawns move in the -y direction
-	int direction = player == 0 ? 1 : -1;
-
-	// Normal move
-	if (board[y+direction][x] == -1) {
-		possible_moves = add_move(possible_moves, num_moves, x, y+direction);
-	}
-
-	// Start position
-	if ((y == 1 && player == 0) || (y == 6 && player == 1)) {
-		if (board[y+2*direction][x] == -1 && board[y+direction][x] == -1) {
-			possible_moves = add_move(possible_moves, num_moves, x, y+2*direction);
-		}
-	}
-
-	// Attack move
-	if (x > 0 && board[y+direction][x-1] >= (player == 0 ? 6 : 0) && board[y+direction][x-1] < (player == 0 ? 12 : 6)) {
-		possible_moves = add_move(possible_moves, num_moves, x-1, y+direction);
-	}
-
-	if (x < 7 && board[y+direction][x+1] >= (player == 0 ? 6 : 0) && board[y+direction][x+1] < (player == 0 ? 12 : 6)) {
-		possible_moves = add_move(possible_moves, num_moves, x+1, y+direction);
-	}
-
-	return possible_moves;
-}
-
-int** find_knight_moves(int board[][8], int** possible_moves, int* num_moves, int piece, int player, int x, int y)
-{
-	// Possible L-shaped moves
-	// xd and dy represent the x and y offsets of each 
-	// of the eight possible L-shaped moves
-	int dx[8] = { 1, 2, 2, 1, -1, -2, -2, -1 };
-	int dy[8] = { 2, 1, -1, -2, -2, -1, 1, 2 };
-
-	// Check each possible L-shaped move
-	for (int i = 0; i < 8; i++) {
-		int cx = x + dx[i];
-		int cy = y + dy[i];
-
-		if (cx >= 0 && cx < 8 && cy >= 0 && cy < 8) {
-			int target = board[cy][cx];
-
-			// If the target square is empty or has an opponent's piece, add it to the list of possible moves
-			if (target == -1 || (player == 0 && target > 5 && target <= 11) || (player == 1 && target >= 0 && target < 6)) {
-				possible_moves = add_move(possible_moves, num_moves, cx, cy);
-			}
-		}
-	}
-
-	return possible_moves;
-}
-
-int** find_bishop_moves(int board[][8], int** possible_moves, int* num_moves, int piece, int player, int x, int y)
-{
-	for (int dirx = -1; dirx <= 1; dirx += 2) {
-		for (int diry = -1; diry <= 1; diry += 2) {
-			if (dirx == 0 && diry == 0) continue;
-
-			int cx = x + dirx;
-			int cy = y + diry;
-			while (cx >= 0 && cx < 8 && cy >= 0 && cy < 8) {
-				int target = board[cy][cx];
-
-				if (target == -1) {
-					possible_moves = add_move(possible_moves, num_moves, cx, cy);
-				} else if ((player == 0 && target > 5 && target <= 11) || (player == 1 && target >= 0 && target < 6)) {
-					possible_moves = add_move(possible_moves, num_moves, cx, cy);
-					break;
-				} else {
-					break;
-				}
-
-				cx += dirx;
-				cy += diry;
-			}
-		}
-	}
-	return possible_moves;
-}
-
-int** find_rook_moves(int board[][8], int** possible_moves, int* num_moves, int piece, int player, int x, int y)
-{
-	for (int dirx = -1; dirx <= 1; ++dirx) {
-		for (int diry = -1; diry <= 1; ++diry) {
-			if (dirx == 0 && diry == 0) continue;
-			if (dirx % 2 != 0 && diry % 2 != 0) continue;
-
-			int cx = x + dirx;
-			int cy = y + diry;
-			while (cx >= 0 && cx < 8 && cy >= 0 && cy < 8) {
-				int target = board[cy][cx];
-
-				if (target == -1) {
-					possible_moves = add_move(possible_moves, num_moves, cx, cy);
-				} else if ((player == 0 && target > 5 && target <= 11) || (player == 1 && target >= 0 && target < 6)) {
-					possible_moves = add_move(possible_moves, num_moves, cx, cy);
-					break;
-				} else {
-					break;
-				}
-
-				cx += dirx;
-				cy += diry;
-			}
-		}
-	}
-
-	return possible_moves;
-}
-
-int** find_queen_moves(int board[][8], int** possible_moves, int* num_moves, int piece, int player, int x, int y)
-{
-	for (int dirx = -1; dirx <= 1; ++dirx) {
-		for (int diry = -1; diry <= 1; ++diry) {
-			if (dirx == 0 && diry == 0) continue;
-
-			int cx = x + dirx;
-			int cy = y + diry;
-			while (cx >= 0 && cx < 8 && cy >= 0 && cy < 8) {
-				int target = board[cy][cx];
-
-				if (target == -1) {
-					possible_moves = add_move(possible_moves, num_moves, cx, cy);
-				} else if ((player == 0 && target > 5 && target <= 11) || (player == 1 && target >= 0 && target < 6)) {
-					possible_moves = add_move(possible_moves, num_moves, cx, cy);
-					break;
-				} else {
-					break;
-				}
-
-				cx += dirx;
-				cy += diry;
-			}
-		}
-	}
-
-	return possible_moves;
-}
-
-// TODO: incomplete
-int** find_king_moves(int board[][8], int** possible_moves, int* num_moves, int piece, int player, int x, int y)
-{
-	for (int dx = -1; dx <= 1; ++dx) {
-		for (int dy = -1; dy <= 1; ++dy) {
-			if (dx == 0 && dy == 0) continue;
-
-			int cx = x + dx;
-			int cy = y + dy;
-			if (cx >= 0 && cx < 8 && cy >= 0 && cy < 8) {
-				int target = board[cy][cx];
-				if (target == -1 || ((player == 0 && target > 5 && target <= 11) || (player == 1 && target >= 0 && target < 6))) {
-					possible_moves = add_move(possible_moves, num_moves, cx, cy);
-				}
-			}
-		}
-	}
-
-	return possible_moves;
-}
-
-int** find_possible_moves(int board[][8], int** possible_moves, int* piece_coordinate, int* num_moves, struct GameState* game)
-{
-	int piece = board[piece_coordinate[1]][piece_coordinate[0]];
-	int player = (piece < 6) ? 0 : 1;  // 0 for black, 1 for white
-	if (player == 1) piece -= 6;
-
-	int x = piece_coordinate[0];
-	int y = piece_coordinate[1];
-
-	switch (piece) {
-		case 0:  // Pawn
-			possible_moves = find_pawn_moves(board, possible_moves, num_moves, piece, player, x, y);
-			break;
-		case 1:  // Knight
-			possible_moves = find_knight_moves(board, possible_moves, num_moves, piece, player, x, y);
-			break;
-		case 2:  // Bishop
-			possible_moves = find_bishop_moves(board, possible_moves, num_moves, piece, player, x, y);
-			break;
-		case 3:  // Rook
-			possible_moves = find_rook_moves(board, possible_moves, num_moves, piece, player, x, y);
-			break;
-		case 4:  // Queen
-			possible_moves = find_queen_moves(board, possible_moves, num_moves, piece, player, x, y);
-			break;
-		case 5:  // King
-			possible_moves = find_king_moves(board, possible_moves, num_moves, piece, player, x, y);
-			break;
-		default:
-			break;
-	}
-
-	return possible_moves;
-}
-
-// Free the moves
-void free_moves(int** moves, int num_moves)
-{
-	for (int i = 0; i < num_moves; ++i) {
-		free(moves[i]);
-	}
-
-	free(moves);
-}
-
-bool is_move_in_array_of_moves(int** moves, int num_moves, int x, int y)
-{
-	for (int i = 0; i < num_moves; ++i) {
-		if ((moves[i][0] == x) && (moves[i][1] == y)) return true;
-	}
-
-	return false;
-}
-
-// Returns in game->attacker_position the position of the attacker
-bool is_position_being_attacked(int board[][8], int x, int y, struct GameState* game) 
-{
-	int victim = (board[y][x] < 6) ? 0 : 1; // 0 = black, 1 = white
-
-	for (int i = 0; i < 8; ++i) {
-		for (int j = 0; j < 8; ++j) {
-			if (board[j][i] != -1) {
-				int piece = board[j][i];
-				if (victim == 0 && piece >= 6 && piece <= 11) { // Black being attacked by white
-					int num_moves = 0;
-					int** possible_moves = NULL;
-					int position[2] = {i, j};
-					possible_moves = find_possible_moves(board, possible_moves, position, &num_moves, game);
-
-					if (is_move_in_array_of_moves(possible_moves, num_moves, x, y)) {
-						game->attacker_position[0] = i;
-						game->attacker_position[1] = j;
-						return true;
-					}
-
-					free_moves(possible_moves, num_moves);
-				} else if (victim == 1 && piece >= 0 && piece <= 5) { // White being attacked by black
-					int num_moves = 0;
-					int** possible_moves = NULL;
-					int position[2] = {i, j};
-					possible_moves = find_possible_moves(board, possible_moves, position, &num_moves, game);
-
-					if (is_move_in_array_of_moves(possible_moves, num_moves, x, y)) {
-						game->attacker_position[0] = i;
-						game->attacker_position[1] = j;
-						return true;
-					}
-
-					free_moves(possible_moves, num_moves);
-				}
-			}
-		}
-	}
-
-	return false;
-}
-
-bool is_king_in_check(int board[][8], struct GameState* game)
-{
-	for (int i = 0; i < 8; ++i) {
-		for (int j = 0; j < 8; ++j) {
-			int piece = board[j][i];
-			if (piece == 5) { // Black King
-				if (is_position_being_attacked(board, i, j, game)) {
-					return true;
-				}
-			} else if (piece == 11) { // White King
-				if (is_position_being_attacked(board, i, j, game)) return true;
-			}
-		}
-	}
-
-	return false;
-}
-
 /*
- * Check if a move is valid for a given piece on the board.
+ * Finds the move of the selected piece that lands on the clicked square.
  * 
- * 'board' The chess board.
+ * 'chess' The game being played.
  * 'piece_coordinate' The coordinate of the piece to move.
  * 'move_coordinate' The coordinate to move the piece to.
  * 
- * returns true if the move is valid, false otherwise.
+ * returns the move if it is valid, MOVE_NONE otherwise.
  */
-bool is_move_valid(int board[][8], int* piece_coordinate, int* move_coordinate, struct GameState* game)
+uint16_t find_valid_move(const struct Game* chess, int* piece_coordinate, int* move_coordinate)
 {
 	// Get the piece and move coordinates
 	int piece_x = piece_coordinate[0];
@@ -380,104 +104,72 @@ bool is_move_valid(int board[][8], int* piece_coordinate, int* move_coordinate,
 	int move_y = move_coordinate[1];
 
 	// Make sure the piece is on the board
-	if (piece_x < 0 || piece_x > 7 || piece_y < 0 || piece_y > 7) return false;
+	if (piece_x < 0 || piece_x > 7 || piece_y < 0 || piece_y > 7) return MOVE_NONE;
 
 	// Make sure the piece and the move coordinates are not the same
-	if (piece_x == move_x && piece_y == move_y) return false;
-
-	// Find all possible moves for the piece
-	int num_moves = game->num_moves;
-	int** possible_moves = game->possible_moves;
-
-	// Check if the move is one of the possible moves
-	if (possible_moves != NULL) {
-		for (int i = 0; i < num_moves; ++i) {
-			if (possible_moves[i] != NULL) {
-				if ((possible_moves[i][0] == move_x) && (possible_moves[i][1] == move_y)) {
-					// The move is valid
-					// free the memory used by 'possible_moves' and return true
-					free_moves(possible_moves, num_moves);
-					return true;
-				}
-			}
-		}
-	}
+	if (piece_x == move_x && piece_y == move_y) return MOVE_NONE;
 
-	// The move is not one of the possible moves
-	// free the memory used by 'possible_moves' and return false
-	free_moves(possible_moves, num_moves);
-	return false;
+	// Check if the move is one of the legal moves, promotions come queen first
+	return game_find_move(chess, SQUARE(piece_x, piece_y), SQUARE(move_x, move_y));
 }
 
 /*
  * Makes a move on the board.
  *
- * 'board' The chess board.
- * 'piece_coordinate' The coordinate of the piece to move.
- * 'move_coordinate' The coordinate to move the piece to.
+ * 'chess' The game being played.
+ * 'm' The move to make.
  *
  */
-void move(int board[][8], int* piece_coordinate, int* move_coordinate)
+void move(struct Game* chess, uint16_t m)
 {
-	// Retrieve what the moved piece is
-	int piece = board[piece_coordinate[1]][piece_coordinate[0]];
-
-	// Changes piece's position to empty
-	board[piece_coordinate[1]][piece_coordinate[0]] = -1;
-
 	// Play sound depending if it's a move or a capture
-	if (board[move_coordinate[1]][move_coordinate[0]] != -1) {
+	if (MOVE_IS_CAPTURE(m)) {
 		PlaySound(capture_sound);
 	} else {
 		PlaySound(move_sound);
 	}
 
-	if (piece == 0 && move_coordinate[1] == 7) {
-		// If black piece moves to end of board turns to queen
-		board[move_coordinate[1]][move_coordinate[0]] = 4;
-	} else if (piece == 6 && move_coordinate[1] == 0) {
-		// If white piece moves to end of board turns to queen
-		board[move_coordinate[1]][move_coordinate[0]] = 10;
-	} else {
-		// If it's a normal move/capture, just overwrites position to piece value
-		board[move_coordinate[1]][move_coordinate[0]] = piece;
+	// Moves the piece, along with the rook when castling and the captured pawn on en passant
+	game_play(chess, m);
+
+	// Reports check, checkmate and stalemate found by the rules
+	if (chess->checkers) {
+		int attacker = lsb(chess->checkers);
+		printf("King is in check by (%d, %d)\n", SQUARE_X(attacker), SQUARE_Y(attacker));
 	}
 
-	// Updates 'last_moves' positions to for the draw function
-	last_moves[0][0] = piece_coordinate[0];
-	last_moves[0][1] = piece_coordinate[1];
-	last_moves[1][0] = move_coordinate[0];
-	last_moves[1][1] = move_coordinate[1];
+	if (chess->status == STATUS_CHECKMATE) {
+		printf("Checkmate, %s wins\n", chess->pos.side == PLAYER_WHITE ? "black" : "white");
+	} else if (chess->status == STATUS_STALEMATE) {
+		printf("Stalemate\n");
+	} else if (chess->status == STATUS_DRAW_REPETITION) {
+		printf("Draw by threefold repetition\n");
+	}
 }
 
 /*
  * Checks if the click on the screen is a valid click
  *
- * 'board' The chess board.
+ * 'chess' The game being played.
  * 'piece_coordinate' The coordinate of the piece to move.
  * 'move_coordinate' The coordinate to move the piece to.
- * 'game' The current state of the game.
+ * 'game' The current state of the screen.
  *
  */
-bool is_click_valid(int board[][8], int* piece_coordinate, int* move_coordinate, struct GameState* game)
+bool is_click_valid(struct Game* chess, int* piece_coordinate, int* move_coordinate, struct GameState* game)
 {
 	// Get move position
 	int x = move_coordinate[0];
 	int y = move_coordinate[1];
 	// Get the piece from the move position
-	int piece = board[y][x];
+	int piece = position_piece_at(&chess->pos, x, y);
 
 	if (game->clicked_piece == false) { // Selecting piece to move
 		// If clicked on empty space returns false
 		if (piece == -1) return false;
 
-		if (game->turn == 0) { // White Turn
-			// Tried to move black
-			if (piece < 6 || piece > 11) return false;
-		} else { // Black Turn
-			// Tried to move white
-			if (piece < 0 || piece > 5) return false;
-		}
+		// Tried to move the other player's piece
+		if (PIECE_COLOR(piece) != chess->pos.side) return false;
 
 		// Updates 'piece_coordinate' for the selected piece to move
 		piece_coordinate[0] = x;
@@ -487,180 +179,473 @@ bool is_click_valid(int board[][8], int* piece_coordinate, int* move_coordinate,
 		game->clicked_piece_pos[0] = x;
 		game->clicked_piece_pos[1] = y;
 		game->clicked_piece = true;
+		game->dirty = true;
 
-		// Update game->possible_moves of the clicked piece
-		int num_moves = 0;
-		int** possible_moves = NULL;
-		possible_moves = find_possible_moves(board, possible_moves, piece_coordinate, &num_moves, game);
-		game->num_moves = num_moves;
-		game->possible_moves = possible_moves;
+		// Squares the clicked piece can move to, for the draw function
+		struct MoveList moves;
+		game_moves_from(chess, SQUARE(x, y), &moves);
+		game->targets = 0;
+		for (int i = 0; i < moves.count; ++i) game->targets |= BIT(MOVE_TO(moves.moves[i]));
 	} else { // Selecting place to move piece
 		// Deselects the selected piece
 		game->clicked_piece = false;
-		if (game->turn == 0) { // White Turn
-			// Tried to move white on white
-			if (piece > 5) return false;
-
-			// If the move position is valid, calls move, otherwise returns false
-			if (is_move_valid(board, piece_coordinate, move_coordinate, game)) {
-				move(board, piece_coordinate, move_coordinate);
-				game->turn = 1;
-			} else {
-				return false;
-			}
-		} else { // Black Turn
-			// Tried to move black on black
-			if (piece >= 0 && piece < 6) return false;
-
-			// If the move position is valid, calls move, otherwise returns false
-			if (is_move_valid(board, piece_coordinate, move_coordinate, game)) {
-				move(board, piece_coordinate, move_coordinate);
-				game->turn = 0;
-			} else {
-				return false;
-			}
-		}
+		game->dirty = true;
 
-		// After a move is done, checks if the king is in check and updates game->is_in_check
-		if (is_king_in_check(board, game)) {
-			game->is_in_check = true;
-			printf("King is in check by (%d, %d)\n", game->attacker_position[0], game->attacker_position[1]);
-		} else {
-			game->is_in_check = false;
-		}
+		// Tried to move on one of its own pieces
+		if (piece != EMPTY && PIECE_COLOR(piece) == chess->pos.side) return false;
+
+		// If the move position is valid, calls move, otherwise returns false
+		uint16_t m = find_valid_move(chess, piece_coordinate, move_coordinate);
+		if (m == MOVE_NONE) return false;
+
+		move(chess, m);
 	}
 
 	// Return true after the move was finished
 	return true;
 }
 
-void draw_board(Texture2D pieces[12], int board[8][8], struct GameState game)
+/*
+ * Copies the position to the clipboard or replaces it with the one in the clipboard.
+ *
+ * 'chess' The game being played.
+ * 'game' The current state of the screen.
+ *
+ */
+void handle_fen_keys(struct Game* chess, struct GameState* game)
 {
+	if (!IsKeyDown(KEY_LEFT_CONTROL) && !IsKeyDown(KEY_RIGHT_CONTROL)) return;
+
+	if (IsKeyPressed(KEY_C)) {
+		char fen[FEN_MAX_LENGTH];
+		position_to_fen(&chess->pos, fen);
+		SetClipboardText(fen);
+		printf("Copied %s\n", fen);
+	} else if (IsKeyPressed(KEY_V)) {
+		const char* fen = GetClipboardText();
+
+		// The game is only replaced if the FEN can be read
+		if (fen == NULL || !game_init_fen(chess, fen)) {
+			printf("The clipboard doesn't hold a valid FEN\n");
+			return;
+		}
+
+		game->clicked_piece = false;
+		game->dirty = true;
+		game->engine_dirty = true;
+		printf("Loaded %s\n", fen);
+	}
+}
+
+/*
+ * Draws the squares, the highlights and the pieces into 'target'. It only
+ * runs when the game state changes, every frame just copies the texture.
+ *
+ * 'target' The texture holding the board between two changes.
+ * 'atlas' The texture holding every piece.
+ * 'chess' The game being played.
+ * 'game' The current state of the screen.
+ *
+ */
+void render_board(RenderTexture2D target, Texture2D atlas, const struct Game* chess, const struct GameState* game)
+{
+	STATS_SCOPE(STATS_TIMER_RENDER_BOARD);
+
 	// Colors of each square
 	Color light_color = (Color) {240,217,183, 255};
 	Color dark_color = (Color) {180,135,103, 255};
 	Color last_move_color = (Color) {42, 75, 130, 255};
 	Color clicked_piece_color = (Color) {96, 136, 204, 255};
+	Color check_color = (Color) {200, 60, 60, 255};
+	Color hint_color = (Color) {106, 158, 84, 255};
+
+	// Squares painted in another color than their own
+	uint64_t last_move = chess->last_move != MOVE_NONE ? BIT(MOVE_FROM(chess->last_move)) | BIT(MOVE_TO(chess->last_move)) : 0;
+	uint64_t clicked = game->clicked_piece ? BIT(SQUARE(game->clicked_piece_pos[0], game->clicked_piece_pos[1])) : 0;
+	uint64_t check = chess->checkers ? BIT(chess->pos.kings[chess->pos.side]) : 0;
+	uint64_t targets = game->clicked_piece ? game->targets : 0;
+	uint16_t hint_move = game->engine_task == ENGINE_ANALYZE ? game->report.best_move : MOVE_NONE;
+	uint64_t hint = hint_move != MOVE_NONE ? BIT(MOVE_FROM(hint_move)) | BIT(MOVE_TO(hint_move)) : 0;
+
+	BeginTextureMode(target);
+	ClearBackground(RAYWHITE);
+
+	for (int sq = 0; sq < 64; ++sq) {
+		// Calculate the position of the square
+		int x = SQUARE_X(sq) * SQUARE_SIZE;
+		int y = SQUARE_Y(sq) * SQUARE_SIZE;
+		uint64_t bit = BIT(sq);
+
+		// Sets the color of each square based on position
+		Color color = (SQUARE_X(sq) + SQUARE_Y(sq)) % 2 == 0 ? dark_color : light_color;
+		if (last_move & bit) color = last_move_color;
+		else if (clicked & bit) color = clicked_piece_color;
+		else if (check & bit) color = check_color;
+		else if (hint & bit) color = hint_color;
+		DrawRectangle(x, y, SQUARE_SIZE, SQUARE_SIZE, color);
+
+		// Draw the piece on the square
+		int piece = chess->pos.squares[sq];
+		if (piece != EMPTY) {
+			Rectangle cell = {(float) (piece * ATLAS_CELL_SIZE), 0, ATLAS_CELL_SIZE, ATLAS_CELL_SIZE};
+			DrawTextureRec(atlas, cell, (Vector2){x, y}, WHITE);
+		}
 
-	// Iterates through the board
-	for (int i = 0; i < BOARD_SIZE; ++i) {
-		for (int j = 0; j < BOARD_SIZE; ++j) {
-			// Calculate the position of the square
-			int x = i * SQUARE_SIZE;
-			int y = j * SQUARE_SIZE;
-
-			// Sets the color of each square based on position
-			if (((i == last_moves[0][0] && j == last_moves[0][1]) || (i == last_moves[1][0] && j == last_moves[1][1])) && last_moves[0][0] != -1) {
-				// Paints the last move position
-				DrawRectangle(x, y, SQUARE_SIZE, SQUARE_SIZE, last_move_color);
-			} else if (game.clicked_piece && (i == game.clicked_piece_pos[0] && j == game.clicked_piece_pos[1])) {
-				// Paints the clicked piece position
-				DrawRectangle(x, y, SQUARE_SIZE, SQUARE_SIZE, clicked_piece_color);
-			} 
-			else {
-				// Paints the board
-				if ((i + j) % 2 == 0) {
-					DrawRectangle(x, y, SQUARE_SIZE, SQUARE_SIZE, dark_color);
-				} else {
-					DrawRectangle(x, y, SQUARE_SIZE, SQUARE_SIZE, light_color);
-				}
+		// Squares the selected piece can move to: a frame around captures, a dot on empty squares
+		if (targets & bit) {
+			if (piece != EMPTY) {
+				DrawRectangleLinesEx((Rectangle){x, y, SQUARE_SIZE, SQUARE_SIZE}, 3, RED);
+			} else {
+				Vector2 center = { (float)(x + SQUARE_SIZE/2), (float)(y + SQUARE_SIZE/2) };
+				DrawRing(center, 8.0, 0.0, 0, 360, 0, RED);
 			}
+		}
+	}
 
-			// Draw the pieces of each position
-			int piece = board[j][i];
-			if (piece != -1) DrawTexture(pieces[piece], x, y, WHITE);
-
-			// Draws all the position from the selected piece
-			if (game.clicked_piece == true) {
-				if (game.possible_moves != NULL && game.num_moves > 0) {
-					for (int k = 0; k < game.num_moves; ++k) {
-						int move_pos_x = game.possible_moves[k][0];
-						int move_pos_y = game.possible_moves[k][1];
-
-						if (i == move_pos_x && j == move_pos_y) {
-							if (board[j][i] != -1) {
-								DrawRectangleLinesEx((Rectangle){x, y, SQUARE_SIZE, SQUARE_SIZE}, 3, RED);
-							} else {
-								Vector2 center = { (float)(x + SQUARE_SIZE/2), (float)(y + SQUARE_SIZE/2) };
-								DrawRing(center, 8.0, 0.0, 0, 360, 0, RED);							
-							}
-						}
-					}
-				}
-			}
+	// Once the game is over the board stays as it is
+	if (chess->status != STATUS_PLAYING) {
+		const char* result = chess->status == STATUS_CHECKMATE ? "Checkmate"
+			: chess->status == STATUS_STALEMATE ? "Stalemate" : "Draw by repetition";
+		DrawText(result, (SCREEN_WIDTH - MeasureText(result, 40)) / 2, SCREEN_HEIGHT / 2 - 20, 40, RED);
+	}
+
+	EndTextureMode();
+}
+
+/*
+ * Draws the counters and timers over the board, the totals since the
+ * program started.
+ */
+void draw_stats_overlay(void)
+{
+	struct StatsTotals totals;
+	int font_size = 10;
+	int line = 12;
+	int y = 8;
+
+	DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, (Color) {0, 0, 0, 190});
+	if (!stats_enabled()) {
+		DrawText("Built without -DCHESS_STATS, nothing is counted", 8, y, font_size, RAYWHITE);
+		return;
+	}
+
+	stats_totals(&totals);
+	for (int i = 0; i < STATS_COUNTER_COUNT; ++i, y += line) {
+		DrawText(TextFormat("%-24s %llu", stats_counter_names[i], (unsigned long long) totals.counters[i]), 8, y, font_size, RAYWHITE);
+	}
+
+	y += line;
+	for (int i = 0; i < STATS_TIMER_COUNT; ++i, y += line) {
+		const struct StatsTimerTotals* timer = &totals.timers[i];
+		double average_us = timer->count > 0 ? timer->total_ns / 1e3 / timer->count : 0;
+		DrawText(TextFormat("%-24s %llu runs, %.2f us on average, %.2f us at most", stats_timer_names[i],
+			(unsigned long long) timer->count, average_us, timer->max_ns / 1e3), 8, y, font_size, RAYWHITE);
+	}
+
+	y += line;
+	DrawText(TextFormat("%d threads, %llu traced runs dropped", totals.threads, (unsigned long long) totals.dropped_events),
+		8, y, font_size, RAYWHITE);
+}
+
+/*
+ * Tells the engine what to do after the game changed: play if it is the
+ * computer's turn, otherwise show the hint or ponder on the reply it
+ * expects. The search in progress, if any, is stopped. When the move
+ * played is the expected reply, the ponder search goes on and plays.
+ *
+ * 'engine' The engine searching in the background.
+ * 'chess' The game being played.
+ * 'game' The current state of the screen.
+ *
+ */
+void sync_engine(struct Engine* engine, const struct Game* chess, struct GameState* game)
+{
+	static struct Game pondered;
+	const struct Game* searched = chess;
+	int task = ENGINE_IDLE;
+
+	if (chess->status != STATUS_PLAYING) {
+		task = ENGINE_IDLE;
+	} else if (chess->pos.side == game->computer) {
+		if (game->engine_task == ENGINE_PONDER && chess->last_move == game->ponder_move) {
+			engine_ponder_hit(engine, game->engine_generation, game->move_time_ms);
+			game->engine_task = ENGINE_PLAY;
+			game->engine_dirty = false;
+			return;
+		}
+		task = ENGINE_PLAY;
+	} else if (game->show_hint) {
+		task = ENGINE_ANALYZE;
+	} else if (game->computer >= 0 && game->ponder_move != MOVE_NONE) {
+		pondered = *chess;
+		if (game_play(&pondered, game->ponder_move) && pondered.status == STATUS_PLAYING) {
+			task = ENGINE_PONDER;
+			searched = &pondered;
 		}
 	}
+
+	// Tried again on the next frame if the request can't be sent yet
+	uint64_t generation = engine_start(engine, searched, task, game->move_time_ms);
+	if (generation == 0) return;
+
+	game->engine_generation = generation;
+	game->engine_task = task;
+	game->engine_dirty = false;
+	memset(&game->report, 0, sizeof(game->report));
+	game->dirty = true;
+}
+
+/*
+ * Takes the engine's reports, never waiting for one, and plays the
+ * computer's move once its search is over.
+ *
+ * 'engine' The engine searching in the background.
+ * 'chess' The game being played.
+ * 'game' The current state of the screen.
+ *
+ */
+void poll_engine(struct Engine* engine, struct Game* chess, struct GameState* game)
+{
+	struct EngineReport report;
+
+	while (engine_poll(engine, &report)) {
+		// Reports of searches stopped since are dropped
+		if (report.generation != game->engine_generation) continue;
+		if (report.best_move != game->report.best_move) game->dirty = true;
+		game->report = report;
+	}
+
+	// A ponder search can end before the reply is played, its move is kept until then
+	if (game->engine_task != ENGINE_PLAY || !game->report.final) return;
+
+	uint16_t m = game->report.best_move;
+	game->engine_task = ENGINE_IDLE;
+	if (m == MOVE_NONE || !movelist_contains(&chess->legal_moves, m)) return;
+
+	move(chess, m);
+	game->ponder_move = game->report.ponder_move;
+	game->clicked_piece = false;
+	game->dirty = true;
+	game->engine_dirty = true;
+}
+
+/*
+ * Writes what the engine is doing under the board: the depth, the score
+ * for White and the best move.
+ *
+ * 'chess' The game being played.
+ * 'game' The current state of the screen.
+ *
+ */
+void draw_engine_line(const struct Game* chess, const struct GameState* game)
+{
+	const struct EngineReport* report = &game->report;
+	const char* label = game->engine_task == ENGINE_ANALYZE ? "Hint"
+		: game->engine_task == ENGINE_PLAY ? "Thinking"
+		: game->engine_task == ENGINE_PONDER ? "Pondering" : NULL;
+	if (label == NULL || report->depth == 0) return;
+
+	// The ponder search is one move further, with the other player to move
+	int side = game->engine_task == ENGINE_PONDER ? !chess->pos.side : chess->pos.side;
+	int score = side == PLAYER_WHITE ? report->score : -report->score;
+	char move_name[6];
+	move_to_string(report->best_move, move_name);
+
+	const char* value;
+	if (score >= SCORE_MATE_BOUND) {
+		value = TextFormat("#%d", (SCORE_MATE - score + 1) / 2);
+	} else if (score <= -SCORE_MATE_BOUND) {
+		value = TextFormat("#-%d", (SCORE_MATE + score + 1) / 2);
+	} else {
+		value = TextFormat("%+.2f", score / 100.0);
+	}
+
+	const char* line = TextFormat("%s  depth %d  %s  %s", label, report->depth, value, move_name);
+	DrawRectangle(0, SCREEN_HEIGHT - 18, SCREEN_WIDTH, 18, (Color) {0, 0, 0, 160});
+	DrawText(line, 6, SCREEN_HEIGHT - 14, 10, RAYWHITE);
+}
+
+// Wall clock in milliseconds, for the startup probe
+static double now_ms(void)
+{
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/*
+ * Makes a sound from samples compiled in by gen_assets. raylib copies
+ * them, the static array is never freed.
+ */
+Sound load_embedded_sound(unsigned int frame_count, unsigned int sample_rate, unsigned int sample_size, unsigned int channels, void* data)
+{
+	Wave wave = {frame_count, sample_rate, sample_size, channels, data};
+
+	return LoadSoundFromWave(wave);
 }
 
 int main(int argc, char* argv[])
 {
+	double start_ms = now_ms();
+	const char* fen = NULL;
+	int computer = -1;
+	int64_t move_time_ms = DEFAULT_MOVE_TIME_MS;
+	int threads = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-computer") == 0 && i + 1 < argc) {
+			++i;
+			computer = strcmp(argv[i], "white") == 0 ? PLAYER_WHITE : strcmp(argv[i], "black") == 0 ? PLAYER_BLACK : -2;
+		} else if (strcmp(argv[i], "-movetime") == 0 && i + 1 < argc) {
+			move_time_ms = atoll(argv[++i]);
+		} else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (argv[i][0] != '-' && fen == NULL) {
+			fen = argv[i];
+		} else {
+			computer = -2;
+			break;
+		}
+	}
+
+	if (computer == -2) {
+		printf("Usage: %s [-computer white|black] [-movetime ms] [-threads n] [\"<fen>\"]\n", argv[0]);
+		return 1;
+	}
+	if (move_time_ms < 1) move_time_ms = 1;
+	if (threads < 1) threads = 1;
+
+	// A build made for BMI2 can't run on a processor without it
+	if (!slider_attacks_supported()) {
+		printf("This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
 	// Initialize game constants
-	struct GameState game = {0, false, {-1, -1}};
+	struct GameState game = {false, {-1, -1}};
+	game.computer = computer;
+	game.move_time_ms = move_time_ms;
+	game.engine_task = ENGINE_IDLE;
+
+	// Without the engine, the game is for two players and there is no hint
+	static struct Engine engine;
+	bool engine_ready = engine_init(&engine, ENGINE_HASH_MB, threads);
+	if (!engine_ready) {
+		printf("Can't start the engine, playing without it\n");
+		game.computer = -1;
+	}
 
 	// Create Window and init sounds
 	InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Chess");
 	InitAudioDevice();
 
-	// Load sounds
-	capture_sound = LoadSound("sounds/capture.mp3");
-	move_sound = LoadSound("sounds/move.mp3");
-
-	// Load texture of each piece
-	Texture2D pieces[12];
-	pieces[0] = LoadTexture("images/pawn_b.png");
-	pieces[1] = LoadTexture("images/knight_b.png");
-	pieces[2] = LoadTexture("images/bishop_b.png");
-	pieces[3] = LoadTexture("images/rook_b.png");
-	pieces[4] = LoadTexture("images/queen_b.png");
-	pieces[5] = LoadTexture("images/king_b.png");
-	pieces[6] = LoadTexture("images/pawn_w.png");
-	pieces[7] = LoadTexture("images/knight_w.png");
-	pieces[8] = LoadTexture("images/bishop_w.png");
-	pieces[9] = LoadTexture("images/rook_w.png");
-	pieces[10] = LoadTexture("images/queen_w.png");
-	pieces[11] = LoadTexture("images/king_w.png");
-
-	// Start position of the pieces on the chess board
-	int board[8][8] = {
-		{3, 1, 2, 4, 5, 2, 1, 3},
-		{0, 0, 0, 0, 0, 0, 0, 0},
-		{-1, -1, -1, -1, -1, -1, -1, -1},
-		{-1, -1, -1, -1, -1, -1, -1, -1},
-		{-1, -1, -1, -1, -1, -1, -1, -1},
-		{-1, -1, -1, -1, -1, -1, -1, -1},
-		{6, 6, 6, 6, 6, 6, 6, 6},
-		{9, 7, 8, 10, 11, 8, 7, 9}
-	};
+	double window_ms = now_ms();
+
+	// One texture upload for all the pieces, and sounds that need no decoding
+	Image atlas_image = {PIECE_ATLAS_DATA, PIECE_ATLAS_WIDTH, PIECE_ATLAS_HEIGHT, 1, PIECE_ATLAS_FORMAT};
+	Texture2D atlas = LoadTextureFromImage(atlas_image);
+	capture_sound = load_embedded_sound(CAPTURE_SOUND_FRAME_COUNT, CAPTURE_SOUND_SAMPLE_RATE,
+		CAPTURE_SOUND_SAMPLE_SIZE, CAPTURE_SOUND_CHANNELS, CAPTURE_SOUND_DATA);
+	move_sound = load_embedded_sound(MOVE_SOUND_FRAME_COUNT, MOVE_SOUND_SAMPLE_RATE,
+		MOVE_SOUND_SAMPLE_SIZE, MOVE_SOUND_CHANNELS, MOVE_SOUND_DATA);
+	double assets_ms = now_ms();
+
+	// Rules of the game being played, from the position given on the command line if any
+	struct Game chess;
+	if (fen == NULL || !game_init_fen(&chess, fen)) {
+		if (fen != NULL) printf("Invalid FEN, starting from the usual position: %s\n", fen);
+		game_init_fen(&chess, START_FEN);
+	}
+	game.engine_dirty = engine_ready;
+
+	// The board is drawn once into a texture and again only when something changes
+	RenderTexture2D board = LoadRenderTexture(SCREEN_WIDTH, SCREEN_HEIGHT);
+	game.dirty = true;
+
+	// Sleep until there is input instead of drawing frames nobody needs, but keep
+	// drawing while the overlay or the engine's reports change on their own
+	SetTargetFPS(MAX_FPS);
+	EnableEventWaiting();
+	bool waiting_events = true;
+
+	// Coordinates for moves and selected pieces
+	int move_coordinate[2];
+	int piece_coordinate[2];
 
 	// Game main loop
 	while (!WindowShouldClose()) {
-		// TODO: If it's a checkmate game must end
-
-		// Calls raylib's draw function and paints background white
-		BeginDrawing();
-		ClearBackground(RAYWHITE);
+		STATS_SCOPE(STATS_TIMER_FRAME);
 
-		// Draw the board
-		draw_board(pieces, board, game);
+		// Ctrl+C and Ctrl+V
+		handle_fen_keys(&chess, &game);
 
-		// Coordinates for moves and selected pieces
-		int move_coordinate[2];
-		int piece_coordinate[2];
+		if (IsKeyPressed(KEY_F3)) game.show_stats = !game.show_stats;
+		if (IsKeyPressed(KEY_H) && engine_ready) {
+			game.show_hint = !game.show_hint;
+			game.engine_dirty = true;
+		}
 
 		// If the player clicks on the screen, puts the position at 'move_coordinate'
-		if (handle_click(move_coordinate)) {
+		// The computer's pieces aren't for the player to move
+		if (chess.status == STATUS_PLAYING && chess.pos.side != game.computer && handle_click(move_coordinate)) {
+			int ply = chess.ply;
+
 			// Checks if the click on the screen is a valid click
 			// If it's valid, either select the piece or do the desired move
-			if (!is_click_valid(board, piece_coordinate, move_coordinate, &game)) {
+			if (!is_click_valid(&chess, piece_coordinate, move_coordinate, &game)) {
 				printf("Invalid move (%d, %d)\n", move_coordinate[0], move_coordinate[1]);
 			}
+			if (chess.ply != ply) game.engine_dirty = true;
+		}
+
+		if (engine_ready) {
+			if (game.engine_dirty) sync_engine(&engine, &chess, &game);
+			poll_engine(&engine, &chess, &game);
+		}
+
+		bool live = game.show_stats || game.engine_task != ENGINE_IDLE || game.engine_dirty;
+		if (live == waiting_events) {
+			waiting_events = !live;
+			if (waiting_events) {
+				EnableEventWaiting();
+			} else {
+				DisableEventWaiting();
+			}
+		}
+
+		if (game.dirty) {
+			render_board(board, atlas, &chess, &game);
+			game.dirty = false;
 		}
 
-		// Calls raylib's function to finish drawing
+		// Render textures are stored upside down, hence the negative height
+		BeginDrawing();
+		DrawTextureRec(board.texture, (Rectangle){0, 0, SCREEN_WIDTH, -SCREEN_HEIGHT}, (Vector2){0, 0}, WHITE);
+		draw_engine_line(&chess, &game);
+		if (game.show_stats) draw_stats_overlay();
 		EndDrawing();
+
+		// Startup probe: where the time goes before the first frame is on screen
+		if (start_ms > 0) {
+			printf("Startup: window and audio %.1f ms, assets %.1f ms, first frame %.1f ms, total %.1f ms\n",
+				window_ms - start_ms, assets_ms - window_ms, now_ms() - assets_ms, now_ms() - start_ms);
+			start_ms = 0;
+		}
+	}
+
+	if (stats_enabled()) {
+		if (stats_write_trace(STATS_TRACE_PATH)) {
+			printf("Trace written to %s\n", STATS_TRACE_PATH);
+		} else {
+			printf("Can't write the trace to %s\n", STATS_TRACE_PATH);
+		}
 	}
 
 	// Clean up resources
+	if (engine_ready) engine_free(&engine);
+	UnloadRenderTexture(board);
+	UnloadTexture(atlas);
 	UnloadSound(capture_sound);
 	UnloadSound(move_sound);
 	CloseAudioDevice();
@@ -0,0 +1,883 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o match match.c position.c movegen.c game.c zobrist.c magic.c notation.c eval.c bitbase.c stats.c -lm
+// ./match -engine ./uci -engine ./old_uci                100 games at 100 ms a move
+// ./match -engine ./uci -engine ./old_uci -openings openings.epd -games 10000 -nodes 20000 -pgn match.pgn
+// ./match -engine ./uci -engine ./old_uci -option Hash=16 -concurrency 16 -sprt 0 5
+//                                              stops once the test says the first engine is 0 or 5 Elo stronger
+
+/*
+ * Plays two UCI engines against each other, many games at once. Every
+ * worker thread runs its own copy of both engines as child processes and
+ * plays one game at a time with them, taking the next game of the match
+ * when it is done, so '-concurrency' games are always going on.
+ *
+ * The games start from the positions of the openings file, FEN or EPD,
+ * one a line, or from the starting position without one. Every opening is
+ * played twice, once with each engine as white. Each move is searched to
+ * a fixed number of nodes, a fixed depth or for a fixed time. The runner
+ * plays the moves with the rules of 'struct Game' and ends the game itself
+ * on checkmate, stalemate, repetition, the fifty-move rule, the move limit
+ * or a position the bitbases know (see gen_bitbase.c). An engine that
+ * plays an illegal move, runs out of time or stops answering loses; one
+ * that stopped is started again for the next game.
+ *
+ * Every game goes to the PGN file and a line of standard output as soon
+ * as it ends, so a long match can be followed or cut short without losing
+ * anything. The score is the first engine's, with its Elo difference and
+ * likelihood of superiority. With '-sprt', the match stops as soon as the
+ * sequential probability ratio test (alpha = beta = 0.05) decides between
+ * the two Elo differences. At the end, the nodes every engine searched by
+ * second of thinking, and all of them together by second of the match.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "position.h"
+#include "movegen.h"
+#include "game.h"
+#include "notation.h"
+#include "gamefile.h"
+#include "bitbase.h"
+
+// Longest line read from an engine, longer ones are cut
+#define LINE_SIZE 8192
+
+// Time an engine gets to answer 'uci' and 'isready'
+#define HANDSHAKE_TIMEOUT_MS 10000
+
+// Time an engine gets to quit before it is killed
+#define QUIT_TIMEOUT_MS 1000
+
+#define MAX_OPTIONS 32
+#define DEFAULT_MAX_PLIES 400
+
+// The 'position' command of the longest game
+#define POSITION_SIZE (32 + FEN_MAX_LENGTH + MAX_GAME_PLIES * 6)
+
+#define SPRT_ALPHA 0.05
+#define SPRT_BETA 0.05
+
+// PGN lines are kept under 80 characters
+#define PGN_LINE_LENGTH 79
+
+static const char* result_names[] = {"*", "1-0", "0-1", "1/2-1/2"};
+
+// Ways an engine loses without a move of its own
+enum Failure {
+	FAILURE_DISCONNECTED,
+	FAILURE_TIME,
+	FAILURE_ILLEGAL_MOVE
+};
+
+// Why the game ended, by side (black first) and failure
+static const char* const failure_reasons[2][3] = {
+	{"black disconnects", "black loses on time", "black plays an illegal move"},
+	{"white disconnects", "white loses on time", "white plays an illegal move"},
+};
+
+// An engine running as a child process, talking through two pipes
+struct Process {
+	pid_t pid;					// 0 when not running
+	int input;					// the engine's standard input
+	int output;					// the engine's standard output
+	char buffer[LINE_SIZE];		// read from 'output', not taken as lines yet
+	size_t length;
+};
+
+struct Match {
+	const char* commands[2];
+	char names[2][64];			// from 'id name', the command until an engine says it
+	const char* options[MAX_OPTIONS];	// 'name=value', sent to both engines
+	int option_count;
+
+	char** openings;
+	int opening_count;
+	int games;
+	char go[64];				// the 'go' command of every move
+	int64_t move_timeout_ms;	// past which an engine loses on time
+	int max_plies;
+	struct Bitbases bitbases;
+	bool sprt;
+	double elo0;
+	double elo1;
+	char date[16];				// of the match, for the PGN
+
+	_Atomic int next_game;
+	atomic_bool stop;			// no new game is started once set
+
+	pthread_mutex_t mutex;		// for everything below
+	FILE* pgn;
+	int played;
+	int wins;					// of the first engine
+	int draws;
+	int losses;
+	uint64_t nodes[2];
+	int64_t thinking_ms[2];
+	int64_t start_ms;
+	int verdict;				// of the SPRT: 1 for elo1, -1 for elo0, 0 while undecided
+};
+
+struct Worker {
+	struct Match* match;
+	pthread_t thread;
+	struct Process processes[2];	// of the first and second engine
+	struct Game game;
+	char position[POSITION_SIZE];	// the 'position' command of the game so far
+	size_t position_length;
+	uint64_t nodes[2];				// of the game
+	int64_t thinking_ms[2];
+};
+
+// Spawning is serialized, so no child inherits the pipes of another engine before they are marked close-on-exec
+static pthread_mutex_t spawn_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int64_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool process_start(struct Process* process, const char* command)
+{
+	int to_engine[2];
+	int from_engine[2];
+
+	pthread_mutex_lock(&spawn_mutex);
+	if (pipe(to_engine) != 0) {
+		pthread_mutex_unlock(&spawn_mutex);
+		return false;
+	}
+	if (pipe(from_engine) != 0) {
+		close(to_engine[0]);
+		close(to_engine[1]);
+		pthread_mutex_unlock(&spawn_mutex);
+		return false;
+	}
+
+	pid_t pid = fork();
+	if (pid == 0) {
+		dup2(to_engine[0], STDIN_FILENO);
+		dup2(from_engine[1], STDOUT_FILENO);
+		close(to_engine[0]);
+		close(to_engine[1]);
+		close(from_engine[0]);
+		close(from_engine[1]);
+		execl("/bin/sh", "sh", "-c", command, (char*) NULL);
+		_exit(127);
+	}
+
+	close(to_engine[0]);
+	close(from_engine[1]);
+	if (pid < 0) {
+		close(to_engine[1]);
+		close(from_engine[0]);
+		pthread_mutex_unlock(&spawn_mutex);
+		return false;
+	}
+	fcntl(to_engine[1], F_SETFD, FD_CLOEXEC);
+	fcntl(from_engine[0], F_SETFD, FD_CLOEXEC);
+	pthread_mutex_unlock(&spawn_mutex);
+
+	process->pid = pid;
+	process->input = to_engine[1];
+	process->output = from_engine[0];
+	process->length = 0;
+
+	return true;
+}
+
+static bool process_send(struct Process* process, const char* format, ...)
+{
+	char line[POSITION_SIZE + 2];
+	va_list args;
+
+	va_start(args, format);
+	int length = vsnprintf(line, sizeof(line) - 1, format, args);
+	va_end(args);
+	if (length < 0 || length >= (int) sizeof(line) - 1) return false;
+	line[length++] = '\n';
+
+	for (int written = 0; written < length;) {
+		ssize_t n = write(process->input, line + written, (size_t) (length - written));
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		written += (int) n;
+	}
+
+	return true;
+}
+
+// Asks the engine to quit, kills it if it doesn't
+static void process_stop(struct Process* process, bool ask)
+{
+	if (process->pid == 0) return;
+
+	if (ask && process_send(process, "quit")) {
+		int64_t deadline = now_ms() + QUIT_TIMEOUT_MS;
+		while (now_ms() < deadline) {
+			if (waitpid(process->pid, NULL, WNOHANG) == process->pid) {
+				process->pid = 0;
+				break;
+			}
+			nanosleep(&(struct timespec) {0, 10000000}, NULL);
+		}
+	}
+
+	if (process->pid != 0) {
+		kill(process->pid, SIGKILL);
+		waitpid(process->pid, NULL, 0);
+		process->pid = 0;
+	}
+	close(process->input);
+	close(process->output);
+}
+
+// Next line the engine wrote, without its end; false if it doesn't come by 'deadline' or the engine is gone
+static bool process_read_line(struct Process* process, char* line, int64_t deadline)
+{
+	for (;;) {
+		char* end = memchr(process->buffer, '\n', process->length);
+		if (end != NULL || process->length == sizeof(process->buffer)) {
+			size_t length = end != NULL ? (size_t) (end - process->buffer) : process->length;
+			size_t taken = end != NULL ? length + 1 : length;
+			if (length > 0 && process->buffer[length - 1] == '\r') --length;
+
+			memcpy(line, process->buffer, length);
+			line[length] = '\0';
+			memmove(process->buffer, process->buffer + taken, process->length - taken);
+			process->length -= taken;
+			return true;
+		}
+
+		int64_t left = deadline - now_ms();
+		if (left <= 0) return false;
+
+		struct pollfd fd = {process->output, POLLIN, 0};
+		int ready = poll(&fd, 1, (int) left);
+		if (ready < 0 && errno == EINTR) continue;
+		if (ready <= 0) return false;
+
+		ssize_t n = read(process->output, process->buffer + process->length, sizeof(process->buffer) - process->length);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		process->length += (size_t) n;
+	}
+}
+
+// Reads lines until one starts with 'word'
+static bool process_wait_for(struct Process* process, const char* word, char* line, int64_t deadline)
+{
+	size_t length = strlen(word);
+
+	while (process_read_line(process, line, deadline)) {
+		if (strncmp(line, word, length) == 0 && (line[length] == '\0' || line[length] == ' ')) return true;
+	}
+
+	return false;
+}
+
+// Starts 'engine' for the worker and sets its options, ready for a game
+static bool open_engine(struct Worker* worker, int engine)
+{
+	struct Match* match = worker->match;
+	struct Process* process = &worker->processes[engine];
+	char line[LINE_SIZE];
+
+	if (!process_start(process, match->commands[engine])) return false;
+
+	int64_t deadline = now_ms() + HANDSHAKE_TIMEOUT_MS;
+	bool ok = process_send(process, "uci");
+	while (ok && (ok = process_read_line(process, line, deadline)) && strcmp(line, "uciok") != 0) {
+		if (strncmp(line, "id name ", 8) == 0) {
+			pthread_mutex_lock(&match->mutex);
+			snprintf(match->names[engine], sizeof(match->names[engine]), "%.*s", (int) sizeof(match->names[engine]) - 1, line + 8);
+			pthread_mutex_unlock(&match->mutex);
+		}
+	}
+
+	for (int i = 0; ok && i < match->option_count; ++i) {
+		const char* equals = strchr(match->options[i], '=');
+		ok = process_send(process, "setoption name %.*s value %s",
+			(int) (equals - match->options[i]), match->options[i], equals + 1);
+	}
+
+	if (!ok) process_stop(process, false);
+	return ok;
+}
+
+/*
+ * Result of the game as it stands, as a GAME_RESULT_*, and why it ended;
+ * GAME_RESULT_UNKNOWN while it goes on.
+ */
+static int adjudicate(const struct Match* match, const struct Game* game, const char** reason)
+{
+	const struct Position* pos = &game->pos;
+
+	if (game->status == STATUS_CHECKMATE) {
+		*reason = pos->side == PLAYER_WHITE ? "black mates" : "white mates";
+		return pos->side == PLAYER_WHITE ? GAME_RESULT_BLACK_WINS : GAME_RESULT_WHITE_WINS;
+	}
+	if (game->status == STATUS_STALEMATE) {
+		*reason = "stalemate";
+		return GAME_RESULT_DRAW;
+	}
+	if (game->status == STATUS_DRAW_REPETITION) {
+		*reason = "threefold repetition";
+		return GAME_RESULT_DRAW;
+	}
+	if (pos->halfmove_clock >= 100) {
+		*reason = "fifty-move rule";
+		return GAME_RESULT_DRAW;
+	}
+
+	int result = bitbase_result(&match->bitbases, pos);
+	if (result != GAME_RESULT_UNKNOWN) {
+		*reason = result == GAME_RESULT_DRAW ? "theoretical draw" : "theoretical win";
+		return result;
+	}
+
+	if (game->ply >= match->max_plies) {
+		*reason = "move limit";
+		return GAME_RESULT_DRAW;
+	}
+
+	return GAME_RESULT_UNKNOWN;
+}
+
+static void append_move(struct Worker* worker, uint16_t m)
+{
+	char str[6];
+
+	move_to_string(m, str);
+	worker->position_length += (size_t) sprintf(worker->position + worker->position_length, "%s%s",
+		worker->game.ply == 1 ? " moves " : " ", str);
+}
+
+// Move of 'engine' in the current position, MOVE_NONE if it doesn't give a legal one; 'failure' says why
+static uint16_t think(struct Worker* worker, int engine, enum Failure* failure)
+{
+	struct Match* match = worker->match;
+	struct Process* process = &worker->processes[engine];
+	char line[LINE_SIZE];
+	uint64_t nodes = 0;
+
+	int64_t start = now_ms();
+	int64_t deadline = start + match->move_timeout_ms;
+	if (!process_send(process, "%s", worker->position) || !process_send(process, "%s", match->go)) {
+		*failure = FAILURE_DISCONNECTED;
+		process_stop(process, false);
+		return MOVE_NONE;
+	}
+
+	for (;;) {
+		if (!process_read_line(process, line, deadline)) {
+			*failure = now_ms() >= deadline ? FAILURE_TIME : FAILURE_DISCONNECTED;
+			process_stop(process, false);
+			return MOVE_NONE;
+		}
+
+		if (strncmp(line, "info ", 5) == 0) {
+			// The last count of the search is the one that matters
+			const char* found = strstr(line, " nodes ");
+			if (found != NULL) nodes = strtoull(found + 7, NULL, 10);
+		} else if (strncmp(line, "bestmove", 8) == 0) {
+			break;
+		}
+	}
+
+	worker->thinking_ms[engine] += now_ms() - start;
+	worker->nodes[engine] += nodes;
+
+	char* save;
+	strtok_r(line, " ", &save);
+	const char* token = strtok_r(NULL, " ", &save);
+	uint16_t m = token != NULL ? move_from_string(&worker->game.pos, token) : MOVE_NONE;
+	if (m == MOVE_NONE) *failure = FAILURE_ILLEGAL_MOVE;
+
+	return m;
+}
+
+// Writes the game in PGN, the moves in SAN from 'fen'
+static void write_pgn(FILE* out, const struct Match* match, int index, int white, const char* fen,
+	const struct Game* game, int result, const char* reason)
+{
+	struct Position pos;
+	struct Undo undo;
+	int column = 0;
+
+	position_from_fen(&pos, fen);
+
+	fprintf(out, "[Event \"%s vs %s\"]\n[Site \"?\"]\n[Date \"%s\"]\n[Round \"%d\"]\n",
+		match->names[0], match->names[1], match->date, index + 1);
+	fprintf(out, "[White \"%s\"]\n[Black \"%s\"]\n[Result \"%s\"]\n", match->names[white], match->names[!white], result_names[result]);
+	if (match->openings != NULL) fprintf(out, "[SetUp \"1\"]\n[FEN \"%s\"]\n", fen);
+	fprintf(out, "[PlyCount \"%d\"]\n\n", game->ply);
+
+	for (int ply = 0; ply < game->ply; ++ply) {
+		uint16_t m = game->moves[ply];
+		char token[32];
+		char san[SAN_MAX_LENGTH];
+		int length = 0;
+
+		move_to_san(&pos, m, san);
+		if (pos.side == PLAYER_WHITE) length = sprintf(token, "%d. %s", pos.fullmove, san);
+		else if (ply == 0) length = sprintf(token, "%d... %s", pos.fullmove, san);
+		else length = sprintf(token, "%s", san);
+
+		if (column > 0 && column + 1 + length > PGN_LINE_LENGTH) {
+			fputc('\n', out);
+			column = 0;
+		}
+		column += fprintf(out, "%s%s", column > 0 ? " " : "", token);
+
+		make_move(&pos, m, &undo);
+	}
+
+	char comment[80];
+	int length = snprintf(comment, sizeof(comment), "{%s} %s", reason, result_names[result]);
+	if (column > 0 && column + 1 + length > PGN_LINE_LENGTH) {
+		fputc('\n', out);
+		column = 0;
+	}
+	fprintf(out, "%s%s\n\n", column > 0 ? " " : "", comment);
+}
+
+static double elo_from_score(double score)
+{
+	return -400 * log10(1 / score - 1);
+}
+
+static double score_from_elo(double elo)
+{
+	return 1 / (1 + pow(10, -elo / 400));
+}
+
+// Variance of the score of one game, around the mean 'score'
+static double score_variance(int wins, int draws, int losses, double score)
+{
+	int games = wins + draws + losses;
+
+	return (wins * (1 - score) * (1 - score) + draws * (0.5 - score) * (0.5 - score) + losses * score * score) / games;
+}
+
+/*
+ * Log-likelihood ratio of 'elo1' against 'elo0', with the score of a game
+ * taken as normally distributed (the approximation of the generalized
+ * SPRT, which holds from a few dozen games on).
+ */
+static double sprt_llr(int wins, int draws, int losses, double elo0, double elo1)
+{
+	int games = wins + draws + losses;
+	if (games == 0) return 0;
+
+	double score = (wins + draws / 2.0) / games;
+	double variance = score_variance(wins, draws, losses, score);
+	if (variance <= 0) return 0;
+
+	double s0 = score_from_elo(elo0);
+	double s1 = score_from_elo(elo1);
+
+	return games * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance);
+}
+
+// Elo difference with the half width of its 95% interval, infinite without games or when every game was won or lost
+static void elo_estimate(int wins, int draws, int losses, double* elo, double* error)
+{
+	int games = wins + draws + losses;
+	double score = games > 0 ? (wins + draws / 2.0) / games : 0.5;
+
+	if (games == 0 || score <= 0 || score >= 1) {
+		*elo = games == 0 ? 0 : score <= 0 ? -INFINITY : INFINITY;
+		*error = INFINITY;
+		return;
+	}
+
+	double deviation = sqrt(score_variance(wins, draws, losses, score) / games);
+	double low = fmax(score - 1.959964 * deviation, 1e-9);
+	double high = fmin(score + 1.959964 * deviation, 1 - 1e-9);
+
+	*elo = elo_from_score(score);
+	*error = (elo_from_score(high) - elo_from_score(low)) / 2;
+}
+
+// Probability that the first engine is the stronger one
+static double likelihood_of_superiority(int wins, int losses)
+{
+	if (wins + losses == 0) return 0.5;
+
+	return 0.5 * (1 + erf((wins - losses) / sqrt(2.0 * (wins + losses))));
+}
+
+// Counts the finished game and streams it out
+static void record_game(struct Worker* worker, int index, int white, const char* fen, int result, const char* reason)
+{
+	struct Match* match = worker->match;
+	double lower = log(SPRT_BETA / (1 - SPRT_ALPHA));
+	double upper = log((1 - SPRT_BETA) / SPRT_ALPHA);
+
+	pthread_mutex_lock(&match->mutex);
+
+	if (result == GAME_RESULT_DRAW) {
+		++match->draws;
+	} else if ((result == GAME_RESULT_WHITE_WINS) == (white == 0)) {
+		++match->wins;
+	} else {
+		++match->losses;
+	}
+	++match->played;
+	for (int engine = 0; engine < 2; ++engine) {
+		match->nodes[engine] += worker->nodes[engine];
+		match->thinking_ms[engine] += worker->thinking_ms[engine];
+	}
+
+	if (match->pgn != NULL) {
+		write_pgn(match->pgn, match, index, white, fen, &worker->game, result, reason);
+		fflush(match->pgn);
+	}
+
+	int games = match->wins + match->draws + match->losses;
+	printf("Game %d (%s vs %s): %s {%s}, score %d - %d - %d [%.3f] %d",
+		index + 1, match->names[white], match->names[!white], result_names[result], reason,
+		match->wins, match->losses, match->draws, (match->wins + match->draws / 2.0) / games, games);
+	if (match->sprt) {
+		double llr = sprt_llr(match->wins, match->draws, match->losses, match->elo0, match->elo1);
+		printf(", LLR %.2f (%.2f, %.2f)", llr, lower, upper);
+		if (match->verdict == 0 && (llr >= upper || llr <= lower)) {
+			match->verdict = llr >= upper ? 1 : -1;
+			atomic_store(&match->stop, true);
+		}
+	}
+	printf("\n");
+	fflush(stdout);
+
+	pthread_mutex_unlock(&match->mutex);
+}
+
+// Plays game 'index' of the match, returns false if an engine can't be started
+static bool play_game(struct Worker* worker, int index)
+{
+	struct Match* match = worker->match;
+	struct Game* game = &worker->game;
+	const char* fen = match->openings != NULL ? match->openings[index / 2 % match->opening_count] : START_FEN;
+	int white = index % 2;		// the engine playing white, the first one in even games
+	const char* reason = NULL;
+	int result = GAME_RESULT_UNKNOWN;
+	char line[LINE_SIZE];
+
+	memset(worker->nodes, 0, sizeof(worker->nodes));
+	memset(worker->thinking_ms, 0, sizeof(worker->thinking_ms));
+	game_init_fen(game, fen);
+	worker->position_length = (size_t) sprintf(worker->position, "position fen %s", fen);
+
+	// An engine that won't get ready loses the game without a move
+	for (int engine = 0; engine < 2 && result == GAME_RESULT_UNKNOWN; ++engine) {
+		struct Process* process = &worker->processes[engine];
+		if (process->pid == 0 && !open_engine(worker, engine)) {
+			fprintf(stderr, "Can't start %s\n", match->commands[engine]);
+			return false;
+		}
+
+		bool ready = process_send(process, "ucinewgame") && process_send(process, "isready")
+			&& process_wait_for(process, "readyok", line, now_ms() + HANDSHAKE_TIMEOUT_MS);
+		if (!ready) {
+			process_stop(process, false);
+			reason = engine == white ? "white doesn't get ready" : "black doesn't get ready";
+			result = engine == white ? GAME_RESULT_BLACK_WINS : GAME_RESULT_WHITE_WINS;
+		}
+	}
+
+	while (result == GAME_RESULT_UNKNOWN && (result = adjudicate(match, game, &reason)) == GAME_RESULT_UNKNOWN) {
+		int side = game->pos.side;
+		int engine = side == PLAYER_WHITE ? white : !white;
+		enum Failure failure;
+
+		uint16_t m = think(worker, engine, &failure);
+		if (m == MOVE_NONE) {
+			reason = failure_reasons[side][failure];
+			result = side == PLAYER_WHITE ? GAME_RESULT_BLACK_WINS : GAME_RESULT_WHITE_WINS;
+			break;
+		}
+
+		game_play(game, m);
+		append_move(worker, m);
+	}
+
+	record_game(worker, index, white, fen, result, reason);
+	return true;
+}
+
+static void* worker_main(void* data)
+{
+	struct Worker* worker = data;
+	struct Match* match = worker->match;
+
+	while (!atomic_load(&match->stop)) {
+		int index = atomic_fetch_add(&match->next_game, 1);
+		if (index >= match->games) break;
+
+		if (!play_game(worker, index)) {
+			atomic_store(&match->stop, true);
+			break;
+		}
+	}
+
+	for (int engine = 0; engine < 2; ++engine) process_stop(&worker->processes[engine], true);
+
+	return NULL;
+}
+
+/*
+ * Reads the openings, FEN or EPD: the first four fields, and the move
+ * counters if they follow. Returns how many were read, -1 if the file
+ * can't be opened.
+ */
+static int read_openings(const char* path, char*** openings)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL) return -1;
+
+	char line[512];
+	int count = 0;
+	int capacity = 0;
+	int number = 0;
+	*openings = NULL;
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		char* fields[6];
+		char* save;
+		int field_count = 0;
+		++number;
+
+		char* semicolon = strchr(line, ';');
+		if (semicolon != NULL) *semicolon = '\0';
+		for (char* field = strtok_r(line, " \t\r\n", &save); field != NULL && field_count < 6; field = strtok_r(NULL, " \t\r\n", &save)) {
+			fields[field_count++] = field;
+		}
+		if (field_count == 0 || fields[0][0] == '#') continue;
+
+		// EPD operations take the place of the counters
+		int kept = field_count < 4 ? field_count : 4;
+		if (field_count == 6 && strspn(fields[4], "0123456789") == strlen(fields[4]) && strspn(fields[5], "0123456789") == strlen(fields[5])) {
+			kept = 6;
+		}
+
+		char fen[FEN_MAX_LENGTH];
+		int length = 0;
+		for (int i = 0; i < kept; ++i) {
+			length += snprintf(fen + length, sizeof(fen) - (size_t) length, "%s%s", i > 0 ? " " : "", fields[i]);
+		}
+
+		struct Position pos;
+		if (length >= (int) sizeof(fen) || !position_from_fen(&pos, fen)) {
+			fprintf(stderr, "%s:%d: invalid position\n", path, number);
+			continue;
+		}
+
+		if (count == capacity) {
+			capacity = capacity > 0 ? capacity * 2 : 256;
+			char** grown = realloc(*openings, (size_t) capacity * sizeof(*grown));
+			if (grown == NULL) break;
+			*openings = grown;
+		}
+		// Written back in full, for the FEN tags of the games
+		position_to_fen(&pos, fen);
+		(*openings)[count] = malloc(strlen(fen) + 1);
+		if ((*openings)[count] == NULL) break;
+		strcpy((*openings)[count++], fen);
+	}
+
+	fclose(file);
+	return count;
+}
+
+static void print_summary(struct Match* match, int concurrency)
+{
+	double elapsed = (now_ms() - match->start_ms) / 1000.0;
+	int games = match->wins + match->draws + match->losses;
+	double elo;
+	double error;
+
+	elo_estimate(match->wins, match->draws, match->losses, &elo, &error);
+
+	printf("\nScore of %s vs %s: %d - %d - %d [%.3f] %d\n", match->names[0], match->names[1],
+		match->wins, match->losses, match->draws, games > 0 ? (match->wins + match->draws / 2.0) / games : 0.5, games);
+	printf("Elo difference: %+.1f +/- %.1f, LOS: %.1f %%, draw ratio: %.1f %%\n", elo, error,
+		100 * likelihood_of_superiority(match->wins, match->losses), games > 0 ? 100.0 * match->draws / games : 0);
+
+	if (match->sprt) {
+		double llr = sprt_llr(match->wins, match->draws, match->losses, match->elo0, match->elo1);
+		printf("SPRT [%.1f, %.1f]: LLR %.2f (%.2f, %.2f), %s\n", match->elo0, match->elo1, llr,
+			log(SPRT_BETA / (1 - SPRT_ALPHA)), log((1 - SPRT_BETA) / SPRT_ALPHA),
+			match->verdict > 0 ? "H1 accepted" : match->verdict < 0 ? "H0 accepted" : "no decision");
+	}
+
+	uint64_t nodes = 0;
+	for (int engine = 0; engine < 2; ++engine) {
+		double seconds = match->thinking_ms[engine] / 1000.0;
+		printf("%s: %" PRIu64 " nodes in %.1f s of thinking, %.0f nodes/s\n", match->names[engine],
+			match->nodes[engine], seconds, seconds > 0 ? match->nodes[engine] / seconds : 0);
+		nodes += match->nodes[engine];
+	}
+	printf("All games: %" PRIu64 " nodes in %.1f s, %.0f nodes/s with %d games at once\n",
+		nodes, elapsed, elapsed > 0 ? nodes / elapsed : 0, concurrency);
+}
+
+int main(int argc, char* argv[])
+{
+	static struct Match match;
+	long concurrency = sysconf(_SC_NPROCESSORS_ONLN);
+	const char* openings_path = NULL;
+	const char* pgn_path = NULL;
+	const char* bitbase_dir = NULL;
+	long nodes = 0;
+	long depth = 0;
+	long movetime = 0;
+	long timeout = -1;
+	int engine_count = 0;
+	bool usage = false;
+
+	match.games = 100;
+	match.max_plies = DEFAULT_MAX_PLIES;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-engine") == 0 && i + 1 < argc && engine_count < 2) {
+			match.commands[engine_count++] = argv[++i];
+		} else if (strcmp(argv[i], "-option") == 0 && i + 1 < argc && match.option_count < MAX_OPTIONS && strchr(argv[i + 1], '=') != NULL) {
+			match.options[match.option_count++] = argv[++i];
+		} else if (strcmp(argv[i], "-openings") == 0 && i + 1 < argc) {
+			openings_path = argv[++i];
+		} else if (strcmp(argv[i], "-games") == 0 && i + 1 < argc) {
+			match.games = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-concurrency") == 0 && i + 1 < argc) {
+			concurrency = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-nodes") == 0 && i + 1 < argc) {
+			nodes = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc) {
+			depth = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-movetime") == 0 && i + 1 < argc) {
+			movetime = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-timeout") == 0 && i + 1 < argc) {
+			timeout = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-maxplies") == 0 && i + 1 < argc) {
+			match.max_plies = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-bitbases") == 0 && i + 1 < argc) {
+			bitbase_dir = argv[++i];
+		} else if (strcmp(argv[i], "-pgn") == 0 && i + 1 < argc) {
+			pgn_path = argv[++i];
+		} else if (strcmp(argv[i], "-sprt") == 0 && i + 2 < argc) {
+			match.sprt = true;
+			match.elo0 = atof(argv[++i]);
+			match.elo1 = atof(argv[++i]);
+		} else {
+			usage = true;
+		}
+	}
+
+	if (usage || engine_count != 2 || (nodes > 0) + (depth > 0) + (movetime > 0) > 1 || (match.sprt && match.elo1 <= match.elo0)) {
+		fprintf(stderr, "Usage: %s -engine command -engine command [-option name=value]... [-openings file] [-games n]\n"
+			"       [-concurrency n] [-nodes n | -depth n | -movetime ms] [-timeout ms] [-maxplies n]\n"
+			"       [-bitbases dir] [-pgn file] [-sprt elo0 elo1]\n", argv[0]);
+		return 1;
+	}
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	// The time past which a move is lost: the move time and a margin, or a generous bound for the other limits
+	if (nodes > 0) {
+		snprintf(match.go, sizeof(match.go), "go nodes %ld", nodes);
+	} else if (depth > 0) {
+		snprintf(match.go, sizeof(match.go), "go depth %ld", depth);
+	} else {
+		if (movetime <= 0) movetime = 100;
+		snprintf(match.go, sizeof(match.go), "go movetime %ld", movetime);
+	}
+	if (timeout < 0) timeout = movetime > 0 ? 1000 : 10000;
+	match.move_timeout_ms = movetime + timeout;
+
+	if (concurrency < 1) concurrency = 1;
+	if (match.games < 1) match.games = 1;
+	if (match.max_plies < 1 || match.max_plies >= MAX_GAME_PLIES) match.max_plies = MAX_GAME_PLIES - 1;
+	for (int engine = 0; engine < 2; ++engine) {
+		snprintf(match.names[engine], sizeof(match.names[engine]), "%s", match.commands[engine]);
+	}
+
+	if (openings_path != NULL) {
+		match.opening_count = read_openings(openings_path, &match.openings);
+		if (match.opening_count <= 0) {
+			fprintf(stderr, "No opening in %s\n", openings_path);
+			return 1;
+		}
+	}
+
+	bitbases_init(&match.bitbases);
+	if (bitbase_dir != NULL) {
+		int found = bitbases_open(&match.bitbases, bitbase_dir);
+		fprintf(stderr, "%d of %d bitbases found in %s\n", found, BITBASE_SET_COUNT, bitbase_dir);
+	}
+
+	if (pgn_path != NULL && (match.pgn = fopen(pgn_path, "a")) == NULL) {
+		fprintf(stderr, "Can't open %s\n", pgn_path);
+		return 1;
+	}
+
+	time_t today = time(NULL);
+	struct tm date;
+	strftime(match.date, sizeof(match.date), "%Y.%m.%d", localtime_r(&today, &date));
+
+	// A write to an engine that died fails with EPIPE instead of ending the match
+	struct sigaction ignore = {0};
+	ignore.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &ignore, NULL);
+
+	pthread_mutex_init(&match.mutex, NULL);
+	atomic_init(&match.next_game, 0);
+	atomic_init(&match.stop, false);
+	match.start_ms = now_ms();
+
+	if (concurrency > match.games) concurrency = match.games;
+	struct Worker* workers = calloc((size_t) concurrency, sizeof(*workers));
+	if (workers == NULL) {
+		fprintf(stderr, "Can't allocate %ld workers\n", concurrency);
+		return 1;
+	}
+
+	int started = 0;
+	for (; started < concurrency; ++started) {
+		workers[started].match = &match;
+		if (pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]) != 0) break;
+	}
+	for (int i = 0; i < started; ++i) pthread_join(workers[i].thread, NULL);
+
+	print_summary(&match, started);
+
+	if (match.pgn != NULL) fclose(match.pgn);
+	bitbases_close(&match.bitbases);
+	for (int i = 0; i < match.opening_count; ++i) free(match.openings[i]);
+	free(match.openings);
+	free(workers);
+	pthread_mutex_destroy(&match.mutex);
+
+	return started > 0 && match.played > 0 ? 0 : 1;
+}
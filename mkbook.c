@@ -0,0 +1,352 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o mkbook mkbook.c book.c position.c movegen.c zobrist.c magic.c gamefile.c eval.c stats.c
+// ./pgn -o games.bin games.pgn && ./mkbook -o book.bin games.bin
+// ./mkbook -plies 30 -min 3 -o book.bin games.bin      deeper book, moves played at least 3 times
+// ./mkbook -memory 16 -o book.bin games.bin           sorts in runs of 16 MB
+
+/*
+ * Builds an opening book (see book.h) from a binary game file. Every
+ * move of the first plies of each game becomes an entry, weighted by the
+ * result for the player making it: 2 for a win, 1 for a draw or an
+ * unknown result, 0 for a loss.
+ *
+ * The entries are sorted with an external sort, so the memory used stays
+ * under -memory whatever the number of games: they are collected into a
+ * buffer of that size, which is sorted, has its duplicates added up and
+ * goes to a temporary file whenever it is full. The sorted runs are then
+ * merged, the moves of each position get their weights scaled to 16 bits,
+ * and the moves played fewer than -min times are dropped.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include "position.h"
+#include "movegen.h"
+#include "gamefile.h"
+#include "book.h"
+
+#define DEFAULT_PLIES 24
+#define DEFAULT_MEMORY_MB 64
+
+// An entry while sorting, with the full weight and the number of games it comes from
+struct RunEntry {
+	uint64_t key;
+	uint32_t weight;
+	uint16_t move;
+	uint16_t count;		// stops at UINT16_MAX
+};
+
+// A sorted run being merged, with its next entry
+struct Run {
+	FILE* file;
+	struct RunEntry next;
+};
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int compare_entries(const void* a, const void* b)
+{
+	const struct RunEntry* x = a;
+	const struct RunEntry* y = b;
+
+	if (x->key != y->key) return x->key < y->key ? -1 : 1;
+	return (int) x->move - (int) y->move;
+}
+
+static bool entry_less(const struct RunEntry* x, const struct RunEntry* y)
+{
+	return compare_entries(x, y) < 0;
+}
+
+// Adds the weight and count of 'from' to those of 'to', the same position and move
+static void combine(struct RunEntry* to, const struct RunEntry* from)
+{
+	to->weight += from->weight;
+	to->count = to->count > UINT16_MAX - from->count ? UINT16_MAX : (uint16_t) (to->count + from->count);
+}
+
+// Sorts the buffer, adds up its duplicates and writes it to a new temporary file
+static FILE* write_run(struct RunEntry* entries, size_t count)
+{
+	qsort(entries, count, sizeof(*entries), compare_entries);
+
+	size_t unique = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (unique > 0 && compare_entries(&entries[unique - 1], &entries[i]) == 0) {
+			combine(&entries[unique - 1], &entries[i]);
+		} else {
+			entries[unique++] = entries[i];
+		}
+	}
+
+	FILE* file = tmpfile();
+	if (file == NULL) return NULL;
+
+	if (fwrite(entries, sizeof(*entries), unique, file) != unique || fseek(file, 0, SEEK_SET) != 0) {
+		fclose(file);
+		return NULL;
+	}
+
+	return file;
+}
+
+// Result of a game for the player to move, as a weight
+static uint32_t result_weight(int result, int player)
+{
+	if (result == GAME_RESULT_WHITE_WINS) return player == PLAYER_WHITE ? 2 : 0;
+	if (result == GAME_RESULT_BLACK_WINS) return player == PLAYER_BLACK ? 2 : 0;
+
+	return 1;
+}
+
+// Min-heap of the runs by their next entry
+static void sift_down(struct Run* heap, int count, int i)
+{
+	for (;;) {
+		int smallest = i;
+		int left = 2 * i + 1;
+		int right = left + 1;
+
+		if (left < count && entry_less(&heap[left].next, &heap[smallest].next)) smallest = left;
+		if (right < count && entry_less(&heap[right].next, &heap[smallest].next)) smallest = right;
+		if (smallest == i) return;
+
+		struct Run swap = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = swap;
+		i = smallest;
+	}
+}
+
+struct BookWriter {
+	FILE* file;
+	uint64_t entries;
+	uint64_t positions;
+	uint32_t min_count;
+	struct RunEntry moves[MAX_MOVES];	// moves of the position being merged
+	int move_count;
+	bool failed;
+};
+
+// Writes the moves of one position, heaviest first, with the weights scaled to 16 bits
+static void flush_position(struct BookWriter* writer)
+{
+	uint32_t max_weight = 0;
+	int kept = 0;
+
+	for (int i = 0; i < writer->move_count; ++i) {
+		if (writer->moves[i].count < writer->min_count || writer->moves[i].weight == 0) continue;
+		writer->moves[kept++] = writer->moves[i];
+		if (writer->moves[i].weight > max_weight) max_weight = writer->moves[i].weight;
+	}
+	writer->move_count = 0;
+	if (kept == 0) return;
+
+	for (int i = 1; i < kept; ++i) {
+		struct RunEntry entry = writer->moves[i];
+		int j = i;
+		for (; j > 0 && writer->moves[j - 1].weight < entry.weight; --j) writer->moves[j] = writer->moves[j - 1];
+		writer->moves[j] = entry;
+	}
+
+	for (int i = 0; i < kept; ++i) {
+		uint64_t weight = writer->moves[i].weight;
+		if (max_weight > UINT16_MAX) weight = weight * UINT16_MAX / max_weight;
+
+		struct BookEntry entry = {writer->moves[i].key, writer->moves[i].move, (uint16_t) (weight > 0 ? weight : 1), 0};
+		uint8_t data[BOOK_ENTRY_SIZE];
+		book_entry_write(&entry, data);
+		if (fwrite(data, sizeof(data), 1, writer->file) != 1) writer->failed = true;
+	}
+
+	writer->entries += (uint64_t) kept;
+	++writer->positions;
+}
+
+// Takes the merged entries in order, one position and move at a time
+static void add_merged(struct BookWriter* writer, const struct RunEntry* entry)
+{
+	if (writer->move_count > 0 && writer->moves[0].key != entry->key) flush_position(writer);
+
+	// A position has fewer different legal moves than MAX_MOVES, unless keys collide
+	if (writer->move_count < MAX_MOVES) writer->moves[writer->move_count++] = *entry;
+}
+
+// Merges the runs into the book, the runs themselves stay as they are for the caller to close
+static bool merge_runs(const struct Run* runs, int run_count, struct BookWriter* writer)
+{
+	struct Run* heap = malloc((size_t) (run_count > 0 ? run_count : 1) * sizeof(*heap));
+	if (heap == NULL) return false;
+
+	int count = 0;
+	for (int i = 0; i < run_count; ++i) {
+		heap[count] = runs[i];
+		if (fread(&heap[count].next, sizeof(heap[count].next), 1, heap[count].file) == 1) ++count;
+	}
+	for (int i = count / 2 - 1; i >= 0; --i) sift_down(heap, count, i);
+
+	struct RunEntry current;
+	bool has_current = false;
+
+	while (count > 0) {
+		struct RunEntry entry = heap[0].next;
+
+		if (has_current && compare_entries(&current, &entry) == 0) {
+			combine(&current, &entry);
+		} else {
+			if (has_current) add_merged(writer, &current);
+			current = entry;
+			has_current = true;
+		}
+
+		if (fread(&heap[0].next, sizeof(heap[0].next), 1, heap[0].file) != 1) heap[0] = heap[--count];
+		sift_down(heap, count, 0);
+	}
+	free(heap);
+
+	if (has_current) add_merged(writer, &current);
+	if (writer->move_count > 0) flush_position(writer);
+
+	return !writer->failed;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* input_path = NULL;
+	const char* output_path = NULL;
+	int plies = DEFAULT_PLIES;
+	int min_count = 1;
+	size_t memory_mb = DEFAULT_MEMORY_MB;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			output_path = argv[++i];
+		} else if (strcmp(argv[i], "-plies") == 0 && i + 1 < argc) {
+			plies = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-min") == 0 && i + 1 < argc) {
+			min_count = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-memory") == 0 && i + 1 < argc) {
+			memory_mb = (size_t) atoi(argv[++i]);
+		} else if (argv[i][0] != '-' && input_path == NULL) {
+			input_path = argv[i];
+		} else {
+			input_path = NULL;
+			break;
+		}
+	}
+
+	if (input_path == NULL || output_path == NULL) {
+		fprintf(stderr, "Usage: %s [-plies n] [-min n] [-memory mb] -o book.bin games.bin\n", argv[0]);
+		return 1;
+	}
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	if (memory_mb < 1) memory_mb = 1;
+	if (min_count < 1) min_count = 1;
+
+	struct GameFile games;
+	if (!game_file_open(&games, input_path)) {
+		fprintf(stderr, "Can't read the game file %s\n", input_path);
+		return 1;
+	}
+
+	size_t capacity = memory_mb * 1024 * 1024 / sizeof(struct RunEntry);
+	struct RunEntry* entries = malloc(capacity * sizeof(*entries));
+	struct Run* runs = NULL;
+	int run_count = 0;
+	size_t count = 0;
+	uint64_t skipped = 0;
+	bool ok = entries != NULL;
+	double start = now_seconds();
+
+	for (uint64_t n = 0; n < games.count && ok; ++n) {
+		struct GameRecord record;
+		struct Position pos;
+
+		if (!game_file_get(&games, n, &record) || !game_record_start(&record, &pos)) {
+			++skipped;
+			continue;
+		}
+
+		uint32_t length = record.ply_count < (uint32_t) plies ? record.ply_count : (uint32_t) plies;
+		for (uint32_t ply = 0; ply < length && ok; ++ply) {
+			struct MoveList legal;
+			struct Undo undo;
+			uint16_t m = record.moves[ply];
+
+			generate_legal_moves(&pos, &legal);
+			if (!movelist_contains(&legal, m)) {
+				++skipped;
+				break;
+			}
+
+			entries[count++] = (struct RunEntry) {book_key(&pos), result_weight(record.result, pos.side), book_move_to_polyglot(m), 1};
+			make_move(&pos, m, &undo);
+
+			if (count == capacity) {
+				struct Run* grown = realloc(runs, (size_t) (run_count + 1) * sizeof(*runs));
+				FILE* file = grown != NULL ? write_run(entries, count) : NULL;
+				if (grown != NULL) runs = grown;
+				if (file == NULL) {
+					ok = false;
+					break;
+				}
+				runs[run_count++].file = file;
+				count = 0;
+			}
+		}
+	}
+
+	// The last, partial run
+	if (ok && count > 0) {
+		struct Run* grown = realloc(runs, (size_t) (run_count + 1) * sizeof(*runs));
+		FILE* file = grown != NULL ? write_run(entries, count) : NULL;
+		if (grown != NULL) runs = grown;
+		if (file != NULL) {
+			runs[run_count++].file = file;
+		} else {
+			ok = false;
+		}
+	}
+	free(entries);
+
+	struct BookWriter writer = {0};
+	writer.min_count = (uint32_t) min_count;
+	writer.file = ok ? fopen(output_path, "wb") : NULL;
+
+	if (!ok) {
+		fprintf(stderr, "Out of memory or temporary disk space\n");
+	} else if (writer.file == NULL) {
+		fprintf(stderr, "Can't write %s\n", output_path);
+		ok = false;
+	} else {
+		ok = merge_runs(runs, run_count, &writer);
+		if (fclose(writer.file) != 0) ok = false;
+		if (!ok) fprintf(stderr, "Can't write %s\n", output_path);
+
+		printf("%" PRIu64 " games, %" PRIu64 " skipped, %d runs, %" PRIu64 " positions, %" PRIu64 " entries in %.2f s\n",
+			games.count, skipped, run_count, writer.positions, writer.entries, now_seconds() - start);
+	}
+
+	for (int i = 0; i < run_count; ++i) fclose(runs[i].file);
+	free(runs);
+	game_file_close(&games);
+
+	return ok ? 0 : 1;
+}
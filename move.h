@@ -0,0 +1,70 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "position.h"
+
+// No legal position has more moves than this
+#define MAX_MOVES 256
+
+/*
+ * Moves are packed in 16 bits:
+ * bits 0-5 the square the piece leaves, bits 6-11 the square it lands on
+ * and bits 12-15 the flags below.
+ */
+#define MOVE(from, to, flags) ((uint16_t) ((from) | ((to) << 6) | ((flags) << 12)))
+#define MOVE_FROM(m) ((m) & 63)
+#define MOVE_TO(m) (((m) >> 6) & 63)
+#define MOVE_FLAGS(m) ((m) >> 12)
+#define MOVE_NONE 0
+
+#define FLAG_QUIET 0
+#define FLAG_DOUBLE_PUSH 1
+#define FLAG_KING_CASTLE 2
+#define FLAG_QUEEN_CASTLE 3
+#define FLAG_CAPTURE 4
+#define FLAG_EN_PASSANT 5
+// Promotions add the promoted piece (0 knight, 1 bishop, 2 rook, 3 queen) and FLAG_CAPTURE if capturing
+#define FLAG_PROMOTION 8
+
+#define MOVE_IS_CAPTURE(m) ((MOVE_FLAGS(m) & FLAG_CAPTURE) != 0)
+#define MOVE_IS_PROMOTION(m) ((MOVE_FLAGS(m) & FLAG_PROMOTION) != 0)
+#define MOVE_PROMOTION_TYPE(m) ((MOVE_FLAGS(m) & 3) + KNIGHT)
+
+// Fixed size list of moves, meant to live on the stack
+struct MoveList {
+	uint16_t moves[MAX_MOVES];
+	int count;
+};
+
+static inline void movelist_clear(struct MoveList* list)
+{
+	list->count = 0;
+}
+
+static inline void movelist_add(struct MoveList* list, uint16_t m)
+{
+	list->moves[list->count++] = m;
+}
+
+static inline bool movelist_contains(const struct MoveList* list, uint16_t m)
+{
+	for (int i = 0; i < list->count; ++i) {
+		if (list->moves[i] == m) return true;
+	}
+
+	return false;
+}
+
+// Returns the first move in the list that lands on 'sq', or MOVE_NONE
+static inline uint16_t movelist_find_target(const struct MoveList* list, int sq)
+{
+	for (int i = 0; i < list->count; ++i) {
+		if (MOVE_TO(list->moves[i]) == sq) return list->moves[i];
+	}
+
+	return MOVE_NONE;
+}
+
+#endif
@@ -0,0 +1,305 @@
+#include <string.h>
+#include "movegen.h"
+
+// Squares strictly between 'a' and 'b' when they share a row, column or diagonal, empty otherwise
+static uint64_t between(int a, int b)
+{
+	uint64_t ends = BIT(a) | BIT(b);
+
+	if (rook_attacks(a, 0) & BIT(b)) return rook_attacks(a, ends) & rook_attacks(b, ends);
+	if (bishop_attacks(a, 0) & BIT(b)) return bishop_attacks(a, ends) & bishop_attacks(b, ends);
+
+	return 0;
+}
+
+// Whole row, column or diagonal going through the aligned squares 'a' and 'b'
+static uint64_t line_through(int a, int b)
+{
+	uint64_t ends = BIT(a) | BIT(b);
+
+	if (rook_attacks(a, 0) & BIT(b)) return (rook_attacks(a, 0) & rook_attacks(b, 0)) | ends;
+
+	return (bishop_attacks(a, 0) & bishop_attacks(b, 0)) | ends;
+}
+
+// Adds a move from 'from' to every square set in 'targets', flagging the ones that capture
+static void add_moves_from_bitboard(const struct Position* pos, struct MoveList* list, int from, uint64_t targets)
+{
+	uint64_t captures = targets & pos->occupied;
+	uint64_t quiets = targets & ~pos->occupied;
+
+	while (captures) movelist_add(list, MOVE(from, pop_lsb(&captures), FLAG_CAPTURE));
+	while (quiets) movelist_add(list, MOVE(from, pop_lsb(&quiets), FLAG_QUIET));
+}
+
+// Adds every promotion of a pawn reaching the end of the board, queen first
+static void add_promotions(struct MoveList* list, int from, int to, int capture)
+{
+	for (int type = QUEEN; type >= KNIGHT; --type) {
+		movelist_add(list, MOVE(from, to, FLAG_PROMOTION | capture | (type - KNIGHT)));
+	}
+}
+
+void find_pawn_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask)
+{
+	STATS_COUNT(STATS_PAWN_MOVE_SEARCHES);
+	int player = PIECE_COLOR(pos->squares[from]);
+	uint64_t pawn = BIT(from);
+	uint64_t empty = ~pos->occupied;
+
+	// Black pawns move in the +y direction, white pawns move in the -y direction
+	// Normal move, and from the start position a second step if the first one is free
+	uint64_t single = (player == PLAYER_BLACK ? pawn << 8 : pawn >> 8) & empty;
+	uint64_t start = (player == PLAYER_BLACK ? ROW(2) : ROW(5)) & single;
+	uint64_t twice = (player == PLAYER_BLACK ? start << 8 : start >> 8) & empty & mask;
+	single &= mask;
+
+	// Attack move
+	uint64_t attacks = pawn_attacks(pawn, player) & pos->colors[!player] & mask;
+
+	// Reaching the last row turns the pawn into another piece
+	if ((single | attacks) & (ROW(0) | ROW(7))) {
+		while (attacks) add_promotions(list, from, pop_lsb(&attacks), FLAG_CAPTURE);
+		if (single) add_promotions(list, from, lsb(single), 0);
+		return;
+	}
+
+	while (attacks) movelist_add(list, MOVE(from, pop_lsb(&attacks), FLAG_CAPTURE));
+	if (single) movelist_add(list, MOVE(from, lsb(single), FLAG_QUIET));
+	if (twice) movelist_add(list, MOVE(from, lsb(twice), FLAG_DOUBLE_PUSH));
+}
+
+void find_knight_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask)
+{
+	STATS_COUNT(STATS_KNIGHT_MOVE_SEARCHES);
+	// Every L-shaped jump that doesn't land on one of our own pieces
+	uint64_t own = pos->colors[PIECE_COLOR(pos->squares[from])];
+	uint64_t targets = knight_attacks(BIT(from)) & ~own & mask;
+
+	add_moves_from_bitboard(pos, list, from, targets);
+}
+
+void find_bishop_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask)
+{
+	STATS_COUNT(STATS_BISHOP_MOVE_SEARCHES);
+	uint64_t own = pos->colors[PIECE_COLOR(pos->squares[from])];
+	uint64_t targets = bishop_attacks(from, pos->occupied) & ~own & mask;
+
+	add_moves_from_bitboard(pos, list, from, targets);
+}
+
+void find_rook_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask)
+{
+	STATS_COUNT(STATS_ROOK_MOVE_SEARCHES);
+	uint64_t own = pos->colors[PIECE_COLOR(pos->squares[from])];
+	uint64_t targets = rook_attacks(from, pos->occupied) & ~own & mask;
+
+	add_moves_from_bitboard(pos, list, from, targets);
+}
+
+void find_queen_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask)
+{
+	STATS_COUNT(STATS_QUEEN_MOVE_SEARCHES);
+	uint64_t own = pos->colors[PIECE_COLOR(pos->squares[from])];
+	uint64_t targets = queen_attacks(from, pos->occupied) & ~own & mask;
+
+	add_moves_from_bitboard(pos, list, from, targets);
+}
+
+void find_king_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask)
+{
+	STATS_COUNT(STATS_KING_MOVE_SEARCHES);
+	uint64_t own = pos->colors[PIECE_COLOR(pos->squares[from])];
+	uint64_t targets = king_attacks(BIT(from)) & ~own & mask;
+
+	add_moves_from_bitboard(pos, list, from, targets);
+}
+
+// Castling, only called when the king is not in check
+static void find_castling_moves(const struct Position* pos, struct MoveList* list)
+{
+	int player = pos->side;
+	int king = KING_START(player);
+	int king_side = player == PLAYER_WHITE ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+	int queen_side = player == PLAYER_WHITE ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+	int rook = MAKE_PIECE(ROOK, player);
+
+	// The rook must be in its corner, the squares between it and the king
+	// empty, and the king can't cross or land on an attacked square
+	if ((pos->castling & king_side) && pos->squares[ROOK_KING_START(player)] == rook
+		&& !(pos->occupied & (BIT(king + 1) | BIT(king + 2)))
+		&& !attackers_of(pos, king + 1, !player, pos->occupied)
+		&& !attackers_of(pos, king + 2, !player, pos->occupied)) {
+		movelist_add(list, MOVE(king, king + 2, FLAG_KING_CASTLE));
+	}
+
+	if ((pos->castling & queen_side) && pos->squares[ROOK_QUEEN_START(player)] == rook
+		&& !(pos->occupied & (BIT(king - 1) | BIT(king - 2) | BIT(king - 3)))
+		&& !attackers_of(pos, king - 1, !player, pos->occupied)
+		&& !attackers_of(pos, king - 2, !player, pos->occupied)) {
+		movelist_add(list, MOVE(king, king - 2, FLAG_QUEEN_CASTLE));
+	}
+}
+
+// En passant takes two pawns off the same row at once, so it is checked
+// against the position after the capture instead of with the masks
+static void find_en_passant_moves(const struct Position* pos, struct MoveList* list, int king)
+{
+	if (pos->ep_square < 0) return;
+
+	int player = pos->side;
+	int target = pos->ep_square;
+	int captured = player == PLAYER_WHITE ? target + 8 : target - 8;
+	uint64_t pawns = pawn_attacks(BIT(target), !player) & pos->pieces[MAKE_PIECE(PAWN, player)];
+
+	while (pawns) {
+		int from = pop_lsb(&pawns);
+		uint64_t occupied = (pos->occupied ^ BIT(from) ^ BIT(captured)) | BIT(target);
+
+		if (attackers_of(pos, king, !player, occupied) & ~BIT(captured)) continue;
+
+		movelist_add(list, MOVE(from, target, FLAG_EN_PASSANT));
+	}
+}
+
+/*
+ * Generates every legal move of the player to move in one pass.
+ *
+ * The pieces giving check and the pinned pieces are found once, then each
+ * piece only gets the targets that keep its king safe:
+ * - the king moves to squares no enemy piece attacks once it has left its square,
+ * - in double check nothing else can move,
+ * - in single check the other pieces must capture the checker or block it,
+ * - a pinned piece stays on the line between its king and the pinning slider.
+ */
+void generate_legal_moves(const struct Position* pos, struct MoveList* list)
+{
+	int player = pos->side;
+	int enemy = !player;
+	int king = king_square(pos, player);
+	uint64_t own = pos->colors[player];
+	const uint64_t* enemy_pieces = &pos->pieces[MAKE_PIECE(PAWN, enemy)];
+
+	STATS_COUNT(STATS_LEGAL_MOVE_GENERATIONS);
+	STATS_SCOPE(STATS_TIMER_LEGAL_MOVES);
+	movelist_clear(list);
+
+	uint64_t checkers = attackers_of(pos, king, enemy, pos->occupied);
+
+	// Squares the king can step on, with the king lifted so it can't hide behind itself
+	uint64_t without_king = pos->occupied ^ BIT(king);
+	uint64_t king_targets = king_attacks(BIT(king)) & ~own;
+	uint64_t safe = 0;
+	while (king_targets) {
+		int to = pop_lsb(&king_targets);
+		if (!attackers_of(pos, to, enemy, without_king)) safe |= BIT(to);
+	}
+	find_king_moves(pos, list, king, safe);
+
+	// Two pieces giving check can't both be captured or blocked
+	if (checkers & (checkers - 1)) return;
+
+	uint64_t check_mask = ~0ULL;
+	if (checkers) {
+		check_mask = checkers | between(king, lsb(checkers));
+	} else {
+		find_castling_moves(pos, list);
+	}
+
+	// A piece is pinned when it is the only one between its king and an enemy slider.
+	// The x-ray only looks through our own pieces, an enemy piece in between blocks it.
+	uint64_t pinned = 0;
+	uint64_t snipers = (rook_attacks(king, pos->colors[enemy]) & (enemy_pieces[ROOK] | enemy_pieces[QUEEN]))
+		| (bishop_attacks(king, pos->colors[enemy]) & (enemy_pieces[BISHOP] | enemy_pieces[QUEEN]));
+	while (snipers) {
+		uint64_t blockers = between(king, pop_lsb(&snipers)) & pos->occupied;
+		if (blockers && !(blockers & (blockers - 1))) pinned |= blockers;
+	}
+
+	uint64_t pieces = own & ~BIT(king);
+	while (pieces) {
+		int from = pop_lsb(&pieces);
+		uint64_t mask = check_mask;
+		if (pinned & BIT(from)) mask &= line_through(king, from);
+
+		switch (PIECE_TYPE(pos->squares[from])) {
+			case PAWN:
+				find_pawn_moves(pos, list, from, mask);
+				break;
+			case KNIGHT:
+				find_knight_moves(pos, list, from, mask);
+				break;
+			case BISHOP:
+				find_bishop_moves(pos, list, from, mask);
+				break;
+			case ROOK:
+				find_rook_moves(pos, list, from, mask);
+				break;
+			case QUEEN:
+				find_queen_moves(pos, list, from, mask);
+				break;
+			default:
+				break;
+		}
+	}
+
+	find_en_passant_moves(pos, list, king);
+}
+
+int position_status(const struct Position* pos)
+{
+	struct MoveList list;
+	generate_legal_moves(pos, &list);
+
+	if (list.count > 0) return STATUS_PLAYING;
+
+	return position_checkers(pos) ? STATUS_CHECKMATE : STATUS_STALEMATE;
+}
+
+uint64_t perft(struct Position* pos, int depth)
+{
+	if (depth == 0) return 1;
+
+	struct MoveList list;
+	generate_legal_moves(pos, &list);
+
+	// Every legal move is a leaf on the last ply, no need to play them
+	if (depth == 1) return list.count;
+
+	uint64_t nodes = 0;
+	for (int i = 0; i < list.count; ++i) {
+		struct Undo undo;
+		make_move(pos, list.moves[i], &undo);
+		nodes += perft(pos, depth - 1);
+		unmake_move(pos, list.moves[i], &undo);
+	}
+
+	return nodes;
+}
+
+void move_to_string(uint16_t m, char* str)
+{
+	int from = MOVE_FROM(m);
+	int to = MOVE_TO(m);
+
+	str[0] = 'a' + SQUARE_X(from);
+	str[1] = '8' - SQUARE_Y(from);
+	str[2] = 'a' + SQUARE_X(to);
+	str[3] = '8' - SQUARE_Y(to);
+	str[4] = MOVE_IS_PROMOTION(m) ? "nbrq"[MOVE_PROMOTION_TYPE(m) - KNIGHT] : '\0';
+	str[5] = '\0';
+}
+
+uint16_t move_from_string(const struct Position* pos, const char* str)
+{
+	struct MoveList list;
+	char name[6];
+
+	generate_legal_moves(pos, &list);
+	for (int i = 0; i < list.count; ++i) {
+		move_to_string(list.moves[i], name);
+		if (strcmp(name, str) == 0) return list.moves[i];
+	}
+
+	return MOVE_NONE;
+}
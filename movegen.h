@@ -0,0 +1,36 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "position.h"
+#include "move.h"
+
+// Result of a position once its legal moves are known
+#define STATUS_PLAYING 0
+#define STATUS_CHECKMATE 1
+#define STATUS_STALEMATE 2
+#define STATUS_DRAW_REPETITION 3	// same position for the third time, set by struct Game
+
+/*
+ * Per piece generators: append the moves of the piece on 'from' whose
+ * target square is in 'mask'. They don't look at the king's safety,
+ * generate_legal_moves passes masks that make every move legal.
+ */
+void find_pawn_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask);
+void find_knight_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask);
+void find_bishop_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask);
+void find_rook_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask);
+void find_queen_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask);
+void find_king_moves(const struct Position* pos, struct MoveList* list, int from, uint64_t mask);
+
+void generate_legal_moves(const struct Position* pos, struct MoveList* list);
+int position_status(const struct Position* pos);
+
+// Number of leaves of the legal move tree 'depth' plies deep, the position is left as it was
+uint64_t perft(struct Position* pos, int depth);
+
+// Long algebraic notation ("e2e4", "e7e8q"), 'str' needs room for 6 characters
+void move_to_string(uint16_t m, char* str);
+// Returns the legal move written as 'str', or MOVE_NONE
+uint16_t move_from_string(const struct Position* pos, const char* str);
+
+#endif
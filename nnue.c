@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <string.h>
+#include "nnue.h"
+#include "move.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Most rows a move changes: the piece leaving and arriving, a capture, the rook when castling
+#define MAX_CHANGED_ROWS 4
+
+// Input of 'piece' on 'sq' seen from the side of 'perspective', whose pieces come first and whose back rank is at the bottom
+static int feature(int perspective, int piece, int sq)
+{
+	int relative = PIECE_COLOR(piece) == perspective ? PIECE_TYPE(piece) : 6 + PIECE_TYPE(piece);
+
+	return relative * 64 + (perspective == PLAYER_WHITE ? sq : sq ^ 56);
+}
+
+#if defined(__AVX2__)
+
+// out = in + the 'adds' rows - the 'subs' rows, 16 neurons at a time
+static void accumulate(int16_t* out, const int16_t* in, const int16_t* const* adds, int add_count,
+	const int16_t* const* subs, int sub_count)
+{
+	for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) (in + i));
+		for (int j = 0; j < add_count; ++j) v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i*) (adds[j] + i)));
+		for (int j = 0; j < sub_count; ++j) v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i*) (subs[j] + i)));
+		_mm256_storeu_si256((__m256i*) (out + i), v);
+	}
+}
+
+// Sum of clip(values[i]) * weights[i]
+static int32_t dot_clipped(const int16_t* values, const int16_t* weights)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i clip = _mm256_set1_epi16(NNUE_CLIP);
+	__m256i sum = _mm256_setzero_si256();
+
+	for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) (values + i));
+		v = _mm256_min_epi16(_mm256_max_epi16(v, zero), clip);
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, _mm256_loadu_si256((const __m256i*) (weights + i))));
+	}
+
+	__m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+
+	return _mm_cvtsi128_si32(s);
+}
+
+const char* nnue_kernel(void)
+{
+	return "AVX2";
+}
+
+#elif defined(__SSE2__)
+
+static void accumulate(int16_t* out, const int16_t* in, const int16_t* const* adds, int add_count,
+	const int16_t* const* subs, int sub_count)
+{
+	for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (in + i));
+		for (int j = 0; j < add_count; ++j) v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i*) (adds[j] + i)));
+		for (int j = 0; j < sub_count; ++j) v = _mm_sub_epi16(v, _mm_loadu_si128((const __m128i*) (subs[j] + i)));
+		_mm_storeu_si128((__m128i*) (out + i), v);
+	}
+}
+
+static int32_t dot_clipped(const int16_t* values, const int16_t* weights)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i clip = _mm_set1_epi16(NNUE_CLIP);
+	__m128i sum = _mm_setzero_si128();
+
+	for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (values + i));
+		v = _mm_min_epi16(_mm_max_epi16(v, zero), clip);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(v, _mm_loadu_si128((const __m128i*) (weights + i))));
+	}
+
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+
+	return _mm_cvtsi128_si32(sum);
+}
+
+const char* nnue_kernel(void)
+{
+	return "SSE2";
+}
+
+#else
+
+static void accumulate(int16_t* out, const int16_t* in, const int16_t* const* adds, int add_count,
+	const int16_t* const* subs, int sub_count)
+{
+	for (int i = 0; i < NNUE_HIDDEN; ++i) {
+		int16_t v = in[i];
+		for (int j = 0; j < add_count; ++j) v = (int16_t) (v + adds[j][i]);
+		for (int j = 0; j < sub_count; ++j) v = (int16_t) (v - subs[j][i]);
+		out[i] = v;
+	}
+}
+
+static int32_t dot_clipped(const int16_t* values, const int16_t* weights)
+{
+	int32_t sum = 0;
+
+	for (int i = 0; i < NNUE_HIDDEN; ++i) {
+		int v = values[i] < 0 ? 0 : values[i] > NNUE_CLIP ? NNUE_CLIP : values[i];
+		sum += v * weights[i];
+	}
+
+	return sum;
+}
+
+const char* nnue_kernel(void)
+{
+	return "scalar";
+}
+
+#endif
+
+bool nnue_load(struct NnueNetwork* network, const char* path)
+{
+	char magic[4];
+	uint32_t header[3];
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) return false;
+
+	bool ok = fread(magic, sizeof(magic), 1, file) == 1
+		&& fread(header, sizeof(header), 1, file) == 1
+		&& memcmp(magic, NNUE_FILE_MAGIC, sizeof(magic)) == 0
+		&& header[0] == NNUE_FILE_VERSION && header[1] == NNUE_INPUTS && header[2] == NNUE_HIDDEN
+		&& fread(network->feature_weights, sizeof(network->feature_weights), 1, file) == 1
+		&& fread(network->feature_biases, sizeof(network->feature_biases), 1, file) == 1
+		&& fread(network->output_weights, sizeof(network->output_weights), 1, file) == 1
+		&& fread(&network->output_bias, sizeof(network->output_bias), 1, file) == 1;
+
+	fclose(file);
+	return ok;
+}
+
+// xorshift64*, a value in [-range, range]
+static int16_t random_weight(uint64_t* state, int range)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+
+	return (int16_t) ((*state * 2685821657736338717ULL >> 33) % (2 * range + 1) - range);
+}
+
+void nnue_randomize(struct NnueNetwork* network, uint64_t seed)
+{
+	uint64_t state = seed ? seed : 1;
+
+	for (int i = 0; i < NNUE_INPUTS; ++i) {
+		for (int j = 0; j < NNUE_HIDDEN; ++j) network->feature_weights[i][j] = random_weight(&state, 16);
+	}
+	for (int j = 0; j < NNUE_HIDDEN; ++j) network->feature_biases[j] = random_weight(&state, 32);
+	for (int j = 0; j < NNUE_HIDDEN; ++j) {
+		network->output_weights[0][j] = random_weight(&state, 32);
+		network->output_weights[1][j] = random_weight(&state, 32);
+	}
+	network->output_bias = 0;
+}
+
+void nnue_refresh(const struct NnueNetwork* network, const struct Position* pos, struct Accumulator* accumulator)
+{
+	for (int perspective = 0; perspective < 2; ++perspective) {
+		const int16_t* rows[64];
+		int count = 0;
+
+		for (int sq = 0; sq < 64; ++sq) {
+			int piece = pos->squares[sq];
+			if (piece != EMPTY) rows[count++] = network->feature_weights[feature(perspective, piece, sq)];
+		}
+
+		accumulate(accumulator->values[perspective], network->feature_biases, rows, count, NULL, 0);
+	}
+}
+
+void nnue_update(const struct NnueNetwork* network, const struct Accumulator* parent, struct Accumulator* child,
+	const struct Position* pos, uint16_t m)
+{
+	int from = MOVE_FROM(m);
+	int to = MOVE_TO(m);
+	int flags = MOVE_FLAGS(m);
+	int piece = pos->squares[from];
+	int player = PIECE_COLOR(piece);
+
+	// Pieces and squares whose rows are added and removed, the same for both sides
+	int add_pieces[MAX_CHANGED_ROWS], add_squares[MAX_CHANGED_ROWS];
+	int sub_pieces[MAX_CHANGED_ROWS], sub_squares[MAX_CHANGED_ROWS];
+	int add_count = 0;
+	int sub_count = 0;
+
+	sub_pieces[sub_count] = piece;
+	sub_squares[sub_count++] = from;
+	add_pieces[add_count] = MOVE_IS_PROMOTION(m) ? MAKE_PIECE(MOVE_PROMOTION_TYPE(m), player) : piece;
+	add_squares[add_count++] = to;
+
+	if (flags == FLAG_EN_PASSANT) {
+		int captured = player == PLAYER_WHITE ? to + 8 : to - 8;
+		sub_pieces[sub_count] = pos->squares[captured];
+		sub_squares[sub_count++] = captured;
+	} else if (MOVE_IS_CAPTURE(m)) {
+		sub_pieces[sub_count] = pos->squares[to];
+		sub_squares[sub_count++] = to;
+	}
+
+	if (flags == FLAG_KING_CASTLE || flags == FLAG_QUEEN_CASTLE) {
+		int rook = MAKE_PIECE(ROOK, player);
+		sub_pieces[sub_count] = rook;
+		sub_squares[sub_count++] = flags == FLAG_KING_CASTLE ? to + 1 : to - 2;
+		add_pieces[add_count] = rook;
+		add_squares[add_count++] = flags == FLAG_KING_CASTLE ? to - 1 : to + 1;
+	}
+
+	for (int perspective = 0; perspective < 2; ++perspective) {
+		const int16_t* adds[MAX_CHANGED_ROWS];
+		const int16_t* subs[MAX_CHANGED_ROWS];
+
+		for (int i = 0; i < add_count; ++i) adds[i] = network->feature_weights[feature(perspective, add_pieces[i], add_squares[i])];
+		for (int i = 0; i < sub_count; ++i) subs[i] = network->feature_weights[feature(perspective, sub_pieces[i], sub_squares[i])];
+
+		accumulate(child->values[perspective], parent->values[perspective], adds, add_count, subs, sub_count);
+	}
+}
+
+int nnue_evaluate(const struct NnueNetwork* network, const struct Accumulator* accumulator, int side)
+{
+	int64_t sum = (int64_t) dot_clipped(accumulator->values[side], network->output_weights[0])
+		+ dot_clipped(accumulator->values[!side], network->output_weights[1])
+		+ network->output_bias;
+
+	return (int) (sum * NNUE_OUTPUT_SCALE / (NNUE_CLIP * NNUE_WEIGHT_SCALE));
+}
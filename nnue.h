@@ -0,0 +1,65 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "position.h"
+
+/*
+ * Small neural evaluation, in the NNUE style: 768 inputs, one per piece
+ * code and square seen from each player's side, a hidden layer of
+ * NNUE_HIDDEN clipped-ReLU neurons for each side, and one output.
+ *
+ * The hidden layer before activation (the accumulator) is the sum of the
+ * weight rows of the pieces on the board. A move only adds and removes a
+ * few rows, so it is updated from the previous position's accumulator
+ * instead of being summed again. Both the updates and the output run on
+ * 16-bit integers, with AVX2 or SSE2 kernels when the build has them.
+ */
+#define NNUE_INPUTS 768
+#define NNUE_HIDDEN 256
+
+// Quantization: activations are clipped to [0, NNUE_CLIP], output weights are scaled by NNUE_WEIGHT_SCALE
+#define NNUE_CLIP 255
+#define NNUE_WEIGHT_SCALE 64
+#define NNUE_OUTPUT_SCALE 400
+
+#define NNUE_FILE_MAGIC "NNUE"
+#define NNUE_FILE_VERSION 1
+
+struct NnueNetwork {
+	int16_t feature_weights[NNUE_INPUTS][NNUE_HIDDEN];
+	int16_t feature_biases[NNUE_HIDDEN];
+	int16_t output_weights[2][NNUE_HIDDEN];	// the player to move's half, then the other one
+	int32_t output_bias;					// in units of NNUE_CLIP * NNUE_WEIGHT_SCALE
+};
+
+// Hidden layer of each player's side, indexed by PLAYER_*
+struct Accumulator {
+	int16_t values[2][NNUE_HIDDEN];
+};
+
+/*
+ * Reads a network file: the magic, the version, the input and hidden
+ * sizes as 32-bit numbers, then the fields of struct NnueNetwork in
+ * order, in the byte order of the machine.
+ */
+bool nnue_load(struct NnueNetwork* network, const char* path);
+
+// Small random weights, for benchmarks: the scores mean nothing
+void nnue_randomize(struct NnueNetwork* network, uint64_t seed);
+
+// Sums the accumulator again from every piece of 'pos'
+void nnue_refresh(const struct NnueNetwork* network, const struct Position* pos, struct Accumulator* accumulator);
+
+// Accumulator after 'm', from the one of 'pos', which is the position before 'm' is played
+void nnue_update(const struct NnueNetwork* network, const struct Accumulator* parent, struct Accumulator* child,
+	const struct Position* pos, uint16_t m);
+
+// Score in centipawns for 'side', the player to move
+int nnue_evaluate(const struct NnueNetwork* network, const struct Accumulator* accumulator, int side);
+
+// Instruction set of the kernels in this build: "AVX2", "SSE2" or "scalar"
+const char* nnue_kernel(void);
+
+#endif
@@ -0,0 +1,130 @@
+#include <string.h>
+#include "notation.h"
+#include "movegen.h"
+
+void move_to_san(const struct Position* pos, uint16_t m, char* san)
+{
+	static const char piece_letters[] = "PNBRQK";
+	int from = MOVE_FROM(m);
+	int to = MOVE_TO(m);
+	int type = PIECE_TYPE(pos->squares[from]);
+	char* c = san;
+
+	if (MOVE_FLAGS(m) == FLAG_KING_CASTLE || MOVE_FLAGS(m) == FLAG_QUEEN_CASTLE) {
+		const char* castle = MOVE_FLAGS(m) == FLAG_KING_CASTLE ? "O-O" : "O-O-O";
+		while (*castle) *c++ = *castle++;
+	} else if (type == PAWN) {
+		// Pawn captures name the column the pawn comes from
+		if (MOVE_IS_CAPTURE(m)) {
+			*c++ = (char) ('a' + SQUARE_X(from));
+			*c++ = 'x';
+		}
+		*c++ = (char) ('a' + SQUARE_X(to));
+		*c++ = (char) ('8' - SQUARE_Y(to));
+		if (MOVE_IS_PROMOTION(m)) {
+			*c++ = '=';
+			*c++ = piece_letters[MOVE_PROMOTION_TYPE(m)];
+		}
+	} else {
+		struct MoveList list;
+		bool ambiguous = false;
+		bool same_column = false;
+		bool same_row = false;
+
+		// Other pieces of the same kind that can land on the same square
+		generate_legal_moves(pos, &list);
+		for (int i = 0; i < list.count; ++i) {
+			int other = MOVE_FROM(list.moves[i]);
+			if (other == from || MOVE_TO(list.moves[i]) != to || pos->squares[other] != pos->squares[from]) continue;
+
+			ambiguous = true;
+			if (SQUARE_X(other) == SQUARE_X(from)) same_column = true;
+			if (SQUARE_Y(other) == SQUARE_Y(from)) same_row = true;
+		}
+
+		*c++ = piece_letters[type];
+		if (ambiguous && (!same_column || same_row)) *c++ = (char) ('a' + SQUARE_X(from));
+		if (ambiguous && same_column) *c++ = (char) ('8' - SQUARE_Y(from));
+		if (MOVE_IS_CAPTURE(m)) *c++ = 'x';
+		*c++ = (char) ('a' + SQUARE_X(to));
+		*c++ = (char) ('8' - SQUARE_Y(to));
+	}
+
+	// Check or mate, found by playing the move on a copy
+	struct Position after = *pos;
+	struct Undo undo;
+	make_move(&after, m, &undo);
+	if (position_checkers(&after)) *c++ = position_status(&after) == STATUS_CHECKMATE ? '#' : '+';
+
+	*c = '\0';
+}
+
+// Index of 'c' in "PNBRQK", -1 if it isn't a piece letter
+static int piece_type_from_letter(char c)
+{
+	static const char piece_letters[] = "PNBRQK";
+	const char* letter = c != '\0' ? strchr(piece_letters, c) : NULL;
+
+	return letter != NULL ? (int) (letter - piece_letters) : -1;
+}
+
+uint16_t move_from_san(const struct Position* pos, const char* san, size_t length)
+{
+	const char* c = san;
+	const char* end = san + length;
+	int type = PAWN;
+	int promotion = -1;
+	int from_x = -1;
+	int from_y = -1;
+	int castle = -1;
+
+	while (end > c && strchr("+#!?", end[-1]) != NULL) --end;
+
+	if (end - c >= 3 && (c[0] == 'O' || c[0] == '0') && c[1] == '-') {
+		if (end - c == 3 && c[2] == c[0]) castle = FLAG_KING_CASTLE;
+		else if (end - c == 5 && c[2] == c[0] && c[3] == '-' && c[4] == c[0]) castle = FLAG_QUEEN_CASTLE;
+		else return MOVE_NONE;
+	} else {
+		// Piece letter, then the optional origin and 'x', the target square and the promotion
+		if (c < end && piece_type_from_letter(*c) > PAWN) type = piece_type_from_letter(*c++);
+
+		if (end - c >= 3 && piece_type_from_letter(end[-1]) > PAWN && piece_type_from_letter(end[-1]) < KING) {
+			promotion = piece_type_from_letter(*--end);
+			if (end[-1] == '=') --end;
+		}
+
+		if (end - c < 2 || end[-2] < 'a' || end[-2] > 'h' || end[-1] < '1' || end[-1] > '8') return MOVE_NONE;
+		end -= 2;
+
+		for (; c < end; ++c) {
+			if (*c >= 'a' && *c <= 'h') from_x = *c - 'a';
+			else if (*c >= '1' && *c <= '8') from_y = '8' - *c;
+			else if (*c != 'x' && *c != ':' && *c != '-') return MOVE_NONE;
+		}
+	}
+
+	int to = castle < 0 ? SQUARE(end[0] - 'a', '8' - end[1]) : -1;
+	uint16_t found = MOVE_NONE;
+	struct MoveList list;
+	generate_legal_moves(pos, &list);
+
+	for (int i = 0; i < list.count; ++i) {
+		uint16_t m = list.moves[i];
+		int from = MOVE_FROM(m);
+
+		if (castle >= 0) {
+			if (MOVE_FLAGS(m) != castle) continue;
+		} else {
+			if (MOVE_TO(m) != to || PIECE_TYPE(pos->squares[from]) != type) continue;
+			if (from_x >= 0 && SQUARE_X(from) != from_x) continue;
+			if (from_y >= 0 && SQUARE_Y(from) != from_y) continue;
+			if (MOVE_IS_PROMOTION(m) ? MOVE_PROMOTION_TYPE(m) != promotion : promotion >= 0) continue;
+		}
+
+		// Two matches means the text doesn't say which piece moves
+		if (found != MOVE_NONE) return MOVE_NONE;
+		found = m;
+	}
+
+	return found;
+}
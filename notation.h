@@ -0,0 +1,29 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "position.h"
+#include "move.h"
+
+// Room for the longest move in standard algebraic notation ("Qh4xe1+", "exd8=Q#"), terminator included
+#define SAN_MAX_LENGTH 10
+
+/*
+ * Standard algebraic notation, as in PGN and EPD: the piece letter, the
+ * column and/or row of the origin when another piece of the same kind
+ * could land on the same square, 'x' for captures, "=Q" for promotions,
+ * then '+' or '#'. 'm' must be legal in 'pos'.
+ */
+void move_to_san(const struct Position* pos, uint16_t m, char* san);
+
+/*
+ * The legal move written as the first 'length' characters of 'san', or
+ * MOVE_NONE if there is none or more than one. The text doesn't need to be
+ * terminated, so tokens can be read straight from a file buffer. Check
+ * marks and annotations ('+', '#', '!', '?') are ignored, castling may be
+ * written with zeros, and the '=' of promotions may be left out.
+ */
+uint16_t move_from_san(const struct Position* pos, const char* san, size_t length);
+
+#endif
@@ -0,0 +1,460 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o perft perft.c position.c movegen.c zobrist.c magic.c scheduler.c eval.c stats.c      add -march=native for PEXT
+// ./perft                                      checks the reference positions up to depth 5
+// ./perft -depth 6                             same, one ply deeper
+// ./perft -fen "<fen>" -depth 5 -divide        counts one position, move by move
+// ./perft -depth 7 -threads 16 -hash 256       all the positions at once on 16 threads, 256 MB of hash each
+// ./perft -depth 6 -threads 8 -scaling         time and speedup for 1 to 8 threads
+
+/*
+ * Performance test: counts the leaf nodes of the legal move tree to a fixed
+ * depth. The counts of the reference positions are known, so any
+ * difference points to a move generation bug, and the nodes per second
+ * measure the speed of the generator.
+ *
+ * With -threads, every position and depth asked for is counted in one
+ * batch. Trees are split into jobs, from the root down to a few plies
+ * above the leaves, on a work-stealing scheduler, so a big subtree doesn't
+ * keep one thread busy while the others wait. Each thread also keeps its
+ * own hash of subtree counts, which saves the transpositions without any
+ * locking.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include "position.h"
+#include "movegen.h"
+#include "scheduler.h"
+
+#define MAX_REFERENCE_DEPTH 7
+
+// Subtrees this deep or less are counted by the thread that finds them instead of being split
+#define SPLIT_DEPTH 3
+
+struct PerftCase {
+	const char* name;
+	const char* fen;
+	uint64_t nodes[MAX_REFERENCE_DEPTH];	// expected leaf count at depth 1, 2, ..., 0 when unknown
+};
+
+// The usual test positions, picked to cover castling, en passant, promotions and pins
+static const struct PerftCase reference_positions[] = {
+	{"start", START_FEN,
+		{20, 400, 8902, 197281, 4865609, 119060324, 3195901860ULL}},
+	{"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		{48, 2039, 97862, 4085603, 193690690, 8031647685ULL, 0}},
+	{"position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		{14, 191, 2812, 43238, 674624, 11030083, 178633661}},
+	{"position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		{6, 264, 9467, 422333, 15833292, 706045033, 0}},
+	{"position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		{44, 1486, 62379, 2103487, 89941194, 0, 0}},
+	{"position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		{46, 2079, 89890, 3894594, 164075551, 6923051137ULL, 0}},
+};
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+struct PerftEntry {
+	uint64_t key;
+	uint64_t nodes;		// leaf count << 8 | depth
+};
+
+// Counts of the subtrees already seen, one table per thread so it needs no locking
+struct PerftHash {
+	struct PerftEntry* entries;
+	uint64_t mask;
+};
+
+// Same as perft, looking the subtrees up in 'hash' first
+static uint64_t perft_hashed(struct Position* pos, int depth, struct PerftHash* hash)
+{
+	if (hash->entries == NULL) return perft(pos, depth);
+	if (depth == 0) return 1;
+
+	struct PerftEntry* entry = &hash->entries[pos->key & hash->mask];
+	if (entry->key == pos->key && (int) (entry->nodes & 0xFF) == depth) return entry->nodes >> 8;
+
+	struct MoveList list;
+	generate_legal_moves(pos, &list);
+	if (depth == 1) return list.count;
+
+	uint64_t nodes = 0;
+	for (int i = 0; i < list.count; ++i) {
+		struct Undo undo;
+		make_move(pos, list.moves[i], &undo);
+		nodes += perft_hashed(pos, depth - 1, hash);
+		unmake_move(pos, list.moves[i], &undo);
+	}
+
+	entry->key = pos->key;
+	entry->nodes = nodes << 8 | (uint64_t) depth;
+
+	return nodes;
+}
+
+struct ParallelPerft {
+	struct Scheduler scheduler;
+	struct PerftHash* hashes;	// one per thread
+	int threads;
+};
+
+// Counts one subtree, or splits it into a job per move, adding the leaves to 'nodes'
+struct PerftJob {
+	struct Job job;
+	struct ParallelPerft* parallel;
+	struct Position pos;
+	int depth;
+	_Atomic uint64_t* nodes;
+};
+
+static void perft_job_run(struct Scheduler* scheduler, int worker, struct Job* job);
+
+static void spawn_perft(struct ParallelPerft* parallel, int worker, const struct Position* pos, int depth, _Atomic uint64_t* nodes)
+{
+	struct PerftJob* job = malloc(sizeof(*job));
+	if (job == NULL) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+
+	job->job.run = perft_job_run;
+	job->parallel = parallel;
+	job->pos = *pos;
+	job->depth = depth;
+	job->nodes = nodes;
+	scheduler_spawn(&parallel->scheduler, worker, &job->job);
+}
+
+static void perft_job_run(struct Scheduler* scheduler, int worker, struct Job* job)
+{
+	(void) scheduler;
+	struct PerftJob* perft_job = (struct PerftJob*) job;
+
+	if (perft_job->depth <= SPLIT_DEPTH) {
+		uint64_t count = perft_hashed(&perft_job->pos, perft_job->depth, &perft_job->parallel->hashes[worker]);
+		atomic_fetch_add_explicit(perft_job->nodes, count, memory_order_relaxed);
+	} else {
+		struct MoveList list;
+		generate_legal_moves(&perft_job->pos, &list);
+
+		for (int i = 0; i < list.count; ++i) {
+			struct Position child = perft_job->pos;
+			struct Undo undo;
+			make_move(&child, list.moves[i], &undo);
+			spawn_perft(perft_job->parallel, worker, &child, perft_job->depth - 1, perft_job->nodes);
+		}
+	}
+
+	free(perft_job);
+}
+
+static bool parallel_init(struct ParallelPerft* parallel, int threads, size_t hash_mb)
+{
+	size_t count = 1;
+	while (hash_mb > 0 && count * 2 * sizeof(struct PerftEntry) <= hash_mb * 1024 * 1024) count *= 2;
+
+	parallel->threads = threads;
+	parallel->hashes = calloc(threads, sizeof(struct PerftHash));
+	if (parallel->hashes == NULL || !scheduler_init(&parallel->scheduler, threads)) return false;
+
+	for (int i = 0; i < threads && hash_mb > 0; ++i) {
+		parallel->hashes[i].entries = calloc(count, sizeof(struct PerftEntry));
+		parallel->hashes[i].mask = count - 1;
+		if (parallel->hashes[i].entries == NULL) return false;
+	}
+
+	return true;
+}
+
+static void parallel_free(struct ParallelPerft* parallel)
+{
+	for (int i = 0; i < parallel->threads && parallel->hashes != NULL; ++i) free(parallel->hashes[i].entries);
+	free(parallel->hashes);
+	scheduler_free(&parallel->scheduler);
+}
+
+// Same count, printing the number of leaves under each root move
+static uint64_t perft_divide(struct Position* pos, int depth)
+{
+	struct MoveList list;
+	generate_legal_moves(pos, &list);
+
+	uint64_t nodes = 0;
+	for (int i = 0; i < list.count; ++i) {
+		struct Undo undo;
+		char name[6];
+
+		make_move(pos, list.moves[i], &undo);
+		uint64_t count = perft(pos, depth - 1);
+		unmake_move(pos, list.moves[i], &undo);
+		nodes += count;
+
+		move_to_string(list.moves[i], name);
+		printf("  %-5s %" PRIu64 "\n", name, count);
+	}
+
+	return nodes;
+}
+
+static void print_result(const char* name, int depth, uint64_t nodes, double seconds)
+{
+	printf("%-12s depth %d  %12" PRIu64 " nodes  %8.3f s  %10.0f nps", name, depth, nodes, seconds,
+		seconds > 0 ? nodes / seconds : 0.0);
+}
+
+// Counts one position given on the command line
+static int run_position(const char* fen, int depth, bool divide)
+{
+	struct Position pos;
+	if (!position_from_fen(&pos, fen)) {
+		fprintf(stderr, "Invalid FEN: %s\n", fen);
+		return 1;
+	}
+
+	double start = now_seconds();
+	uint64_t nodes = divide ? perft_divide(&pos, depth) : perft(&pos, depth);
+	double seconds = now_seconds() - start;
+
+	print_result("position", depth, nodes, seconds);
+	printf("\n");
+
+	return 0;
+}
+
+// Same as run_position on 'threads' threads, each root move being one batch entry
+static int run_position_parallel(const char* fen, int depth, bool divide, int threads, size_t hash_mb)
+{
+	struct Position pos;
+	struct MoveList list;
+	struct ParallelPerft parallel;
+
+	if (!position_from_fen(&pos, fen)) {
+		fprintf(stderr, "Invalid FEN: %s\n", fen);
+		return 1;
+	}
+	if (depth < 1) depth = 1;
+	if (!parallel_init(&parallel, threads, hash_mb)) {
+		fprintf(stderr, "Can't allocate %d threads with %zu MB of hash each\n", threads, hash_mb);
+		return 1;
+	}
+
+	generate_legal_moves(&pos, &list);
+	_Atomic uint64_t counts[MAX_MOVES];
+
+	double start = now_seconds();
+	for (int i = 0; i < list.count; ++i) {
+		struct Position child = pos;
+		struct Undo undo;
+		make_move(&child, list.moves[i], &undo);
+		atomic_init(&counts[i], 0);
+		spawn_perft(&parallel, 0, &child, depth - 1, &counts[i]);
+	}
+	scheduler_run(&parallel.scheduler);
+	double seconds = now_seconds() - start;
+
+	uint64_t nodes = 0;
+	for (int i = 0; i < list.count; ++i) {
+		char name[6];
+		uint64_t count = atomic_load(&counts[i]);
+		nodes += count;
+
+		move_to_string(list.moves[i], name);
+		if (divide) printf("  %-5s %" PRIu64 "\n", name, count);
+	}
+
+	print_result("position", depth, nodes, seconds);
+	printf("  %d threads\n", threads);
+
+	parallel_free(&parallel);
+	return 0;
+}
+
+/*
+ * Counts every reference position at every depth up to 'max_depth' as one
+ * batch on 'threads' threads. Returns the number of wrong counts, or -1 if
+ * the threads can't be set up, and the time taken in 'seconds'.
+ */
+static int run_reference_parallel(int max_depth, int threads, size_t hash_mb, bool verbose, uint64_t* total_nodes, double* seconds)
+{
+	size_t case_count = sizeof(reference_positions) / sizeof(reference_positions[0]);
+	_Atomic uint64_t counts[sizeof(reference_positions) / sizeof(reference_positions[0])][MAX_REFERENCE_DEPTH];
+	struct ParallelPerft parallel;
+	int failures = 0;
+
+	if (!parallel_init(&parallel, threads, hash_mb)) {
+		fprintf(stderr, "Can't allocate %d threads with %zu MB of hash each\n", threads, hash_mb);
+		return -1;
+	}
+
+	double start = now_seconds();
+	for (size_t i = 0; i < case_count; ++i) {
+		struct Position pos;
+		position_from_fen(&pos, reference_positions[i].fen);
+
+		for (int depth = 1; depth <= max_depth && depth <= MAX_REFERENCE_DEPTH; ++depth) {
+			atomic_init(&counts[i][depth - 1], 0);
+			if (reference_positions[i].nodes[depth - 1] == 0) break;
+			spawn_perft(&parallel, 0, &pos, depth, &counts[i][depth - 1]);
+		}
+	}
+	scheduler_run(&parallel.scheduler);
+	*seconds = now_seconds() - start;
+
+	*total_nodes = 0;
+	for (size_t i = 0; i < case_count; ++i) {
+		const struct PerftCase* test = &reference_positions[i];
+
+		for (int depth = 1; depth <= max_depth && depth <= MAX_REFERENCE_DEPTH; ++depth) {
+			uint64_t expected = test->nodes[depth - 1];
+			if (expected == 0) break;
+
+			uint64_t nodes = atomic_load(&counts[i][depth - 1]);
+			*total_nodes += nodes;
+			if (nodes != expected) ++failures;
+
+			if (verbose) {
+				printf("%-12s depth %d  %12" PRIu64 " nodes", test->name, depth, nodes);
+				if (nodes == expected) printf("  ok\n");
+				else printf("  FAILED, expected %" PRIu64 "\n", expected);
+			}
+		}
+	}
+
+	parallel_free(&parallel);
+	return failures;
+}
+
+// Counts every reference position up to 'max_depth' and compares with the known values
+static int run_reference(int max_depth, bool divide)
+{
+	int failures = 0;
+	uint64_t total_nodes = 0;
+	double total_seconds = 0;
+
+	for (size_t i = 0; i < sizeof(reference_positions) / sizeof(reference_positions[0]); ++i) {
+		const struct PerftCase* test = &reference_positions[i];
+		struct Position pos;
+		position_from_fen(&pos, test->fen);
+
+		for (int depth = 1; depth <= max_depth && depth <= MAX_REFERENCE_DEPTH; ++depth) {
+			uint64_t expected = test->nodes[depth - 1];
+			if (expected == 0) break;
+
+			double start = now_seconds();
+			uint64_t nodes = perft(&pos, depth);
+			double seconds = now_seconds() - start;
+
+			total_nodes += nodes;
+			total_seconds += seconds;
+
+			print_result(test->name, depth, nodes, seconds);
+			if (nodes == expected) {
+				printf("  ok\n");
+				continue;
+			}
+
+			printf("  FAILED, expected %" PRIu64 "\n", expected);
+			++failures;
+
+			// The moves whose subtree is wrong lead to the bug
+			if (divide) perft_divide(&pos, depth);
+			break;
+		}
+	}
+
+	printf("%" PRIu64 " nodes in %.3f s, %.0f nps, %d failure(s), %s slider attacks\n", total_nodes, total_seconds,
+		total_seconds > 0 ? total_nodes / total_seconds : 0.0, failures, slider_attacks_method());
+
+	return failures > 0 ? 1 : 0;
+}
+
+// Runs the reference batch with 1 to 'max_threads' threads and prints how the time scales
+static int run_scaling(int max_depth, int max_threads, size_t hash_mb)
+{
+	double base_seconds = 0;
+	int failures = 0;
+
+	printf("threads %14s %10s %12s %8s\n", "nodes", "s", "nps", "speedup");
+	for (int threads = 1; threads <= max_threads; ++threads) {
+		uint64_t nodes;
+		double seconds;
+		int result = run_reference_parallel(max_depth, threads, hash_mb, false, &nodes, &seconds);
+		if (result < 0) return 1;
+
+		failures += result;
+		if (threads == 1) base_seconds = seconds;
+		printf("%7d %14" PRIu64 " %10.3f %12.0f %8.2f%s\n", threads, nodes, seconds,
+			seconds > 0 ? nodes / seconds : 0.0, seconds > 0 ? base_seconds / seconds : 0.0,
+			result > 0 ? "  FAILED" : "");
+	}
+
+	return failures > 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+	int depth = 0;
+	const char* fen = NULL;
+	bool divide = false;
+	int threads = 0;
+	size_t hash_mb = 16;
+	bool scaling = false;
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-depth") == 0 && i + 1 < argc) {
+			depth = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-fen") == 0 && i + 1 < argc) {
+			fen = argv[++i];
+		} else if (strcmp(argv[i], "-divide") == 0) {
+			divide = true;
+		} else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc) {
+			hash_mb = (size_t) atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-scaling") == 0) {
+			scaling = true;
+		} else {
+			fprintf(stderr, "Usage: %s [-depth n] [-fen \"<fen>\"] [-divide] [-threads n] [-hash mb] [-scaling]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (depth <= 0) depth = 5;
+
+	// Without -threads, the plain single threaded count that measures the move generator
+	if (threads <= 0) {
+		if (fen != NULL) return run_position(fen, depth, divide);
+		return run_reference(depth, divide);
+	}
+
+	if (scaling) return run_scaling(depth, threads, hash_mb);
+	if (fen != NULL) return run_position_parallel(fen, depth, divide, threads, hash_mb);
+
+	uint64_t nodes;
+	double seconds;
+	int failures = run_reference_parallel(depth, threads, hash_mb, true, &nodes, &seconds);
+	if (failures < 0) return 1;
+
+	printf("%" PRIu64 " nodes in %.3f s, %.0f nps, %d failure(s), %d threads, %s slider attacks\n", nodes, seconds,
+		seconds > 0 ? nodes / seconds : 0.0, failures, threads, slider_attacks_method());
+
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,482 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o pgn pgn.c position.c movegen.c zobrist.c magic.c notation.c scheduler.c gamefile.c eval.c stats.c
+// ./pgn games.pgn                              replays every game on all the processors
+// ./pgn -threads 1 games.pgn                   same, on one thread
+// ./pgn -o games.bin games.pgn                 also writes the games without errors to a binary game file
+
+/*
+ * Checks a Portable Game Notation file: every move of every game is read
+ * and played, starting from the standard position or from the game's FEN
+ * tag. Moves that aren't legal, or don't say which piece moves, are
+ * reported with the game number, the ply and the line, and the rest of
+ * that game is skipped.
+ *
+ * The file is mapped in memory and read in place: tokens are pointers
+ * into the mapping, so nothing is copied or allocated per move. It is cut
+ * into chunks at game starts, and the chunks are replayed as jobs of the
+ * work-stealing scheduler, so big files use every thread.
+ *
+ * With -o, each chunk also encodes its games in memory, and the chunks
+ * are written in file order once they are all done (see gamefile.h).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "position.h"
+#include "movegen.h"
+#include "notation.h"
+#include "scheduler.h"
+#include "gamefile.h"
+
+// Chunks per thread, more of them even out games of different lengths
+#define CHUNKS_PER_THREAD 16
+
+// Smaller chunks aren't worth a job
+#define MIN_CHUNK_SIZE (64 * 1024)
+
+struct PgnError {
+	uint64_t game;				// within the chunk until the chunks are counted
+	int ply;					// of the move that failed, 1 for White's first move
+	size_t offset;				// of the move in the file
+	char text[16];
+};
+
+struct PgnChunk {
+	struct Job job;
+	const char* start;
+	const char* end;
+	uint64_t games;
+	uint64_t plies;
+	struct PgnError* errors;
+	size_t error_count;
+	size_t error_capacity;
+	uint64_t lost_errors;			// found but not kept, for lack of memory
+	struct GameBuffer records;		// games read without errors, with -o
+	uint16_t* moves;				// of the game being read, with -o
+	size_t move_capacity;
+	bool out_of_memory;
+};
+
+// Every game without a FEN tag starts from a copy of it
+static struct Position start_position;
+static const char* file_start;
+static bool keep_games;
+
+static double now_seconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Characters that end a move token
+static bool is_delimiter(char c)
+{
+	return is_space(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '[' || c == ']';
+}
+
+// GAME_RESULT_ code of a result token, -1 if it isn't one
+static int result_of(const char* token, size_t length)
+{
+	if (length == 1 && token[0] == '*') return GAME_RESULT_UNKNOWN;
+	if (length == 3 && memcmp(token, "1-0", 3) == 0) return GAME_RESULT_WHITE_WINS;
+	if (length == 3 && memcmp(token, "0-1", 3) == 0) return GAME_RESULT_BLACK_WINS;
+	if (length == 7 && memcmp(token, "1/2-1/2", 7) == 0) return GAME_RESULT_DRAW;
+
+	return -1;
+}
+
+// Adds 'm' to the moves kept for -o
+static void keep_move(struct PgnChunk* chunk, int ply, uint16_t m)
+{
+	if ((size_t) ply == chunk->move_capacity) {
+		size_t capacity = chunk->move_capacity ? 2 * chunk->move_capacity : 512;
+		uint16_t* moves = realloc(chunk->moves, capacity * sizeof(*moves));
+		if (moves == NULL) {
+			chunk->out_of_memory = true;
+			return;
+		}
+
+		chunk->moves = moves;
+		chunk->move_capacity = capacity;
+	}
+
+	chunk->moves[ply] = m;
+}
+
+// The character after the end of the line, or 'end'
+static const char* skip_line(const char* p, const char* end)
+{
+	const char* newline = memchr(p, '\n', end - p);
+
+	return newline != NULL ? newline + 1 : end;
+}
+
+// 'p' is on a '{', returns the character after the matching '}'
+static const char* skip_comment(const char* p, const char* end)
+{
+	const char* close = memchr(p, '}', end - p);
+
+	return close != NULL ? close + 1 : end;
+}
+
+// 'p' is on a '(', returns the character after the matching ')', comments and nested variations included
+static const char* skip_variation(const char* p, const char* end)
+{
+	int depth = 0;
+
+	while (p < end) {
+		if (*p == '{') {
+			p = skip_comment(p, end);
+		} else if (*p == ';') {
+			p = skip_line(p, end);
+		} else {
+			if (*p == '(') ++depth;
+			else if (*p == ')' && --depth == 0) return p + 1;
+			++p;
+		}
+	}
+
+	return end;
+}
+
+/*
+ * The first game starting after 'p': a tag line ('[' and a letter) after
+ * a blank line. Clock and evaluation tags in comments start with "[%", so
+ * they aren't taken for one.
+ */
+static const char* next_game_start(const char* p, const char* end)
+{
+	while (p < end) {
+		const char* newline = memchr(p, '\n', end - p);
+		if (newline == NULL || end - newline < 3) return end;
+
+		p = newline + 1;
+		bool blank_before = newline > file_start && (newline[-1] == '\n' || (newline[-1] == '\r' && newline - 1 > file_start && newline[-2] == '\n'));
+		if (blank_before && p[0] == '[' && ((p[1] >= 'A' && p[1] <= 'Z') || (p[1] >= 'a' && p[1] <= 'z'))) return p;
+	}
+
+	return end;
+}
+
+static void add_error(struct PgnChunk* chunk, int ply, const char* token, size_t length)
+{
+	if (chunk->error_count == chunk->error_capacity) {
+		size_t capacity = chunk->error_capacity ? 2 * chunk->error_capacity : 16;
+		struct PgnError* errors = realloc(chunk->errors, capacity * sizeof(*errors));
+		if (errors == NULL) {
+			// Still counted, so the exit status reports it
+			++chunk->lost_errors;
+			return;
+		}
+
+		chunk->errors = errors;
+		chunk->error_capacity = capacity;
+	}
+
+	struct PgnError* error = &chunk->errors[chunk->error_count++];
+	error->game = chunk->games;
+	error->ply = ply;
+	error->offset = (size_t) (token - file_start);
+	if (length >= sizeof(error->text)) length = sizeof(error->text) - 1;
+	memcpy(error->text, token, length);
+	error->text[length] = '\0';
+}
+
+// Sets 'pos' from the value of a FEN tag, 'p' being on its '['
+static bool read_fen_tag(struct Position* pos, const char* p, const char* line_end)
+{
+	char fen[FEN_MAX_LENGTH];
+	const char* value = memchr(p, '"', line_end - p);
+	if (value == NULL) return false;
+
+	++value;
+	const char* close = memchr(value, '"', line_end - value);
+	if (close == NULL || close - value >= FEN_MAX_LENGTH) return false;
+
+	memcpy(fen, value, close - value);
+	fen[close - value] = '\0';
+
+	return position_from_fen(pos, fen);
+}
+
+// Reads and plays one game, 'p' being on its first tag or move. Returns where the next game can start.
+static const char* replay_game(struct PgnChunk* chunk, const char* p, const char* end)
+{
+	struct Position pos = start_position;
+	struct Position start;
+	struct Undo undo;
+	bool custom_start = false;
+	bool failed = false;
+	int result = GAME_RESULT_UNKNOWN;
+	int ply = 0;
+
+	// Tag pairs, only the starting position matters here
+	while (p < end && *p == '[') {
+		const char* next = skip_line(p, end);
+
+		if (next - p > 5 && memcmp(p, "[FEN ", 5) == 0) {
+			custom_start = true;
+			if (!read_fen_tag(&pos, p, next)) {
+				add_error(chunk, 0, p, next - p);
+				failed = true;
+			}
+		}
+
+		p = next;
+		while (p < end && is_space(*p)) ++p;
+	}
+
+	if (keep_games && custom_start) start = pos;
+
+	// Movetext, up to the result or the tags of the next game
+	while (p < end) {
+		if (is_space(*p)) {
+			++p;
+		} else if (*p == '{') {
+			p = skip_comment(p, end);
+		} else if (*p == ';' || (*p == '%' && (p == file_start || p[-1] == '\n'))) {
+			p = skip_line(p, end);
+		} else if (*p == '(') {
+			p = skip_variation(p, end);
+		} else if (*p == '[') {
+			break;
+		} else if (*p == ')' || *p == '}' || *p == ']') {
+			++p;
+		} else {
+			const char* token = p;
+			while (p < end && !is_delimiter(*p)) ++p;
+
+			result = result_of(token, p - token);
+			if (result >= 0) break;
+			result = GAME_RESULT_UNKNOWN;
+
+			if (*token == '$' || failed) continue;
+
+			// A move number, "12." or "12...", may be stuck to the move
+			const char* san = token;
+			while (san < p && *san >= '0' && *san <= '9') ++san;
+			if (san < p && *san == '.') {
+				while (san < p && *san == '.') ++san;
+			} else {
+				san = token;
+			}
+			if (san == p) continue;
+
+			uint16_t m = move_from_san(&pos, san, p - san);
+			if (m == MOVE_NONE) {
+				add_error(chunk, ply + 1, san, p - san);
+				failed = true;
+				continue;
+			}
+
+			if (keep_games) keep_move(chunk, ply, m);
+			make_move(&pos, m, &undo);
+			++ply;
+		}
+	}
+
+	if (keep_games && !failed && !chunk->out_of_memory
+		&& !game_buffer_add(&chunk->records, custom_start ? &start : NULL, chunk->moves, ply, result)) {
+		chunk->out_of_memory = true;
+	}
+
+	++chunk->games;
+	chunk->plies += ply;
+
+	return p;
+}
+
+static void replay_chunk(struct Scheduler* scheduler, int worker, struct Job* job)
+{
+	(void) scheduler;
+	(void) worker;
+	struct PgnChunk* chunk = (struct PgnChunk*) job;
+	const char* p = chunk->start;
+
+	for (;;) {
+		while (p < chunk->end && is_space(*p)) ++p;
+		if (p >= chunk->end) break;
+		p = replay_game(chunk, p, chunk->end);
+	}
+}
+
+// Line of 'offset', counting from 'line' at 'line_offset' since errors come in file order
+static uint64_t line_of(size_t offset, size_t* line_offset, uint64_t* line)
+{
+	const char* p = file_start + *line_offset;
+	const char* target = file_start + offset;
+
+	while ((p = memchr(p, '\n', target - p)) != NULL) {
+		++p;
+		++*line;
+	}
+
+	*line_offset = offset;
+	return *line;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* path = NULL;
+	const char* output = NULL;
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			output = argv[++i];
+		} else if (path == NULL && argv[i][0] != '-') {
+			path = argv[i];
+		} else {
+			path = NULL;
+			break;
+		}
+	}
+
+	if (path == NULL) {
+		fprintf(stderr, "Usage: %s [-threads n] [-o games.bin] <file.pgn>\n", argv[0]);
+		return 1;
+	}
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		fprintf(stderr, "Can't open %s\n", path);
+		return 1;
+	}
+
+	size_t size = (size_t) st.st_size;
+	if (size == 0) {
+		printf("0 games\n");
+		close(fd);
+		return 0;
+	}
+
+	void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		fprintf(stderr, "Can't map %s\n", path);
+		return 1;
+	}
+	posix_madvise(mapping, size, POSIX_MADV_SEQUENTIAL);
+
+	position_from_fen(&start_position, START_FEN);
+	file_start = mapping;
+	keep_games = output != NULL;
+	const char* file_end = file_start + size;
+
+	if (threads < 1) threads = 1;
+	size_t chunk_count = (size_t) threads * CHUNKS_PER_THREAD;
+	if (chunk_count > size / MIN_CHUNK_SIZE) chunk_count = size / MIN_CHUNK_SIZE;
+	if (chunk_count > DEQUE_SIZE) chunk_count = DEQUE_SIZE;
+	if (chunk_count < 1) chunk_count = 1;
+
+	struct Scheduler scheduler;
+	struct PgnChunk* chunks = calloc(chunk_count, sizeof(*chunks));
+	if (chunks == NULL || !scheduler_init(&scheduler, (int) threads)) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	// Chunks of about the same size, each moved forward to the start of a game
+	const char* start = file_start;
+	for (size_t i = 0; i < chunk_count; ++i) {
+		const char* end = i + 1 < chunk_count ? file_start + size / chunk_count * (i + 1) : file_end;
+		if (end < start) end = start;
+		if (end < file_end) end = next_game_start(end, file_end);
+
+		chunks[i].job.run = replay_chunk;
+		chunks[i].start = start;
+		chunks[i].end = end;
+		scheduler_spawn(&scheduler, 0, &chunks[i].job);
+		start = end;
+	}
+
+	double begin = now_seconds();
+	scheduler_run(&scheduler);
+	double seconds = now_seconds() - begin;
+
+	// Chunks in file order give the game numbers and put the errors in order
+	uint64_t games = 0;
+	uint64_t plies = 0;
+	uint64_t errors = 0;
+	uint64_t lost_errors = 0;
+	size_t line_offset = 0;
+	uint64_t line = 1;
+
+	for (size_t i = 0; i < chunk_count; ++i) {
+		for (size_t j = 0; j < chunks[i].error_count; ++j) {
+			struct PgnError* error = &chunks[i].errors[j];
+			uint64_t error_line = line_of(error->offset, &line_offset, &line);
+
+			if (error->ply == 0) {
+				printf("game %" PRIu64 ", line %" PRIu64 ": invalid FEN tag\n", games + error->game + 1, error_line);
+			} else {
+				printf("game %" PRIu64 ", ply %d, line %" PRIu64 ": illegal move %s\n",
+					games + error->game + 1, error->ply, error_line, error->text);
+			}
+		}
+
+		games += chunks[i].games;
+		plies += chunks[i].plies;
+		errors += chunks[i].error_count + chunks[i].lost_errors;
+		lost_errors += chunks[i].lost_errors;
+		free(chunks[i].errors);
+	}
+
+	if (lost_errors > 0) fprintf(stderr, "%" PRIu64 " errors not listed, out of memory\n", lost_errors);
+
+	printf("%" PRIu64 " games, %" PRIu64 " plies, %" PRIu64 " errors in %.3f s: %.0f games/s, %.1f MB/s on %ld threads\n",
+		games, plies, errors, seconds, games / seconds, size / seconds / 1e6, threads);
+
+	bool written = true;
+	if (output != NULL) {
+		struct GameWriter writer;
+		written = game_writer_open(&writer, output);
+
+		for (size_t i = 0; written && i < chunk_count; ++i) {
+			written = !chunks[i].out_of_memory && game_writer_add(&writer, &chunks[i].records);
+		}
+		if (written) {
+			uint64_t kept = writer.count;
+			written = game_writer_close(&writer);
+			if (written) printf("%" PRIu64 " games written to %s\n", kept, output);
+		} else if (writer.file != NULL) {
+			game_writer_close(&writer);
+		}
+		if (!written) fprintf(stderr, "Can't write %s\n", output);
+	}
+
+	for (size_t i = 0; i < chunk_count; ++i) {
+		game_buffer_free(&chunks[i].records);
+		free(chunks[i].moves);
+	}
+	free(chunks);
+	scheduler_free(&scheduler);
+	munmap(mapping, size);
+
+	return errors > 0 || !written ? 1 : 0;
+}
@@ -0,0 +1,439 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "position.h"
+#include "move.h"
+#include "zobrist.h"
+#include "eval.h"
+
+// Castling rights kept when a piece leaves or lands on each square,
+// only the squares the kings and rooks start on take rights away
+static const int castle_mask[64] = {
+	 7, 15, 15, 15,  3, 15, 15, 11,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15,
+	13, 15, 15, 15, 12, 15, 15, 14,
+};
+
+const int piece_values[6] = {100, 320, 330, 500, 900, 0};
+
+// Empties every bitboard and square
+void position_clear(struct Position* pos)
+{
+	memset(pos, 0, sizeof(*pos));
+	memset(pos->squares, EMPTY, sizeof(pos->squares));
+	pos->side = PLAYER_WHITE;
+	pos->ep_square = -1;
+	pos->fullmove = 1;
+}
+
+// Places 'piece' on the empty square 'sq'
+void position_put(struct Position* pos, int piece, int sq)
+{
+	uint64_t bit = BIT(sq);
+
+	pos->pieces[piece] |= bit;
+	pos->colors[PIECE_COLOR(piece)] |= bit;
+	pos->occupied |= bit;
+	pos->squares[sq] = (int8_t) piece;
+	pos->score_mg += pst_score_mg(piece, sq);
+	pos->score_eg += pst_score_eg(piece, sq);
+	pos->phase += phase_weights[PIECE_TYPE(piece)];
+	if (PIECE_TYPE(piece) == KING) pos->kings[PIECE_COLOR(piece)] = sq;
+}
+
+// Removes whatever piece is on 'sq', if any
+void position_remove(struct Position* pos, int sq)
+{
+	int piece = pos->squares[sq];
+	if (piece == EMPTY) return;
+
+	uint64_t bit = BIT(sq);
+
+	pos->pieces[piece] &= ~bit;
+	pos->colors[PIECE_COLOR(piece)] &= ~bit;
+	pos->occupied &= ~bit;
+	pos->squares[sq] = EMPTY;
+	pos->score_mg -= pst_score_mg(piece, sq);
+	pos->score_eg -= pst_score_eg(piece, sq);
+	pos->phase -= phase_weights[PIECE_TYPE(piece)];
+}
+
+// Moves the piece on 'from' to the empty square 'to', only the square bonuses change
+static void position_move(struct Position* pos, int from, int to)
+{
+	int piece = pos->squares[from];
+	int type = PIECE_TYPE(piece);
+	int color = PIECE_COLOR(piece);
+	int sign = color == PLAYER_WHITE ? 1 : -1;
+	uint64_t bits = BIT(from) | BIT(to);
+
+	pos->pieces[piece] ^= bits;
+	pos->colors[color] ^= bits;
+	pos->occupied ^= bits;
+	pos->squares[from] = EMPTY;
+	pos->squares[to] = (int8_t) piece;
+	pos->score_mg += sign * (pst_mg[type][PST_SQUARE(color, to)] - pst_mg[type][PST_SQUARE(color, from)]);
+	pos->score_eg += sign * (pst_eg[type][PST_SQUARE(color, to)] - pst_eg[type][PST_SQUARE(color, from)]);
+	if (type == KING) pos->kings[color] = to;
+}
+
+// Castling rights whose king and rook are still on their starting squares
+static int castling_on_board(const struct Position* pos)
+{
+	int castling = 0;
+
+	for (int player = PLAYER_BLACK; player <= PLAYER_WHITE; ++player) {
+		int king = MAKE_PIECE(KING, player);
+		int rook = MAKE_PIECE(ROOK, player);
+		if (pos->squares[KING_START(player)] != king) continue;
+
+		if (pos->squares[ROOK_KING_START(player)] == rook) {
+			castling |= player == PLAYER_WHITE ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+		}
+		if (pos->squares[ROOK_QUEEN_START(player)] == rook) {
+			castling |= player == PLAYER_WHITE ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+		}
+	}
+
+	return castling;
+}
+
+// The array carries no history: white moves first and castling is allowed
+// for every king and rook still on its starting square
+void position_from_array(struct Position* pos, int board[][8])
+{
+	position_clear(pos);
+
+	for (int y = 0; y < 8; ++y) {
+		for (int x = 0; x < 8; ++x) {
+			if (board[y][x] != EMPTY) position_put(pos, board[y][x], SQUARE(x, y));
+		}
+	}
+
+	pos->castling = castling_on_board(pos);
+	pos->key = position_compute_key(pos);
+}
+
+void position_to_array(const struct Position* pos, int board[][8])
+{
+	for (int y = 0; y < 8; ++y) {
+		for (int x = 0; x < 8; ++x) {
+			board[y][x] = pos->squares[SQUARE(x, y)];
+		}
+	}
+}
+
+uint64_t position_compute_key(const struct Position* pos)
+{
+	uint64_t key = zobrist_castling[pos->castling];
+
+	for (int sq = 0; sq < 64; ++sq) {
+		if (pos->squares[sq] != EMPTY) key ^= zobrist_pieces[pos->squares[sq]][sq];
+	}
+
+	if (pos->ep_square >= 0) key ^= zobrist_en_passant[SQUARE_X(pos->ep_square)];
+	if (pos->side == PLAYER_BLACK) key ^= zobrist_side;
+
+	return key;
+}
+
+/*
+ * True when both armies could come from the starting ones: at most eight
+ * pawns, none on the first or last row, and no more extra queens, rooks,
+ * bishops and knights than pawns were promoted. The move lists are sized
+ * for such positions, a board full of queens would overflow them.
+ */
+static bool material_is_possible(const struct Position* pos)
+{
+	static const int start_counts[KING] = {8, 2, 2, 2, 1};
+
+	if ((pos->pieces[MAKE_PIECE(PAWN, PLAYER_WHITE)] | pos->pieces[MAKE_PIECE(PAWN, PLAYER_BLACK)]) & (ROW(0) | ROW(7))) {
+		return false;
+	}
+
+	for (int player = PLAYER_BLACK; player <= PLAYER_WHITE; ++player) {
+		int promoted = 0;
+		for (int type = KNIGHT; type < KING; ++type) {
+			int extra = popcount(pos->pieces[MAKE_PIECE(type, player)]) - start_counts[type];
+			if (extra > 0) promoted += extra;
+		}
+		if (promoted > start_counts[PAWN] - popcount(pos->pieces[MAKE_PIECE(PAWN, player)])) return false;
+	}
+
+	return true;
+}
+
+/*
+ * True when 'sq' is where the pawn that just moved two squares passed over,
+ * with that pawn in front of it and both squares it crossed empty, and a
+ * pawn of the player to move could capture onto it.
+ */
+static bool can_capture_en_passant(const struct Position* pos, int sq)
+{
+	int player = pos->side;
+	int pawn = player == PLAYER_WHITE ? sq + 8 : sq - 8;
+	int start = player == PLAYER_WHITE ? sq - 8 : sq + 8;
+
+	if (SQUARE_Y(sq) != (player == PLAYER_WHITE ? 2 : 5)) return false;
+	if (pos->squares[pawn] != MAKE_PIECE(PAWN, !player)) return false;
+	if (pos->squares[sq] != EMPTY || pos->squares[start] != EMPTY) return false;
+
+	return (pawn_attacks(BIT(sq), !player) & pos->pieces[MAKE_PIECE(PAWN, player)]) != 0;
+}
+
+/*
+ * Reads the piece placement, side to move, castling rights, en passant
+ * square and the two clocks. The clocks may be left out, as in EPD lines.
+ * Rows are listed from the top of the board, which is also the order of the squares.
+ */
+bool position_from_fen(struct Position* pos, const char* fen)
+{
+	static const char piece_letters[] = "pnbrqkPNBRQK";
+	const char* c = fen;
+	int sq = 0;
+
+	position_clear(pos);
+
+	for (; *c && *c != ' '; ++c) {
+		if (*c == '/') continue;
+
+		if (*c >= '1' && *c <= '8') {
+			sq += *c - '0';
+		} else {
+			const char* letter = strchr(piece_letters, *c);
+			if (letter == NULL || sq >= 64) return false;
+			position_put(pos, (int) (letter - piece_letters), sq++);
+		}
+	}
+
+	// Both kings are needed by the move generator
+	if (sq != 64 || popcount(pos->pieces[MAKE_PIECE(KING, PLAYER_WHITE)]) != 1
+		|| popcount(pos->pieces[MAKE_PIECE(KING, PLAYER_BLACK)]) != 1) return false;
+	if (!material_is_possible(pos)) return false;
+
+	while (*c == ' ') ++c;
+	if (*c != 'w' && *c != 'b') return false;
+	pos->side = *c++ == 'w' ? PLAYER_WHITE : PLAYER_BLACK;
+
+	while (*c == ' ') ++c;
+	for (; *c && *c != ' '; ++c) {
+		if (*c == 'K') pos->castling |= CASTLE_WHITE_KING;
+		else if (*c == 'Q') pos->castling |= CASTLE_WHITE_QUEEN;
+		else if (*c == 'k') pos->castling |= CASTLE_BLACK_KING;
+		else if (*c == 'q') pos->castling |= CASTLE_BLACK_QUEEN;
+		else if (*c != '-') return false;
+	}
+
+	// Rights the board can't back would castle with a rook that isn't there
+	pos->castling &= castling_on_board(pos);
+
+	// The player who just moved can't have left their king in check
+	if (attackers_of(pos, king_square(pos, !pos->side), pos->side, pos->occupied)) return false;
+
+	while (*c == ' ') ++c;
+	if (*c >= 'a' && *c <= 'h' && c[1] >= '1' && c[1] <= '8') {
+		// Kept only if a pawn can take it, so the key doesn't depend on how the position was reached
+		int sq = SQUARE(c[0] - 'a', '8' - c[1]);
+		if (can_capture_en_passant(pos, sq)) pos->ep_square = sq;
+		c += 2;
+	} else if (*c == '-') {
+		++c;
+	}
+
+	char* end;
+	long halfmove = strtol(c, &end, 10);
+	if (end != c) {
+		pos->halfmove_clock = (int) halfmove;
+		c = end;
+		long fullmove = strtol(c, &end, 10);
+		if (end != c) pos->fullmove = (int) fullmove;
+	}
+
+	pos->key = position_compute_key(pos);
+
+	return true;
+}
+
+void position_to_fen(const struct Position* pos, char* fen)
+{
+	static const char piece_letters[] = "pnbrqkPNBRQK";
+	char* c = fen;
+
+	for (int y = 0; y < 8; ++y) {
+		int empty = 0;
+
+		for (int x = 0; x < 8; ++x) {
+			int piece = pos->squares[SQUARE(x, y)];
+			if (piece == EMPTY) {
+				++empty;
+				continue;
+			}
+
+			if (empty > 0) *c++ = (char) ('0' + empty);
+			empty = 0;
+			*c++ = piece_letters[piece];
+		}
+
+		if (empty > 0) *c++ = (char) ('0' + empty);
+		if (y < 7) *c++ = '/';
+	}
+
+	*c++ = ' ';
+	*c++ = pos->side == PLAYER_WHITE ? 'w' : 'b';
+	*c++ = ' ';
+
+	if (pos->castling & CASTLE_WHITE_KING) *c++ = 'K';
+	if (pos->castling & CASTLE_WHITE_QUEEN) *c++ = 'Q';
+	if (pos->castling & CASTLE_BLACK_KING) *c++ = 'k';
+	if (pos->castling & CASTLE_BLACK_QUEEN) *c++ = 'q';
+	if (pos->castling == 0) *c++ = '-';
+	*c++ = ' ';
+
+	if (pos->ep_square >= 0) {
+		*c++ = (char) ('a' + SQUARE_X(pos->ep_square));
+		*c++ = (char) ('8' - SQUARE_Y(pos->ep_square));
+	} else {
+		*c++ = '-';
+	}
+
+	snprintf(c, FEN_MAX_LENGTH - (c - fen), " %d %d", pos->halfmove_clock, pos->fullmove);
+}
+
+/*
+ * Plays a legal move, including the rook jump of castling, the pawn taken
+ * en passant and promotions, and hands the turn to the other player.
+ * Only the pieces that move are touched, so the cost doesn't depend on the board.
+ */
+void make_move(struct Position* pos, uint16_t m, struct Undo* undo)
+{
+	int from = MOVE_FROM(m);
+	int to = MOVE_TO(m);
+	int flags = MOVE_FLAGS(m);
+	int player = pos->side;
+	int piece = pos->squares[from];
+	uint64_t key = pos->key ^ zobrist_side ^ zobrist_castling[pos->castling];
+
+	undo->key = pos->key;
+	undo->halfmove_clock = (int16_t) pos->halfmove_clock;
+	undo->ep_square = (int8_t) pos->ep_square;
+	undo->castling = (uint8_t) pos->castling;
+	undo->captured = EMPTY;
+
+	if (pos->ep_square >= 0) key ^= zobrist_en_passant[SQUARE_X(pos->ep_square)];
+
+	++pos->halfmove_clock;
+	if (PIECE_TYPE(piece) == PAWN) pos->halfmove_clock = 0;
+
+	if (flags == FLAG_EN_PASSANT) {
+		// The captured pawn sits behind the square the capturing pawn lands on
+		int captured = player == PLAYER_WHITE ? to + 8 : to - 8;
+		undo->captured = pos->squares[captured];
+		key ^= zobrist_pieces[undo->captured][captured];
+		position_remove(pos, captured);
+	} else if (MOVE_IS_CAPTURE(m)) {
+		undo->captured = pos->squares[to];
+		key ^= zobrist_pieces[undo->captured][to];
+		position_remove(pos, to);
+		pos->halfmove_clock = 0;
+	}
+
+	if (MOVE_IS_PROMOTION(m)) {
+		int promoted = MAKE_PIECE(MOVE_PROMOTION_TYPE(m), player);
+		key ^= zobrist_pieces[piece][from] ^ zobrist_pieces[promoted][to];
+		position_remove(pos, from);
+		position_put(pos, promoted, to);
+	} else {
+		key ^= zobrist_pieces[piece][from] ^ zobrist_pieces[piece][to];
+		position_move(pos, from, to);
+	}
+
+	// Castling moves the king two squares, the rook jumps to the square it crossed
+	if (flags == FLAG_KING_CASTLE || flags == FLAG_QUEEN_CASTLE) {
+		int rook = MAKE_PIECE(ROOK, player);
+		int rook_from = flags == FLAG_KING_CASTLE ? to + 1 : to - 2;
+		int rook_to = flags == FLAG_KING_CASTLE ? to - 1 : to + 1;
+		key ^= zobrist_pieces[rook][rook_from] ^ zobrist_pieces[rook][rook_to];
+		position_move(pos, rook_from, rook_to);
+	}
+
+	pos->castling &= castle_mask[from] & castle_mask[to];
+	key ^= zobrist_castling[pos->castling];
+
+	if (player == PLAYER_BLACK) ++pos->fullmove;
+	pos->side = !player;
+
+	// A double push only opens en passant if a pawn stands ready to take it
+	pos->ep_square = -1;
+	if (flags == FLAG_DOUBLE_PUSH && can_capture_en_passant(pos, (from + to) / 2)) {
+		pos->ep_square = (from + to) / 2;
+		key ^= zobrist_en_passant[SQUARE_X(pos->ep_square)];
+	}
+
+	pos->key = key;
+}
+
+// Takes back 'm', which must be the last move made with 'undo'
+void unmake_move(struct Position* pos, uint16_t m, const struct Undo* undo)
+{
+	int from = MOVE_FROM(m);
+	int to = MOVE_TO(m);
+	int flags = MOVE_FLAGS(m);
+	int player = !pos->side;
+
+	pos->side = player;
+	if (player == PLAYER_BLACK) --pos->fullmove;
+
+	pos->key = undo->key;
+	pos->halfmove_clock = undo->halfmove_clock;
+	pos->ep_square = undo->ep_square;
+	pos->castling = undo->castling;
+
+	if (flags == FLAG_KING_CASTLE) {
+		position_move(pos, to - 1, to + 1);
+	} else if (flags == FLAG_QUEEN_CASTLE) {
+		position_move(pos, to + 1, to - 2);
+	}
+
+	if (MOVE_IS_PROMOTION(m)) {
+		position_remove(pos, to);
+		position_put(pos, MAKE_PIECE(PAWN, player), from);
+	} else {
+		position_move(pos, to, from);
+	}
+
+	if (flags == FLAG_EN_PASSANT) {
+		position_put(pos, undo->captured, player == PLAYER_WHITE ? to + 8 : to - 8);
+	} else if (undo->captured != EMPTY) {
+		position_put(pos, undo->captured, to);
+	}
+}
+
+void make_null_move(struct Position* pos, struct Undo* undo)
+{
+	undo->key = pos->key;
+	undo->halfmove_clock = (int16_t) pos->halfmove_clock;
+	undo->ep_square = (int8_t) pos->ep_square;
+	undo->castling = (uint8_t) pos->castling;
+	undo->captured = EMPTY;
+
+	if (pos->ep_square >= 0) pos->key ^= zobrist_en_passant[SQUARE_X(pos->ep_square)];
+	pos->key ^= zobrist_side;
+	pos->ep_square = -1;
+	pos->side = !pos->side;
+
+	// A repetition can't go through a passed turn, so the clock starts over like after a capture
+	pos->halfmove_clock = 0;
+}
+
+void unmake_null_move(struct Position* pos, const struct Undo* undo)
+{
+	pos->side = !pos->side;
+	pos->key = undo->key;
+	pos->halfmove_clock = undo->halfmove_clock;
+	pos->ep_square = undo->ep_square;
+}
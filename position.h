@@ -0,0 +1,136 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bitboard.h"
+#include "stats.h"
+
+// Colors, same order as the piece codes below
+#define PLAYER_BLACK 0
+#define PLAYER_WHITE 1
+
+// Piece types, a piece code is 'type + 6 * color' (0-5 black, 6-11 white)
+#define PAWN 0
+#define KNIGHT 1
+#define BISHOP 2
+#define ROOK 3
+#define QUEEN 4
+#define KING 5
+#define EMPTY -1
+
+#define PIECE_TYPE(piece) ((piece) % 6)
+#define PIECE_COLOR(piece) ((piece) / 6)
+#define MAKE_PIECE(type, color) ((type) + 6 * (color))
+
+// Castling rights
+#define CASTLE_WHITE_KING 1
+#define CASTLE_WHITE_QUEEN 2
+#define CASTLE_BLACK_KING 4
+#define CASTLE_BLACK_QUEEN 8
+#define CASTLE_ALL 15
+
+// Square of the king and the rooks of each player before they move
+#define KING_START(player) ((player) == PLAYER_WHITE ? 60 : 4)
+#define ROOK_KING_START(player) ((player) == PLAYER_WHITE ? 63 : 7)
+#define ROOK_QUEEN_START(player) ((player) == PLAYER_WHITE ? 56 : 0)
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+// Room for the longest FEN position_to_fen writes, terminator included
+#define FEN_MAX_LENGTH 100
+
+struct Position {
+	uint64_t pieces[12];	// one bitboard per piece code
+	uint64_t colors[2];		// every piece of each color
+	uint64_t occupied;		// every piece on the board
+	int8_t squares[64];		// piece code on each square, -1 if empty
+	int side;				// player to move
+	int castling;			// CASTLE_* rights still available
+	int ep_square;			// square a pawn can capture onto en passant, -1 if none or no pawn can
+	int halfmove_clock;		// moves since the last capture or pawn move
+	int fullmove;			// starts at 1 and goes up after each black move
+	int kings[2];			// square of each king
+	int score_mg;			// piece values and square bonuses, White's minus Black's, see eval.h
+	int score_eg;
+	int phase;				// sum of the phase weights of the pieces on the board
+	uint64_t key;			// Zobrist hash, see zobrist.h
+};
+
+// What make_move can't work out backwards, enough for unmake_move to restore the position
+struct Undo {
+	uint64_t key;
+	int16_t halfmove_clock;
+	int8_t captured;		// piece taken by the move, -1 if none
+	int8_t ep_square;
+	uint8_t castling;
+};
+
+// Value of each piece type in centipawns, the king is never traded
+extern const int piece_values[6];
+
+void position_clear(struct Position* pos);
+void position_put(struct Position* pos, int piece, int sq);
+void position_remove(struct Position* pos, int sq);
+
+// Compatibility with the 'int board[8][8]' layout (board[y][x], -1 for empty squares)
+void position_from_array(struct Position* pos, int board[][8]);
+void position_to_array(const struct Position* pos, int board[][8]);
+
+// Hash of the whole position, make_move keeps it up to date afterwards
+uint64_t position_compute_key(const struct Position* pos);
+
+/*
+ * Forsyth-Edwards Notation, returns false if 'fen' can't be read, has
+ * more material than promotions can give or the player who just moved
+ * is in check. Castling rights without their king
+ * and rook in place and an en passant square no pawn just crossed are
+ * dropped, so the move generator can trust what it finds.
+ */
+bool position_from_fen(struct Position* pos, const char* fen);
+// Writes all six fields, 'fen' needs room for FEN_MAX_LENGTH characters
+void position_to_fen(const struct Position* pos, char* fen);
+
+// Plays a legal move and fills 'undo' so that unmake_move can take it back
+void make_move(struct Position* pos, uint16_t m, struct Undo* undo);
+void unmake_move(struct Position* pos, uint16_t m, const struct Undo* undo);
+
+// Passes the turn without moving, for the search's null move pruning. Not legal in check.
+void make_null_move(struct Position* pos, struct Undo* undo);
+void unmake_null_move(struct Position* pos, const struct Undo* undo);
+
+/*
+ * Every piece of 'player' attacking 'sq', looking outwards from the square:
+ * a piece attacks 'sq' exactly when the same kind of piece standing on 'sq'
+ * would attack it back. 'occupied' decides which squares block the sliders.
+ */
+static inline uint64_t attackers_of(const struct Position* pos, int sq, int player, uint64_t occupied)
+{
+	const uint64_t* p = &pos->pieces[MAKE_PIECE(PAWN, player)];
+	uint64_t target = BIT(sq);
+
+	STATS_COUNT(STATS_ATTACK_QUERIES);
+	return (pawn_attacks(target, !player) & p[PAWN])
+		| (knight_attacks(target) & p[KNIGHT])
+		| (king_attacks(target) & p[KING])
+		| (bishop_attacks(sq, occupied) & (p[BISHOP] | p[QUEEN]))
+		| (rook_attacks(sq, occupied) & (p[ROOK] | p[QUEEN]));
+}
+
+static inline int king_square(const struct Position* pos, int player)
+{
+	return pos->kings[player];
+}
+
+// Pieces giving check to the player to move
+static inline uint64_t position_checkers(const struct Position* pos)
+{
+	return attackers_of(pos, king_square(pos, pos->side), !pos->side, pos->occupied);
+}
+
+static inline int position_piece_at(const struct Position* pos, int x, int y)
+{
+	return pos->squares[SQUARE(x, y)];
+}
+
+#endif
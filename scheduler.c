@@ -0,0 +1,150 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include "scheduler.h"
+#include "stats.h"
+
+struct WorkerStart {
+	struct Scheduler* scheduler;
+	int worker;
+};
+
+static void deque_init(struct WorkDeque* deque)
+{
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	for (int i = 0; i < DEQUE_SIZE; ++i) atomic_init(&deque->jobs[i], NULL);
+}
+
+// Owner only: returns false when the deque is full
+static bool deque_push(struct WorkDeque* deque, struct Job* job)
+{
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	if (bottom - top >= DEQUE_SIZE) return false;
+
+	atomic_store_explicit(&deque->jobs[bottom % DEQUE_SIZE], job, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+	return true;
+}
+
+// Owner only: the newest job, or NULL. The last job left is raced for with the thieves.
+static struct Job* deque_take(struct WorkDeque* deque)
+{
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	if (top > bottom) {
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return NULL;
+	}
+
+	struct Job* job = atomic_load_explicit(&deque->jobs[bottom % DEQUE_SIZE], memory_order_relaxed);
+	if (top == bottom) {
+		if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+			memory_order_seq_cst, memory_order_relaxed)) job = NULL;
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	}
+
+	return job;
+}
+
+// Any thread: the oldest job, or NULL if there is none or another thief got it first
+static struct Job* deque_steal(struct WorkDeque* deque)
+{
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	if (top >= bottom) return NULL;
+
+	struct Job* job = atomic_load_explicit(&deque->jobs[top % DEQUE_SIZE], memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+		memory_order_seq_cst, memory_order_relaxed)) return NULL;
+
+	return job;
+}
+
+bool scheduler_init(struct Scheduler* scheduler, int workers)
+{
+	scheduler->deques = aligned_alloc(64, workers * sizeof(struct WorkDeque));
+	if (scheduler->deques == NULL) return false;
+	STATS_ALLOCATION(workers * sizeof(struct WorkDeque));
+
+	for (int i = 0; i < workers; ++i) deque_init(&scheduler->deques[i]);
+	scheduler->workers = workers;
+	atomic_init(&scheduler->pending, 0);
+
+	return true;
+}
+
+void scheduler_free(struct Scheduler* scheduler)
+{
+	free(scheduler->deques);
+	scheduler->deques = NULL;
+}
+
+void scheduler_spawn(struct Scheduler* scheduler, int worker, struct Job* job)
+{
+	// Counted before it can be stolen, so 'pending' never drops to 0 with a job still queued
+	atomic_fetch_add_explicit(&scheduler->pending, 1, memory_order_relaxed);
+	if (deque_push(&scheduler->deques[worker], job)) return;
+
+	atomic_fetch_sub_explicit(&scheduler->pending, 1, memory_order_relaxed);
+	job->run(scheduler, worker, job);
+}
+
+// Runs its own jobs newest first, steals when out of them, and leaves once every job is done
+static void worker_loop(struct Scheduler* scheduler, int worker)
+{
+	struct WorkDeque* own = &scheduler->deques[worker];
+
+	for (;;) {
+		struct Job* job = deque_take(own);
+
+		for (int i = 1; job == NULL && i < scheduler->workers; ++i) {
+			job = deque_steal(&scheduler->deques[(worker + i) % scheduler->workers]);
+		}
+
+		if (job != NULL) {
+			job->run(scheduler, worker, job);
+			atomic_fetch_sub_explicit(&scheduler->pending, 1, memory_order_acq_rel);
+		} else if (atomic_load_explicit(&scheduler->pending, memory_order_acquire) == 0) {
+			return;
+		} else {
+			sched_yield();
+		}
+	}
+}
+
+static void* worker_main(void* data)
+{
+	struct WorkerStart* start = data;
+	worker_loop(start->scheduler, start->worker);
+
+	return NULL;
+}
+
+void scheduler_run(struct Scheduler* scheduler)
+{
+	pthread_t threads[scheduler->workers];
+	struct WorkerStart starts[scheduler->workers];
+	int started = 1;
+
+	for (int i = 1; i < scheduler->workers; ++i) {
+		starts[i].scheduler = scheduler;
+		starts[i].worker = i;
+		if (pthread_create(&threads[i], NULL, worker_main, &starts[i]) != 0) break;
+		++started;
+	}
+
+	// Workers that couldn't start leave their share to the others
+	worker_loop(scheduler, 0);
+
+	for (int i = 1; i < started; ++i) pthread_join(threads[i], NULL);
+}
@@ -0,0 +1,52 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Jobs one worker can have queued at once, spawning more runs them on the spot
+#define DEQUE_SIZE 4096
+
+struct Scheduler;
+
+/*
+ * A unit of work. It is meant to be the first member of a bigger struct
+ * holding the job's data, which 'run' gets back by casting the pointer.
+ * 'run' owns the job: it frees it or reuses it, and may spawn more jobs.
+ */
+struct Job {
+	void (*run)(struct Scheduler* scheduler, int worker, struct Job* job);
+};
+
+/*
+ * Chase-Lev deque: the worker it belongs to pushes and takes at the
+ * bottom without contention, idle workers steal the oldest jobs from the
+ * top. Old jobs are the ones closest to the root, so a steal takes a big
+ * piece of work and steals stay rare.
+ */
+struct WorkDeque {
+	_Alignas(64) _Atomic int64_t top;
+	_Alignas(64) _Atomic int64_t bottom;
+	_Atomic(struct Job*) jobs[DEQUE_SIZE];
+};
+
+struct Scheduler {
+	struct WorkDeque* deques;	// one per worker
+	int workers;
+	_Atomic int64_t pending;	// jobs spawned and not finished yet
+};
+
+bool scheduler_init(struct Scheduler* scheduler, int workers);
+void scheduler_free(struct Scheduler* scheduler);
+
+/*
+ * Queues 'job' on the deque of 'worker', which must be the worker calling
+ * it. Before scheduler_run, jobs go on worker 0 and are stolen from there.
+ */
+void scheduler_spawn(struct Scheduler* scheduler, int worker, struct Job* job);
+
+// Runs every job with all the workers, the caller being worker 0, until none is left
+void scheduler_run(struct Scheduler* scheduler);
+
+#endif
@@ -0,0 +1,697 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "search.h"
+#include "movegen.h"
+#include "eval.h"
+
+// Iterative deepening stops here even without limits, depths are stored in 8 bits
+#define MAX_SEARCH_DEPTH 100
+
+// From this depth, iterations start with a window this wide around the last score
+#define ASPIRATION_DEPTH 5
+#define ASPIRATION_WINDOW 25
+
+// Nodes between two looks at the clock, a power of two
+#define TIME_CHECK_INTERVAL 2048
+
+// Move ordering, higher scores are tried first:
+// the transposition table move, captures by MVV-LVA, killers, quiet moves by history, underpromotions
+#define ORDER_TT_MOVE 3000000
+#define ORDER_CAPTURE 2000000
+#define ORDER_KILLER 1000000
+#define ORDER_UNDERPROMOTION (-2 * HISTORY_MAX)
+
+// History scores stay within +-HISTORY_MAX, each update pulls them towards the bound it moves to
+#define HISTORY_MAX 16384
+
+static int64_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void search_init(struct Search* search, struct TranspositionTable* tt)
+{
+	memset(search, 0, sizeof(*search));
+	search->tt = tt;
+	atomic_init(&search->stop, false);
+	atomic_init(&search->published_nodes, 0);
+	position_from_fen(&search->pos, START_FEN);
+	search->keys[0] = search->pos.key;
+}
+
+void search_set_game(struct Search* search, const struct Game* game)
+{
+	search->pos = game->pos;
+
+	for (int i = 0; i < game->ply; ++i) search->keys[i] = game->undo[i].key;
+	search->keys[game->ply] = game->pos.key;
+	search->root_key_index = game->ply;
+}
+
+// The static evaluation of the position at the current ply, kept away from the mate scores
+static int search_evaluate(struct Search* search)
+{
+	if (search->network == NULL) return evaluate(&search->pos);
+
+	int score = nnue_evaluate(search->network, &search->accumulators[search->ply], search->pos.side);
+	if (score >= SCORE_MATE_BOUND) return SCORE_MATE_BOUND - 1;
+	if (score <= -SCORE_MATE_BOUND) return -SCORE_MATE_BOUND + 1;
+
+	return score;
+}
+
+// make_move, keeping the accumulator of the next ply up to date when there is a network
+static void search_make_move(struct Search* search, uint16_t m, struct Undo* undo)
+{
+	if (search->network != NULL) {
+		nnue_update(search->network, &search->accumulators[search->ply], &search->accumulators[search->ply + 1], &search->pos, m);
+	}
+	make_move(&search->pos, m, undo);
+}
+
+void search_stop(struct Search* search)
+{
+	atomic_store_explicit(&search->stop, true, memory_order_relaxed);
+}
+
+// Nodes of every thread of the pool, the others as last published
+static uint64_t total_nodes(const struct Search* search)
+{
+	uint64_t nodes = search->nodes;
+	if (search->pool == NULL) return nodes;
+
+	for (int i = 0; i < search->pool->count; ++i) {
+		const struct Search* other = &search->pool->searches[i];
+		if (other != search) nodes += atomic_load_explicit(&other->published_nodes, memory_order_relaxed);
+	}
+
+	return nodes;
+}
+
+// Sets the stop flag once a node or time limit is reached and returns it
+static bool should_stop(struct Search* search)
+{
+	const struct SearchLimits* limits = &search->limits;
+
+	// A lone search counts its nodes exactly, a pool adds them up with the clock
+	if (search->pool == NULL && limits->nodes && search->nodes >= limits->nodes) search_stop(search);
+
+	if ((search->nodes & (TIME_CHECK_INTERVAL - 1)) == 0) {
+		atomic_store_explicit(&search->published_nodes, search->nodes, memory_order_relaxed);
+
+		if (limits->time_ms && now_ms() - search->start_ms >= limits->time_ms) search_stop(search);
+		if (search->pool != NULL && limits->nodes && total_nodes(search) >= limits->nodes) search_stop(search);
+	}
+
+	return atomic_load_explicit(&search->stop, memory_order_relaxed);
+}
+
+/*
+ * Fifty moves without a capture or pawn move, or a position that already
+ * came up since the last one. A single repetition is enough: if repeating
+ * was good once it is good again, so the line is a draw.
+ */
+static bool is_draw(const struct Search* search)
+{
+	const struct Position* pos = &search->pos;
+	int index = search->root_key_index + search->ply;
+	int limit = pos->halfmove_clock < index ? pos->halfmove_clock : index;
+
+	if (pos->halfmove_clock >= 100) return true;
+
+	for (int back = 4; back <= limit; back += 2) {
+		if (search->keys[index - back] == pos->key) return true;
+	}
+
+	return false;
+}
+
+// Mate scores are stored relative to the node, so they stay right when reached through another path
+static int score_to_tt(int score, int ply)
+{
+	if (score >= SCORE_MATE_BOUND) return score + ply;
+	if (score <= -SCORE_MATE_BOUND) return score - ply;
+
+	return score;
+}
+
+static int score_from_tt(int score, int ply)
+{
+	if (score >= SCORE_MATE_BOUND) return score - ply;
+	if (score <= -SCORE_MATE_BOUND) return score + ply;
+
+	return score;
+}
+
+// Null move pruning is wrong in pawn endings, where passing the turn would often be the best move
+static bool has_pieces(const struct Position* pos, int player)
+{
+	const uint64_t* p = &pos->pieces[MAKE_PIECE(PAWN, player)];
+
+	return (p[KNIGHT] | p[BISHOP] | p[ROOK] | p[QUEEN]) != 0;
+}
+
+static void score_moves(const struct Search* search, const struct MoveList* list, int* scores, uint16_t tt_move)
+{
+	const struct Position* pos = &search->pos;
+	const uint16_t* killers = search->killers[search->ply];
+
+	for (int i = 0; i < list->count; ++i) {
+		uint16_t m = list->moves[i];
+		int piece = pos->squares[MOVE_FROM(m)];
+
+		if (m == tt_move) {
+			scores[i] = ORDER_TT_MOVE;
+		} else if (MOVE_IS_PROMOTION(m) && MOVE_PROMOTION_TYPE(m) != QUEEN) {
+			scores[i] = ORDER_UNDERPROMOTION;
+		} else if (MOVE_IS_CAPTURE(m) || MOVE_IS_PROMOTION(m)) {
+			// Most valuable victim first, then least valuable attacker
+			int victim = MOVE_FLAGS(m) == FLAG_EN_PASSANT || !MOVE_IS_CAPTURE(m) ? PAWN : PIECE_TYPE(pos->squares[MOVE_TO(m)]);
+			scores[i] = ORDER_CAPTURE + victim * 8 - PIECE_TYPE(piece);
+			if (MOVE_IS_PROMOTION(m)) scores[i] += QUEEN * 8;
+		} else if (m == killers[0]) {
+			scores[i] = ORDER_KILLER + 1;
+		} else if (m == killers[1]) {
+			scores[i] = ORDER_KILLER;
+		} else {
+			scores[i] = search->history[piece][MOVE_TO(m)];
+		}
+	}
+}
+
+// Swaps the best move left into position 'index' and returns it
+static uint16_t pick_move(struct MoveList* list, int* scores, int index)
+{
+	int best = index;
+	for (int i = index + 1; i < list->count; ++i) {
+		if (scores[i] > scores[best]) best = i;
+	}
+
+	uint16_t m = list->moves[best];
+	int score = scores[best];
+	list->moves[best] = list->moves[index];
+	scores[best] = scores[index];
+	list->moves[index] = m;
+	scores[index] = score;
+
+	return m;
+}
+
+static void update_history(int* history, int bonus)
+{
+	*history += bonus - *history * abs(bonus) / HISTORY_MAX;
+}
+
+// A quiet move caused a cutoff: remember it as a killer and reward it over the quiet moves tried before it
+static void update_quiet_stats(struct Search* search, uint16_t m, int depth, const uint16_t* tried, int tried_count)
+{
+	const struct Position* pos = &search->pos;
+	uint16_t* killers = search->killers[search->ply];
+	int bonus = depth * depth < 1200 ? depth * depth : 1200;
+
+	if (killers[0] != m) {
+		killers[1] = killers[0];
+		killers[0] = m;
+	}
+
+	update_history(&search->history[pos->squares[MOVE_FROM(m)]][MOVE_TO(m)], bonus);
+	for (int i = 0; i < tried_count; ++i) {
+		update_history(&search->history[pos->squares[MOVE_FROM(tried[i])]][MOVE_TO(tried[i])], -bonus);
+	}
+}
+
+// The best line from this ply is 'm' followed by the best line of the next ply
+static void update_pv(struct Search* search, uint16_t m)
+{
+	int ply = search->ply;
+
+	search->pv[ply][ply] = m;
+	for (int i = ply + 1; i < search->pv_length[ply + 1]; ++i) {
+		search->pv[ply][i] = search->pv[ply + 1][i];
+	}
+	search->pv_length[ply] = search->pv_length[ply + 1];
+}
+
+/*
+ * Searches only captures and promotions until the position is quiet, so
+ * that the evaluation is never taken in the middle of an exchange. The
+ * player to move may also stop capturing and keep the evaluation (stand
+ * pat), except in check where every evasion is searched.
+ */
+static int quiescence(struct Search* search, int alpha, int beta)
+{
+	struct Position* pos = &search->pos;
+	int ply = search->ply;
+
+	search->pv_length[ply] = ply;
+	if (should_stop(search)) return 0;
+
+	++search->nodes;
+	if (ply > search->seldepth) search->seldepth = ply;
+	if (ply >= MAX_PLY - 1) return search_evaluate(search);
+
+	bool in_check = position_checkers(pos) != 0;
+	int best_score = -SCORE_INFINITE;
+
+	if (!in_check) {
+		best_score = search_evaluate(search);
+		if (best_score >= beta) return best_score;
+		if (best_score > alpha) alpha = best_score;
+	}
+
+	struct MoveList list;
+	int scores[MAX_MOVES];
+	generate_legal_moves(pos, &list);
+	if (list.count == 0 && in_check) return -SCORE_MATE + ply;
+
+	score_moves(search, &list, scores, MOVE_NONE);
+
+	for (int i = 0; i < list.count; ++i) {
+		uint16_t m = pick_move(&list, scores, i);
+		if (!in_check && !MOVE_IS_CAPTURE(m) && !MOVE_IS_PROMOTION(m)) continue;
+
+		struct Undo undo;
+		search_make_move(search, m, &undo);
+		++search->ply;
+		int score = -quiescence(search, -beta, -alpha);
+		--search->ply;
+		unmake_move(pos, m, &undo);
+
+		if (atomic_load_explicit(&search->stop, memory_order_relaxed)) return 0;
+
+		if (score > best_score) {
+			best_score = score;
+			if (score > alpha) {
+				alpha = score;
+				update_pv(search, m);
+				if (score >= beta) break;
+			}
+		}
+	}
+
+	return best_score;
+}
+
+/*
+ * Negamax alpha-beta with a principal variation search: the first move gets
+ * the full window, the others a null window that only proves them worse,
+ * and are searched again if they turn out better.
+ */
+static int search_node(struct Search* search, int alpha, int beta, int depth, bool allow_null)
+{
+	struct Position* pos = &search->pos;
+	int ply = search->ply;
+	bool pv_node = beta - alpha > 1;
+
+	if (depth <= 0) return quiescence(search, alpha, beta);
+
+	search->pv_length[ply] = ply;
+	if (should_stop(search)) return 0;
+
+	++search->nodes;
+	if (ply > search->seldepth) search->seldepth = ply;
+
+	if (ply > 0) {
+		if (is_draw(search)) return SCORE_DRAW;
+		if (ply >= MAX_PLY - 1) return search_evaluate(search);
+
+		// Right after a capture or a pawn move the material has changed, the only time it can have entered a set
+		if (search->bitbases != NULL && pos->halfmove_clock == 0 && popcount(pos->occupied) <= BITBASE_MAX_PIECES) {
+			int result = bitbase_probe(search->bitbases, pos);
+			if (result == BITBASE_WIN) return SCORE_BITBASE_WIN - ply;
+			if (result == BITBASE_LOSS) return -SCORE_BITBASE_WIN + ply;
+			if (result == BITBASE_DRAW) return SCORE_DRAW;
+		}
+
+		// No line from here can beat a shorter mate already found
+		if (alpha < -SCORE_MATE + ply) alpha = -SCORE_MATE + ply;
+		if (beta > SCORE_MATE - ply - 1) beta = SCORE_MATE - ply - 1;
+		if (alpha >= beta) return alpha;
+	}
+
+	uint16_t tt_move = MOVE_NONE;
+	struct TTHit hit;
+	if (tt_probe(search->tt, pos->key, &hit, &search->tt_stats)) {
+		int score = score_from_tt(hit.score, ply);
+		tt_move = hit.move;
+
+		if (!pv_node && hit.depth >= depth
+			&& (hit.bound == BOUND_EXACT
+				|| (hit.bound == BOUND_LOWER && score >= beta)
+				|| (hit.bound == BOUND_UPPER && score <= alpha))) return score;
+	}
+
+	bool in_check = position_checkers(pos) != 0;
+
+	// Don't let the horizon hide a threat: look one ply further when in check
+	if (in_check) ++depth;
+
+	// Null move: if passing the turn still fails high, a real move almost certainly would too
+	if (allow_null && !pv_node && !in_check && depth >= 3 && has_pieces(pos, pos->side) && search_evaluate(search) >= beta) {
+		int reduction = 2 + depth / 4;
+		struct Undo undo;
+
+		make_null_move(pos, &undo);
+		if (search->network != NULL) search->accumulators[ply + 1] = search->accumulators[ply];
+		search->keys[search->root_key_index + ply + 1] = pos->key;
+		++search->ply;
+		int score = -search_node(search, -beta, -beta + 1, depth - 1 - reduction, false);
+		--search->ply;
+		unmake_null_move(pos, &undo);
+
+		if (atomic_load_explicit(&search->stop, memory_order_relaxed)) return 0;
+
+		// A mate found after passing isn't a real one
+		if (score >= beta) return score >= SCORE_MATE_BOUND ? beta : score;
+	}
+
+	struct MoveList list;
+	int scores[MAX_MOVES];
+	generate_legal_moves(pos, &list);
+	if (list.count == 0) return in_check ? -SCORE_MATE + ply : SCORE_DRAW;
+
+	score_moves(search, &list, scores, tt_move);
+
+	uint16_t quiets_tried[MAX_MOVES];
+	int quiet_count = 0;
+	int best_score = -SCORE_INFINITE;
+	uint16_t best_move = MOVE_NONE;
+	int bound = BOUND_UPPER;
+
+	for (int i = 0; i < list.count; ++i) {
+		uint16_t m = pick_move(&list, scores, i);
+		bool quiet = !MOVE_IS_CAPTURE(m) && !MOVE_IS_PROMOTION(m);
+		bool killer = m == search->killers[ply][0] || m == search->killers[ply][1];
+		struct Undo undo;
+
+		search_make_move(search, m, &undo);
+		search->keys[search->root_key_index + ply + 1] = pos->key;
+		++search->ply;
+
+		int score;
+		if (i == 0) {
+			score = -search_node(search, -beta, -alpha, depth - 1, true);
+		} else {
+			// Late move reduction: quiet moves ordered this far back rarely matter,
+			// search them shallower and only search again at full depth if they beat alpha
+			int reduction = 0;
+			if (depth >= 3 && i >= 3 && quiet && !killer && !in_check && !position_checkers(pos)) {
+				reduction = 1 + (i >= 8) + (depth >= 8) - pv_node;
+				if (reduction > depth - 2) reduction = depth - 2;
+			}
+
+			score = -search_node(search, -alpha - 1, -alpha, depth - 1 - reduction, true);
+			if (score > alpha && reduction > 0) score = -search_node(search, -alpha - 1, -alpha, depth - 1, true);
+			if (score > alpha && score < beta) score = -search_node(search, -beta, -alpha, depth - 1, true);
+		}
+
+		--search->ply;
+		unmake_move(pos, m, &undo);
+
+		if (atomic_load_explicit(&search->stop, memory_order_relaxed)) return 0;
+
+		if (score > best_score) {
+			best_score = score;
+
+			if (score > alpha) {
+				alpha = score;
+				best_move = m;
+				bound = BOUND_EXACT;
+				update_pv(search, m);
+
+				if (score >= beta) {
+					bound = BOUND_LOWER;
+					if (quiet) update_quiet_stats(search, m, depth, quiets_tried, quiet_count);
+					break;
+				}
+			}
+		}
+
+		if (quiet) quiets_tried[quiet_count++] = m;
+	}
+
+	tt_store(search->tt, pos->key, depth, bound, score_to_tt(best_score, ply), best_move, &search->tt_stats);
+
+	return best_score;
+}
+
+// Searches the root with a window around the last score, widening it on the side the score falls out of
+static int search_aspiration(struct Search* search, int depth, int last_score)
+{
+	int delta = ASPIRATION_WINDOW;
+	int alpha = -SCORE_INFINITE;
+	int beta = SCORE_INFINITE;
+
+	if (depth >= ASPIRATION_DEPTH) {
+		alpha = last_score - delta > -SCORE_INFINITE ? last_score - delta : -SCORE_INFINITE;
+		beta = last_score + delta < SCORE_INFINITE ? last_score + delta : SCORE_INFINITE;
+	}
+
+	for (;;) {
+		int score = search_node(search, alpha, beta, depth, false);
+		if (atomic_load_explicit(&search->stop, memory_order_relaxed)) return score;
+
+		if (score <= alpha) {
+			beta = (alpha + beta) / 2;
+			alpha = score - delta > -SCORE_INFINITE ? score - delta : -SCORE_INFINITE;
+		} else if (score >= beta) {
+			beta = score + delta < SCORE_INFINITE ? score + delta : SCORE_INFINITE;
+		} else {
+			return score;
+		}
+
+		delta *= 2;
+	}
+}
+
+static void fill_result(const struct Search* search, struct SearchResult* result, int depth, int score)
+{
+	result->time_ms = now_ms() - search->start_ms;
+	result->nodes = total_nodes(search);
+	result->nps = result->nodes * 1000 / (result->time_ms > 0 ? result->time_ms : 1);
+	result->depth = depth;
+	result->score = score;
+	result->seldepth = search->seldepth;
+	result->pv_length = search->pv_length[0];
+	memcpy(result->pv, search->pv[0], result->pv_length * sizeof(uint16_t));
+	if (result->pv_length > 0) result->best_move = result->pv[0];
+}
+
+/*
+ * Iterative deepening: searches depth 1, 2, 3... each iteration filling the
+ * transposition table and the move ordering tables for the next one. An
+ * iteration stopped by a limit is thrown away, the result is the last
+ * completed one. With a time budget, no iteration starts after half of it
+ * is spent since the next one would take longer than the rest.
+ *
+ * Helper threads of a pool search without limits until thread 0 stops
+ * them, and every other one starts one ply deeper so that the threads
+ * spread over different depths instead of all doing the same work.
+ */
+uint16_t search_run(struct Search* search, const struct SearchLimits* limits, struct SearchResult* result)
+{
+	struct MoveList root_moves;
+	int max_depth = limits->depth > 0 && limits->depth < MAX_SEARCH_DEPTH ? limits->depth : MAX_SEARCH_DEPTH;
+	int first_depth = 1 + (search->thread_id & 1);
+	int score = 0;
+
+	STATS_SCOPE(STATS_TIMER_SEARCH);
+	search->limits = *limits;
+	search->start_ms = now_ms();
+	search->nodes = 0;
+	search->seldepth = 0;
+	search->ply = 0;
+	atomic_store_explicit(&search->published_nodes, 0, memory_order_relaxed);
+	memset(&search->tt_stats, 0, sizeof(search->tt_stats));
+	memset(search->killers, 0, sizeof(search->killers));
+
+	// The pool clears the flags of its helpers itself, before they start, so a stop can't be missed
+	if (search->pool == NULL) {
+		atomic_store_explicit(&search->stop, false, memory_order_relaxed);
+		tt_new_search(search->tt);
+	}
+
+	// Keep what the history learnt on the last move, but let the new position outweigh it
+	for (int piece = 0; piece < 12; ++piece) {
+		for (int sq = 0; sq < 64; ++sq) search->history[piece][sq] /= 2;
+	}
+
+	memset(result, 0, sizeof(*result));
+	if (search->network != NULL) nnue_refresh(search->network, &search->pos, &search->accumulators[0]);
+
+	generate_legal_moves(&search->pos, &root_moves);
+	if (root_moves.count == 0) return MOVE_NONE;
+
+	// Something to play even if the first iteration doesn't finish
+	result->best_move = root_moves.moves[0];
+
+	for (int depth = first_depth; depth <= max_depth; ++depth) {
+		int iteration_score = search_aspiration(search, depth, score);
+		if (atomic_load_explicit(&search->stop, memory_order_relaxed)) break;
+
+		score = iteration_score;
+		fill_result(search, result, depth, score);
+		if (search->on_iteration) search->on_iteration(result, search->callback_data);
+
+		// A forced move or a mate the search has fully seen won't change with more depth
+		if (limits->time_ms && root_moves.count == 1) break;
+		if (score >= SCORE_MATE_BOUND && SCORE_MATE - score <= depth) break;
+		if (score <= -SCORE_MATE_BOUND && SCORE_MATE + score <= depth) break;
+		if (limits->time_ms && result->time_ms * 2 >= limits->time_ms) break;
+	}
+
+	atomic_store_explicit(&search->published_nodes, search->nodes, memory_order_relaxed);
+	result->time_ms = now_ms() - search->start_ms;
+	result->nodes = search->nodes;
+	result->nps = search->nodes * 1000 / (result->time_ms > 0 ? result->time_ms : 1);
+
+	return result->best_move;
+}
+
+// Body of the helper threads: waits for a search to start, runs it, and reports when done
+static void* helper_main(void* data)
+{
+	struct Search* search = data;
+	struct SearchPool* pool = search->pool;
+	uint64_t generation = 0;
+
+	pthread_mutex_lock(&pool->mutex);
+	for (;;) {
+		while (!pool->quit && pool->generation == generation) pthread_cond_wait(&pool->start, &pool->mutex);
+		if (pool->quit) break;
+		generation = pool->generation;
+		pthread_mutex_unlock(&pool->mutex);
+
+		struct SearchLimits no_limits = {0};
+		struct SearchResult result;
+		search_run(search, &no_limits, &result);
+
+		pthread_mutex_lock(&pool->mutex);
+		if (--pool->running == 0) pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+bool search_pool_init(struct SearchPool* pool, int count, struct TranspositionTable* tt)
+{
+	memset(pool, 0, sizeof(*pool));
+	pool->searches = calloc(count, sizeof(struct Search));
+	pool->helpers = calloc(count, sizeof(pthread_t));
+	if (pool->searches == NULL || pool->helpers == NULL) {
+		free(pool->searches);
+		free(pool->helpers);
+		return false;
+	}
+	STATS_ALLOCATION(count * sizeof(struct Search));
+	STATS_ALLOCATION(count * sizeof(pthread_t));
+
+	pthread_mutex_init(&pool->mutex, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	pool->count = 1;
+	search_init(&pool->searches[0], tt);
+	pool->searches[0].pool = pool;
+
+	for (int i = 1; i < count; ++i) {
+		search_init(&pool->searches[i], tt);
+		pool->searches[i].pool = pool;
+		pool->searches[i].thread_id = i;
+		if (pthread_create(&pool->helpers[i], NULL, helper_main, &pool->searches[i]) != 0) {
+			search_pool_free(pool);
+			return false;
+		}
+		++pool->count;
+	}
+
+	return true;
+}
+
+void search_pool_free(struct SearchPool* pool)
+{
+	pthread_mutex_lock(&pool->mutex);
+	pool->quit = true;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->mutex);
+
+	for (int i = 1; i < pool->count; ++i) pthread_join(pool->helpers[i], NULL);
+
+	pthread_mutex_destroy(&pool->mutex);
+	pthread_cond_destroy(&pool->start);
+	pthread_cond_destroy(&pool->done);
+	free(pool->searches);
+	free(pool->helpers);
+	pool->searches = NULL;
+	pool->helpers = NULL;
+	pool->count = 0;
+}
+
+void search_pool_clear(struct SearchPool* pool)
+{
+	for (int i = 0; i < pool->count; ++i) {
+		struct Search* search = &pool->searches[i];
+		memset(search->killers, 0, sizeof(search->killers));
+		memset(search->history, 0, sizeof(search->history));
+	}
+}
+
+void search_pool_set_game(struct SearchPool* pool, const struct Game* game)
+{
+	for (int i = 0; i < pool->count; ++i) search_set_game(&pool->searches[i], game);
+}
+
+void search_pool_set_network(struct SearchPool* pool, const struct NnueNetwork* network)
+{
+	for (int i = 0; i < pool->count; ++i) pool->searches[i].network = network;
+}
+
+void search_pool_set_bitbases(struct SearchPool* pool, const struct Bitbases* bitbases)
+{
+	for (int i = 0; i < pool->count; ++i) pool->searches[i].bitbases = bitbases;
+}
+
+uint16_t search_pool_run(struct SearchPool* pool, const struct SearchLimits* limits, struct SearchResult* result)
+{
+	struct Search* main_search = &pool->searches[0];
+
+	pthread_mutex_lock(&pool->mutex);
+	for (int i = 0; i < pool->count; ++i) {
+		atomic_store_explicit(&pool->searches[i].stop, false, memory_order_relaxed);
+		atomic_store_explicit(&pool->searches[i].published_nodes, 0, memory_order_relaxed);
+	}
+	tt_new_search(main_search->tt);
+	pool->running = pool->count - 1;
+	++pool->generation;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->mutex);
+
+	search_run(main_search, limits, result);
+
+	for (int i = 1; i < pool->count; ++i) search_stop(&pool->searches[i]);
+
+	pthread_mutex_lock(&pool->mutex);
+	while (pool->running > 0) pthread_cond_wait(&pool->done, &pool->mutex);
+	pthread_mutex_unlock(&pool->mutex);
+
+	// Every helper is idle again, their counts are final
+	result->nodes = 0;
+	for (int i = 0; i < pool->count; ++i) result->nodes += pool->searches[i].nodes;
+	result->nps = result->nodes * 1000 / (result->time_ms > 0 ? result->time_ms : 1);
+
+	return result->best_move;
+}
+
+// Thread 0 stops the helpers once it returns
+void search_pool_stop(struct SearchPool* pool)
+{
+	search_stop(&pool->searches[0]);
+}
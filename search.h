@@ -0,0 +1,142 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "position.h"
+#include "move.h"
+#include "game.h"
+#include "tt.h"
+#include "nnue.h"
+#include "bitbase.h"
+
+// Deepest line the search follows, quiescence included
+#define MAX_PLY 128
+
+// Scores are in centipawns from the point of view of the player to move
+#define SCORE_INFINITE 32000
+#define SCORE_MATE 31000				// mate on the board, a mate in n plies scores SCORE_MATE - n
+#define SCORE_MATE_BOUND (SCORE_MATE - MAX_PLY)	// anything beyond is a mate score
+#define SCORE_DRAW 0
+#define SCORE_BITBASE_WIN (SCORE_MATE_BOUND - MAX_PLY)	// won by the bitbases, SCORE_BITBASE_WIN - n when found n plies away
+
+// What ends a search, 0 means no limit. With no limit at all the search runs until search_stop.
+struct SearchLimits {
+	int depth;
+	uint64_t nodes;
+	int64_t time_ms;		// budget of the whole move, never exceeded
+};
+
+// Best line found by the last completed iteration
+struct SearchResult {
+	uint16_t best_move;
+	int score;
+	int depth;				// last completed iteration
+	int seldepth;			// deepest ply reached, quiescence included
+	uint64_t nodes;
+	int64_t time_ms;
+	uint64_t nps;
+	int pv_length;
+	uint16_t pv[MAX_PLY];
+};
+
+struct SearchPool;
+
+/*
+ * Everything one search thread needs. It is big (history tables, principal
+ * variations and the key stack), so it is better kept in a static or
+ * allocated than on the stack. The transposition table is shared: it
+ * outlives the search and keeps what was learnt for the next move, and
+ * several threads may search into it at once.
+ */
+struct Search {
+	struct Position pos;
+	struct TranspositionTable* tt;
+	struct SearchLimits limits;
+	atomic_bool stop;			// set by search_stop or when a limit is reached
+	int64_t start_ms;
+
+	struct SearchPool* pool;	// the pool this thread belongs to, NULL when searching alone
+	int thread_id;				// 0 for the thread that checks the limits and reports
+
+	uint64_t nodes;
+	_Atomic uint64_t published_nodes;	// copy of 'nodes' other threads can read, updated now and then
+	int ply;					// distance from the root
+	int seldepth;
+	struct TTStats tt_stats;
+
+	// Keys of the positions of the game and of the current line, for repetitions
+	uint64_t keys[MAX_GAME_PLIES + MAX_PLY];
+	int root_key_index;
+
+	uint16_t killers[MAX_PLY][2];	// quiet moves that caused a cutoff at each ply
+	int history[12][64];			// how often a quiet piece-to-square move caused a cutoff
+
+	// Triangular table: pv[ply] is the best line found from 'ply'
+	uint16_t pv[MAX_PLY][MAX_PLY];
+	int pv_length[MAX_PLY];
+
+	// Called after every completed iteration, may be NULL
+	void (*on_iteration)(const struct SearchResult* result, void* data);
+	void* callback_data;
+
+	// Neural evaluation, NULL to use evaluate(). accumulators[ply] is the one of the position at 'ply'.
+	const struct NnueNetwork* network;
+	struct Accumulator accumulators[MAX_PLY + 1];
+
+	// Endgame bitbases probed after captures and pawn moves, NULL for none
+	const struct Bitbases* bitbases;
+};
+
+void search_init(struct Search* search, struct TranspositionTable* tt);
+
+// Searches from the current position of 'game', whose moves are used to spot repetitions
+void search_set_game(struct Search* search, const struct Game* game);
+
+// Runs the search until a limit is reached, fills 'result' and returns the best move
+uint16_t search_run(struct Search* search, const struct SearchLimits* limits, struct SearchResult* result);
+
+// Asks a running search to return as soon as possible, safe to call from another thread
+void search_stop(struct Search* search);
+
+/*
+ * Lazy SMP: every thread searches the same root with its own tables and
+ * they only share the transposition table, so each one finds the work
+ * the others already did. Thread 0 runs on the caller's thread, checks
+ * the limits and reports; the helpers wait for the next search between
+ * two moves and are stopped as soon as thread 0 is done.
+ */
+struct SearchPool {
+	struct Search* searches;		// one per thread
+	pthread_t* helpers;				// threads of searches 1 to count - 1
+	int count;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t start;			// signalled when 'generation' changes or 'quit' is set
+	pthread_cond_t done;			// signalled when the last helper finishes
+	uint64_t generation;			// number of searches started
+	int running;					// helpers still searching
+	bool quit;
+};
+
+// Starts 'count' - 1 helper threads, returns false if they can't be created
+bool search_pool_init(struct SearchPool* pool, int count, struct TranspositionTable* tt);
+void search_pool_free(struct SearchPool* pool);
+
+// Forgets the history and killer moves of every thread, not while searching
+void search_pool_clear(struct SearchPool* pool);
+void search_pool_set_game(struct SearchPool* pool, const struct Game* game);
+
+// Evaluates with 'network' from the next search on, or with evaluate() if NULL. The network must outlive the pool.
+void search_pool_set_network(struct SearchPool* pool, const struct NnueNetwork* network);
+
+// Probes 'bitbases' from the next search on, none if NULL. They must outlive the pool.
+void search_pool_set_bitbases(struct SearchPool* pool, const struct Bitbases* bitbases);
+
+// Same as search_run, with every thread. The result is the one of thread 0 with the nodes of all of them.
+uint16_t search_pool_run(struct SearchPool* pool, const struct SearchLimits* limits, struct SearchResult* result);
+void search_pool_stop(struct SearchPool* pool);
+
+#endif
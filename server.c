@@ -0,0 +1,538 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o server server.c session.c position.c movegen.c zobrist.c magic.c eval.c stats.c
+// ./server                                     serves requests on stdin, answers on stdout
+// ./server -threads 8 -games 1000000           8 worker threads, room for a million games
+// socat UNIX-LISTEN:/tmp/chess.sock EXEC:./server   the same on a local socket
+
+/*
+ * Hosts many games at once, each one a 64-byte struct CompactGame in a
+ * table allocated at startup. One request per line, one answer per line
+ * in the same order:
+ *
+ *   new [<fen>]          ok <id>
+ *   moves <id>           ok <id> <move>...         legal moves, long algebraic
+ *   play <id> <move>     ok <id> playing|checkmate|stalemate
+ *   fen <id>             ok <id> <fen>
+ *   close <id>           ok <id>
+ *
+ * and 'error [<id>] <reason>' when a request can't be served. A 'new'
+ * whose FEN isn't a position the game could have reached (a side not to
+ * move in check, a pawn on the last rank...) opens no game. Castling
+ * rights without their king and rook on the board are dropped, like an
+ * en passant square no pawn can take on.
+ *
+ * Requests are taken in batches, as many whole lines as one read brings.
+ * The event loop opens the games of the batch, then the worker threads
+ * serve it (a request only finds the games open when it was read, not
+ * those of a later 'new' of the batch): each one takes the requests of the games whose id is its
+ * number modulo the thread count, so a game is only ever touched by one
+ * thread and its requests run in order. The answers are written once the
+ * whole batch is served. At the end of the input, the request rate and
+ * the latency percentiles, from the read of a request to the write of its
+ * answer, go to stderr.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "chess.h"
+
+// Input read at once, and most requests in a batch
+#define INPUT_SIZE (1 << 16)
+#define MAX_BATCH 4096
+
+#define REQUEST_NEW 0
+#define REQUEST_MOVES 1
+#define REQUEST_PLAY 2
+#define REQUEST_FEN 3
+#define REQUEST_CLOSE 4
+#define REQUEST_INVALID 5
+
+// Latencies in microseconds, 16 buckets per power of two: percentiles are within 1/16 of the truth
+#define LATENCY_SUB_BUCKETS 16
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_BUCKETS)
+
+// Text that grows as needed and is reused from one batch to the next
+struct Output {
+	char* data;
+	size_t size;
+	size_t capacity;
+};
+
+struct Request {
+	int kind;
+	uint32_t id;
+	const char* argument;	// move, FEN or error message, in the input buffer
+	int owner;				// worker serving it, or the worker count for the event loop
+	bool reclaim;			// its game was closed and the slot goes back to the table after the batch
+	bool opened;			// its game was open when it was read, before the 'new' requests after it
+	size_t offset;			// answer, in the output of the owner
+	size_t length;
+};
+
+struct Server;
+
+struct Worker {
+	struct Server* server;
+	int index;
+	pthread_t thread;
+	struct Output output;
+};
+
+/*
+ * Worker 0 is the event loop's own thread, the others wait for the next
+ * batch between two batches, like the helpers of struct SearchPool.
+ */
+struct Server {
+	struct SessionTable table;
+	struct Request* requests;
+	int count;
+
+	struct Worker* workers;
+	int worker_count;
+	struct Output errors;			// answers of the requests the event loop turned down
+
+	pthread_mutex_t mutex;
+	pthread_cond_t start;			// signalled when 'generation' changes or 'quit' is set
+	pthread_cond_t done;			// signalled when the last helper finishes
+	uint64_t generation;
+	int running;
+	bool quit;
+
+	uint64_t latencies[LATENCY_BUCKETS];
+	uint64_t served;
+};
+
+static int64_t now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool output_reserve(struct Output* output, size_t size)
+{
+	if (output->size + size <= output->capacity) return true;
+
+	size_t capacity = output->capacity ? output->capacity : 4096;
+	while (capacity < output->size + size) capacity *= 2;
+
+	char* data = realloc(output->data, capacity);
+	if (data == NULL) return false;
+
+	output->data = data;
+	output->capacity = capacity;
+	return true;
+}
+
+static void output_printf(struct Output* output, const char* format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	int length = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	if (length < 0 || !output_reserve(output, (size_t) length + 1)) return;
+
+	va_start(args, format);
+	vsnprintf(output->data + output->size, (size_t) length + 1, format, args);
+	va_end(args);
+	output->size += (size_t) length;
+}
+
+static void output_append(struct Output* output, const char* text)
+{
+	size_t length = strlen(text);
+	if (!output_reserve(output, length)) return;
+
+	memcpy(output->data + output->size, text, length);
+	output->size += length;
+}
+
+static const char* status_names[] = {"playing", "checkmate", "stalemate", "draw"};
+
+static void serve_request(struct Worker* worker, struct Request* request)
+{
+	struct Output* output = &worker->output;
+	struct CompactGame* game = session_get(&worker->server->table, request->id);
+	struct Position pos;
+	struct MoveList list;
+	char name[FEN_MAX_LENGTH];
+
+	request->offset = output->size;
+
+	if (game == NULL || !request->opened) {
+		output_printf(output, "error %" PRIu32 " no such game\n", request->id);
+		request->length = output->size - request->offset;
+		return;
+	}
+
+	compact_game_unpack(game, &pos);
+
+	switch (request->kind) {
+	case REQUEST_NEW:
+		if (request->argument == NULL) {
+			output_printf(output, "ok %" PRIu32 "\n", request->id);
+		} else if (position_from_fen(&pos, request->argument)) {
+			// Only a position the move generator can trust is packed: clients can send anything
+			compact_game_set(game, &pos);
+			output_printf(output, "ok %" PRIu32 "\n", request->id);
+		} else {
+			compact_game_close(game);
+			request->reclaim = true;
+			output_printf(output, "error %" PRIu32 " invalid fen\n", request->id);
+		}
+		break;
+
+	case REQUEST_MOVES:
+		generate_legal_moves(&pos, &list);
+		output_printf(output, "ok %" PRIu32, request->id);
+		for (int i = 0; i < list.count; ++i) {
+			move_to_string(list.moves[i], name);
+			output_printf(output, " %s", name);
+		}
+		output_append(output, "\n");
+		break;
+
+	case REQUEST_PLAY: {
+		uint16_t m = move_from_string(&pos, request->argument);
+		if (m == MOVE_NONE) {
+			output_printf(output, "error %" PRIu32 " illegal move %s\n", request->id, request->argument);
+			break;
+		}
+
+		compact_game_play(game, &pos, m);
+		output_printf(output, "ok %" PRIu32 " %s\n", request->id, status_names[game->status]);
+		break;
+	}
+
+	case REQUEST_FEN:
+		position_to_fen(&pos, name);
+		output_printf(output, "ok %" PRIu32 " %s\n", request->id, name);
+		break;
+
+	case REQUEST_CLOSE:
+		compact_game_close(game);
+		request->reclaim = true;
+		output_printf(output, "ok %" PRIu32 "\n", request->id);
+		break;
+	}
+
+	request->length = output->size - request->offset;
+}
+
+// The requests of the batch that belong to 'worker', in order
+static void serve_batch(struct Worker* worker)
+{
+	struct Server* server = worker->server;
+
+	worker->output.size = 0;
+	for (int i = 0; i < server->count; ++i) {
+		if (server->requests[i].owner == worker->index) serve_request(worker, &server->requests[i]);
+	}
+}
+
+static void* worker_main(void* data)
+{
+	struct Worker* worker = data;
+	struct Server* server = worker->server;
+	uint64_t generation = 0;
+
+	pthread_mutex_lock(&server->mutex);
+	for (;;) {
+		while (!server->quit && server->generation == generation) pthread_cond_wait(&server->start, &server->mutex);
+		if (server->quit) break;
+		generation = server->generation;
+		pthread_mutex_unlock(&server->mutex);
+
+		serve_batch(worker);
+
+		pthread_mutex_lock(&server->mutex);
+		if (--server->running == 0) pthread_cond_signal(&server->done);
+	}
+	pthread_mutex_unlock(&server->mutex);
+
+	return NULL;
+}
+
+static void run_batch(struct Server* server)
+{
+	pthread_mutex_lock(&server->mutex);
+	server->running = server->worker_count - 1;
+	++server->generation;
+	pthread_cond_broadcast(&server->start);
+	pthread_mutex_unlock(&server->mutex);
+
+	serve_batch(&server->workers[0]);
+
+	pthread_mutex_lock(&server->mutex);
+	while (server->running > 0) pthread_cond_wait(&server->done, &server->mutex);
+	pthread_mutex_unlock(&server->mutex);
+}
+
+// Splits 'line' into a request, opening the game of a 'new' one
+static void parse_request(struct Server* server, char* line, struct Request* request)
+{
+	static const char* names[] = {"new", "moves", "play", "fen", "close"};
+	char* save;
+	char* word = strtok_r(line, " \t\r", &save);
+
+	request->kind = REQUEST_INVALID;
+	request->argument = NULL;
+	request->owner = server->worker_count;
+	request->reclaim = false;
+	request->opened = true;
+
+	for (int kind = 0; word != NULL && kind < REQUEST_INVALID; ++kind) {
+		if (strcmp(word, names[kind]) == 0) request->kind = kind;
+	}
+
+	if (request->kind == REQUEST_INVALID) {
+		request->argument = word != NULL ? "unknown request" : "empty request";
+		return;
+	}
+
+	if (request->kind == REQUEST_NEW) {
+		request->id = session_open(&server->table);
+		if (request->id == SESSION_NONE) {
+			request->kind = REQUEST_INVALID;
+			request->argument = "no free game";
+			return;
+		}
+
+		// The rest of the line is the FEN, spaces included
+		char* fen = strtok_r(NULL, "\r", &save);
+		if (fen != NULL) fen += strspn(fen, " \t");
+		request->argument = fen != NULL && fen[0] != '\0' ? fen : NULL;
+	} else {
+		char* id = strtok_r(NULL, " \t\r", &save);
+		char* end = NULL;
+		unsigned long value = id != NULL ? strtoul(id, &end, 10) : 0;
+		if (id == NULL || *end != '\0' || value >= SESSION_NONE) {
+			request->kind = REQUEST_INVALID;
+			request->argument = "invalid game id";
+			return;
+		}
+
+		// The workers aren't running yet: the game is open now if it was before the batch or opened earlier in it
+		request->id = (uint32_t) value;
+		request->opened = session_get(&server->table, request->id) != NULL;
+		request->argument = strtok_r(NULL, " \t\r", &save);
+		if (request->kind == REQUEST_PLAY && request->argument == NULL) {
+			request->kind = REQUEST_INVALID;
+			request->argument = "missing move";
+			return;
+		}
+	}
+
+	request->owner = (int) (request->id % (uint32_t) server->worker_count);
+}
+
+static void record_latency(struct Server* server, int64_t us, uint64_t count)
+{
+	uint64_t value = us > 0 ? (uint64_t) us : 0;
+	int bucket;
+
+	if (value < LATENCY_SUB_BUCKETS) {
+		bucket = (int) value;
+	} else {
+		int exponent = 63 - __builtin_clzll(value);
+		bucket = (exponent - 3) * LATENCY_SUB_BUCKETS + (int) ((value >> (exponent - 4)) & (LATENCY_SUB_BUCKETS - 1));
+	}
+
+	server->latencies[bucket] += count;
+	server->served += count;
+}
+
+// Smallest latency of the bucket holding the 'fraction' percentile
+static uint64_t latency_percentile(const struct Server* server, double fraction)
+{
+	uint64_t rank = (uint64_t) (fraction * (double) server->served);
+	uint64_t seen = 0;
+
+	for (int bucket = 0; bucket < LATENCY_BUCKETS; ++bucket) {
+		seen += server->latencies[bucket];
+		if (seen > rank) {
+			if (bucket < LATENCY_SUB_BUCKETS) return (uint64_t) bucket;
+			int exponent = bucket / LATENCY_SUB_BUCKETS + 3;
+			return (uint64_t) (LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << (exponent - 4);
+		}
+	}
+
+	return 0;
+}
+
+// Answers in the order of the requests, from the output of whoever served each one
+static void write_answers(struct Server* server)
+{
+	for (int i = 0; i < server->count; ++i) {
+		const struct Request* request = &server->requests[i];
+		const struct Output* output = request->owner < server->worker_count
+			? &server->workers[request->owner].output : &server->errors;
+		fwrite(output->data + request->offset, 1, request->length, stdout);
+	}
+	fflush(stdout);
+}
+
+static bool server_init(struct Server* server, int threads, uint32_t games)
+{
+	memset(server, 0, sizeof(*server));
+	if (!session_table_init(&server->table, games)) return false;
+
+	server->requests = malloc(MAX_BATCH * sizeof(struct Request));
+	server->workers = calloc((size_t) threads, sizeof(struct Worker));
+	if (server->requests == NULL || server->workers == NULL) return false;
+
+	pthread_mutex_init(&server->mutex, NULL);
+	pthread_cond_init(&server->start, NULL);
+	pthread_cond_init(&server->done, NULL);
+
+	server->worker_count = 1;
+	server->workers[0].server = server;
+
+	// Threads that can't start leave fewer workers, each with more games
+	for (int i = 1; i < threads; ++i) {
+		struct Worker* worker = &server->workers[i];
+		worker->server = server;
+		worker->index = i;
+		if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) break;
+		++server->worker_count;
+	}
+
+	return true;
+}
+
+static void server_free(struct Server* server)
+{
+	pthread_mutex_lock(&server->mutex);
+	server->quit = true;
+	pthread_cond_broadcast(&server->start);
+	pthread_mutex_unlock(&server->mutex);
+
+	for (int i = 1; i < server->worker_count; ++i) pthread_join(server->workers[i].thread, NULL);
+	for (int i = 0; i < server->worker_count; ++i) free(server->workers[i].output.data);
+
+	pthread_mutex_destroy(&server->mutex);
+	pthread_cond_destroy(&server->start);
+	pthread_cond_destroy(&server->done);
+	free(server->errors.data);
+	free(server->workers);
+	free(server->requests);
+	session_table_free(&server->table);
+}
+
+int main(int argc, char* argv[])
+{
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	long games = 65536;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+			threads = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-games") == 0 && i + 1 < argc) {
+			games = atol(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [-threads n] [-games n]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	if (threads < 1) threads = 1;
+	if (games < 1 || games >= (long) SESSION_NONE) games = 65536;
+
+	static struct Server server;
+	if (!server_init(&server, (int) threads, (uint32_t) games)) {
+		fprintf(stderr, "Can't allocate %ld games\n", games);
+		return 1;
+	}
+
+	static char input[INPUT_SIZE];
+	size_t length = 0;
+	size_t parsed = 0;			// start of the first line not parsed yet
+	bool end = false;
+	int64_t arrival = 0;		// when the lines waiting in 'input' were read
+	int64_t first_arrival = 0;
+	int64_t last_answer = 0;
+
+	for (;;) {
+		// Read only when no whole line is left, so that the time of the read is the one of every line taken
+		if (!end && memchr(input + parsed, '\n', length - parsed) == NULL) {
+			memmove(input, input + parsed, length - parsed);
+			length -= parsed;
+			parsed = 0;
+
+			// A line that fills the input can't be a request
+			if (length == sizeof(input)) length = 0;
+
+			ssize_t count = read(STDIN_FILENO, input + length, sizeof(input) - length);
+			if (count < 0 && errno == EINTR) continue;
+			if (count <= 0) {
+				end = true;
+				if (length > 0 && length < sizeof(input)) input[length++] = '\n';
+			} else {
+				length += (size_t) count;
+			}
+			arrival = now_us();
+			if (first_arrival == 0) first_arrival = arrival;
+		}
+
+		server.count = 0;
+		server.errors.size = 0;
+
+		char* newline;
+		while (server.count < MAX_BATCH && (newline = memchr(input + parsed, '\n', length - parsed)) != NULL) {
+			*newline = '\0';
+			struct Request* request = &server.requests[server.count++];
+			parse_request(&server, input + parsed, request);
+			parsed = (size_t) (newline - input) + 1;
+
+			if (request->owner == server.worker_count) {
+				request->offset = server.errors.size;
+				output_printf(&server.errors, "error %s\n", request->argument);
+				request->length = server.errors.size - request->offset;
+			}
+		}
+
+		if (server.count == 0) {
+			if (end) break;
+			continue;
+		}
+
+		run_batch(&server);
+		write_answers(&server);
+
+		for (int i = 0; i < server.count; ++i) {
+			if (server.requests[i].reclaim) session_reclaim(&server.table, server.requests[i].id);
+		}
+
+		last_answer = now_us();
+		record_latency(&server, last_answer - arrival, (uint64_t) server.count);
+	}
+
+	double seconds = (double) (last_answer - first_arrival) / 1e6;
+	fprintf(stderr, "%" PRIu64 " requests in %.3f s, %.0f requests/s, %d threads\n", server.served, seconds,
+		seconds > 0 ? (double) server.served / seconds : 0.0, server.worker_count);
+	fprintf(stderr, "latency p50 %" PRIu64 " us, p99 %" PRIu64 " us, p99.9 %" PRIu64 " us\n",
+		latency_percentile(&server, 0.50), latency_percentile(&server, 0.99), latency_percentile(&server, 0.999));
+	fprintf(stderr, "%" PRIu32 " games open, %" PRIu32 " at most, %zu bytes each\n",
+		server.table.count, server.table.peak, sizeof(struct CompactGame));
+
+	server_free(&server);
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <string.h>
+#include "session.h"
+#include "movegen.h"
+
+bool session_table_init(struct SessionTable* table, uint32_t capacity)
+{
+	memset(table, 0, sizeof(*table));
+	if (capacity == 0 || capacity == SESSION_NONE) return false;
+
+	table->games = aligned_alloc(64, (size_t) capacity * sizeof(struct CompactGame));
+	if (table->games == NULL) return false;
+	STATS_ALLOCATION((size_t) capacity * sizeof(struct CompactGame));
+
+	// Every slot closed and chained in order, so the first ids come first
+	for (uint32_t id = 0; id < capacity; ++id) {
+		table->games[id].open = false;
+		table->games[id].next_free = id + 1 < capacity ? id + 1 : SESSION_NONE;
+	}
+	table->capacity = capacity;
+	table->free_head = 0;
+
+	struct Position pos;
+	position_from_fen(&pos, START_FEN);
+	compact_game_set(&table->start, &pos);
+
+	return true;
+}
+
+void session_table_free(struct SessionTable* table)
+{
+	free(table->games);
+	memset(table, 0, sizeof(*table));
+}
+
+uint32_t session_open(struct SessionTable* table)
+{
+	uint32_t id = table->free_head;
+	if (id == SESSION_NONE) return SESSION_NONE;
+
+	struct CompactGame* game = &table->games[id];
+
+	table->free_head = game->next_free;
+	*game = table->start;
+	game->open = true;
+
+	if (++table->count > table->peak) table->peak = table->count;
+
+	return id;
+}
+
+void compact_game_close(struct CompactGame* game)
+{
+	game->open = false;
+}
+
+void session_reclaim(struct SessionTable* table, uint32_t id)
+{
+	struct CompactGame* game = &table->games[id];
+
+	game->next_free = table->free_head;
+	table->free_head = id;
+	--table->count;
+}
+
+struct CompactGame* session_get(struct SessionTable* table, uint32_t id)
+{
+	if (id >= table->capacity || !table->games[id].open) return NULL;
+
+	return &table->games[id];
+}
+
+void compact_game_set(struct CompactGame* game, const struct Position* pos)
+{
+	memset(game->board, 0, sizeof(game->board));
+	for (int sq = 0; sq < 64; ++sq) {
+		game->board[sq / 2] |= (uint8_t) ((pos->squares[sq] + 1) << (sq % 2 * 4));
+	}
+
+	game->key = pos->key;
+	game->last_move = MOVE_NONE;
+	game->ply = 0;
+	game->fullmove = (uint16_t) pos->fullmove;
+	game->halfmove_clock = (uint16_t) pos->halfmove_clock;
+	game->side = (uint8_t) pos->side;
+	game->castling = (uint8_t) pos->castling;
+	game->ep_square = (int8_t) pos->ep_square;
+	game->status = (uint8_t) position_status(pos);
+}
+
+void compact_game_unpack(const struct CompactGame* game, struct Position* pos)
+{
+	position_clear(pos);
+
+	for (int sq = 0; sq < 64; ++sq) {
+		int piece = (game->board[sq / 2] >> (sq % 2 * 4) & 15) - 1;
+		if (piece != EMPTY) position_put(pos, piece, sq);
+	}
+
+	pos->side = game->side;
+	pos->castling = game->castling;
+	pos->ep_square = game->ep_square;
+	pos->halfmove_clock = game->halfmove_clock;
+	pos->fullmove = game->fullmove;
+	pos->key = game->key;
+}
+
+void compact_game_play(struct CompactGame* game, struct Position* pos, uint16_t m)
+{
+	struct Undo undo;
+	uint16_t ply = game->ply;
+
+	// Only the squares the move touched change, but packing all 32 bytes costs about as much as finding them
+	make_move(pos, m, &undo);
+	compact_game_set(game, pos);
+	game->last_move = m;
+	game->ply = (uint16_t) (ply + 1);
+}
@@ -0,0 +1,82 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "position.h"
+#include "move.h"
+
+/*
+ * A game reduced to what the next move needs, one cache line each, for
+ * servers that keep many games open at once. struct Game carries every
+ * move played and the undo records to take them back (about 19 KB); this
+ * keeps only the position, four bits per square, and is unpacked into a
+ * struct Position for each request.
+ *
+ * With no move history, repetitions aren't detected: the status is only
+ * ever playing, checkmate or stalemate.
+ */
+struct CompactGame {
+	_Alignas(64) uint8_t board[32];	// piece code + 1 on each square, 0 if empty, the even square in the low half
+	uint64_t key;			// Zobrist hash of the position
+	uint16_t last_move;		// MOVE_NONE before the first move
+	uint16_t ply;			// moves played since the game was opened
+	uint16_t fullmove;
+	uint16_t halfmove_clock;
+	uint8_t side;
+	uint8_t castling;
+	int8_t ep_square;
+	uint8_t status;			// STATUS_* of movegen.h
+	uint32_t next_free;		// next closed slot of the table, while this one is closed
+	bool open;
+};
+
+_Static_assert(sizeof(struct CompactGame) == 64, "a compact game is one cache line");
+
+// No slot, returned by session_open when the table is full
+#define SESSION_NONE UINT32_MAX
+
+/*
+ * Fixed array of compact games allocated once, a game's id being its
+ * index. Closed slots are chained through 'next_free' and reused, so
+ * opening and closing games never allocates. Each slot is aligned on a
+ * cache line: threads working on different games never share one.
+ *
+ * Opening games is for one thread at a time. Any number of threads can
+ * work on different open games meanwhile.
+ */
+struct SessionTable {
+	struct CompactGame* games;
+	uint32_t capacity;
+	uint32_t free_head;		// first closed slot, SESSION_NONE if every slot is open
+	uint32_t count;			// open games
+	uint32_t peak;			// most games open at once
+	struct CompactGame start;	// the standard start position, packed once
+};
+
+bool session_table_init(struct SessionTable* table, uint32_t capacity);
+void session_table_free(struct SessionTable* table);
+
+// Takes a closed slot and returns its id, the game is set to the standard start position
+uint32_t session_open(struct SessionTable* table);
+
+/*
+ * Closing takes two steps, so that the thread working on a game can close
+ * it while another one opens games: compact_game_close ends the game at
+ * once, session_reclaim gives its slot back later, from the thread that
+ * opens games, exactly once per closed game.
+ */
+void compact_game_close(struct CompactGame* game);
+void session_reclaim(struct SessionTable* table, uint32_t id);
+
+// The open game with this id, or NULL
+struct CompactGame* session_get(struct SessionTable* table, uint32_t id);
+
+// Packs 'pos' as the current position of 'game', working out its status
+void compact_game_set(struct CompactGame* game, const struct Position* pos);
+void compact_game_unpack(const struct CompactGame* game, struct Position* pos);
+
+// Plays 'm', a legal move of 'pos', the unpacked position of 'game', which then follows the move
+void compact_game_play(struct CompactGame* game, struct Position* pos, uint16_t m);
+
+#endif
@@ -0,0 +1,187 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "stats.h"
+
+const char* const stats_counter_names[STATS_COUNTER_COUNT] = {
+	"legal move generations",
+	"pawn move searches",
+	"knight move searches",
+	"bishop move searches",
+	"rook move searches",
+	"queen move searches",
+	"king move searches",
+	"attack queries",
+	"allocations",
+	"allocated bytes",
+};
+
+const char* const stats_timer_names[STATS_TIMER_COUNT] = {
+	"generate_legal_moves",
+	"search",
+	"render_board",
+	"frame",
+};
+
+#ifdef CHESS_STATS
+
+// Timers whose runs go into the trace, the others are too frequent and too short
+static const bool timer_traced[STATS_TIMER_COUNT] = {false, true, true, true};
+
+_Thread_local struct StatsThread* stats_current_thread;
+
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct StatsThread* _Atomic threads;
+static int thread_count;
+static uint64_t epoch_ns;	// trace times are from the first thread's registration
+
+uint64_t stats_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+struct StatsThread* stats_register_thread(void)
+{
+	struct StatsThread* thread = aligned_alloc(64, sizeof(*thread));
+
+	// Counting goes on without a block, into a shared one nobody reports
+	if (thread == NULL) {
+		static struct StatsThread lost;
+		stats_current_thread = &lost;
+		return &lost;
+	}
+
+	memset(thread, 0, sizeof(*thread));
+	thread->events = malloc(STATS_MAX_EVENTS * sizeof(*thread->events));
+
+	pthread_mutex_lock(&threads_mutex);
+	if (thread_count == 0) epoch_ns = stats_now_ns();
+	thread->thread_id = ++thread_count;
+	thread->next = atomic_load_explicit(&threads, memory_order_relaxed);
+	atomic_store_explicit(&threads, thread, memory_order_release);
+	pthread_mutex_unlock(&threads_mutex);
+
+	stats_current_thread = thread;
+	return thread;
+}
+
+void stats_timer_record(enum StatsTimer timer, uint64_t start_ns, uint64_t end_ns)
+{
+	struct StatsThread* thread = stats_thread();
+	uint64_t duration = end_ns - start_ns;
+
+	atomic_store_explicit(&thread->timer_counts[timer],
+		atomic_load_explicit(&thread->timer_counts[timer], memory_order_relaxed) + 1, memory_order_relaxed);
+	atomic_store_explicit(&thread->timer_total_ns[timer],
+		atomic_load_explicit(&thread->timer_total_ns[timer], memory_order_relaxed) + duration, memory_order_relaxed);
+	if (duration > atomic_load_explicit(&thread->timer_max_ns[timer], memory_order_relaxed)) {
+		atomic_store_explicit(&thread->timer_max_ns[timer], duration, memory_order_relaxed);
+	}
+
+	if (!timer_traced[timer]) return;
+
+	uint32_t count = atomic_load_explicit(&thread->event_count, memory_order_relaxed);
+	if (thread->events == NULL || count == STATS_MAX_EVENTS) {
+		atomic_store_explicit(&thread->dropped_events,
+			atomic_load_explicit(&thread->dropped_events, memory_order_relaxed) + 1, memory_order_relaxed);
+		return;
+	}
+
+	thread->events[count] = (struct StatsEvent) {start_ns, duration > UINT32_MAX ? UINT32_MAX : (uint32_t) duration, timer};
+	atomic_store_explicit(&thread->event_count, count + 1, memory_order_release);
+}
+
+bool stats_enabled(void)
+{
+	return true;
+}
+
+void stats_totals(struct StatsTotals* totals)
+{
+	memset(totals, 0, sizeof(*totals));
+
+	for (struct StatsThread* thread = atomic_load_explicit(&threads, memory_order_acquire); thread != NULL; thread = thread->next) {
+		for (int i = 0; i < STATS_COUNTER_COUNT; ++i) {
+			totals->counters[i] += atomic_load_explicit(&thread->counters[i], memory_order_relaxed);
+		}
+
+		for (int i = 0; i < STATS_TIMER_COUNT; ++i) {
+			struct StatsTimerTotals* timer = &totals->timers[i];
+			uint64_t max_ns = atomic_load_explicit(&thread->timer_max_ns[i], memory_order_relaxed);
+			timer->count += atomic_load_explicit(&thread->timer_counts[i], memory_order_relaxed);
+			timer->total_ns += atomic_load_explicit(&thread->timer_total_ns[i], memory_order_relaxed);
+			if (max_ns > timer->max_ns) timer->max_ns = max_ns;
+		}
+
+		totals->dropped_events += atomic_load_explicit(&thread->dropped_events, memory_order_relaxed);
+		++totals->threads;
+	}
+}
+
+bool stats_write_trace(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL) return false;
+
+	struct StatsTotals totals;
+	stats_totals(&totals);
+
+	// Complete events ("X"), in microseconds from the epoch, one track per thread
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (struct StatsThread* thread = atomic_load_explicit(&threads, memory_order_acquire); thread != NULL; thread = thread->next) {
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+			first ? "" : ",\n", thread->thread_id, thread->thread_id);
+		first = false;
+
+		uint32_t count = atomic_load_explicit(&thread->event_count, memory_order_acquire);
+		for (uint32_t i = 0; i < count; ++i) {
+			const struct StatsEvent* event = &thread->events[i];
+			fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				stats_timer_names[event->timer], thread->thread_id,
+				(double) (event->start_ns - epoch_ns) / 1000, (double) event->duration_ns / 1000);
+		}
+	}
+
+	// The totals go along, for the untraced timers and the counters
+	fprintf(file, "\n],\n\"displayTimeUnit\":\"ms\",\n\"otherData\":{\"threads\":%d,\"dropped events\":%llu",
+		totals.threads, (unsigned long long) totals.dropped_events);
+	for (int i = 0; i < STATS_COUNTER_COUNT; ++i) {
+		fprintf(file, ",\"%s\":%llu", stats_counter_names[i], (unsigned long long) totals.counters[i]);
+	}
+	for (int i = 0; i < STATS_TIMER_COUNT; ++i) {
+		const struct StatsTimerTotals* timer = &totals.timers[i];
+		fprintf(file, ",\"%s\":\"%llu runs, %.3f ms total, %.3f us max\"", stats_timer_names[i],
+			(unsigned long long) timer->count, timer->total_ns / 1e6, timer->max_ns / 1e3);
+	}
+	fprintf(file, "}}\n");
+
+	return fclose(file) == 0;
+}
+
+#else
+
+bool stats_enabled(void)
+{
+	return false;
+}
+
+void stats_totals(struct StatsTotals* totals)
+{
+	memset(totals, 0, sizeof(*totals));
+}
+
+bool stats_write_trace(const char* path)
+{
+	(void) path;
+	return false;
+}
+
+#endif
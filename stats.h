@@ -0,0 +1,154 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Counters and timers on the hot paths, to see where the time goes
+ * without an external profiler. They are compiled in with -DCHESS_STATS
+ * (add stats.c to the build) and to nothing otherwise.
+ *
+ * Every thread counts into its own block, found through a thread-local
+ * pointer, so counting is an add to a line no other thread writes. The
+ * blocks are chained once per thread and never freed: stats_totals adds
+ * them up from any thread, including those that have ended.
+ *
+ * Timers keep their count, total and longest time. The traced ones also
+ * log each run, with its start, for a Chrome trace (chrome://tracing or
+ * https://ui.perfetto.dev) written by stats_write_trace.
+ */
+
+enum StatsCounter {
+	STATS_LEGAL_MOVE_GENERATIONS,
+	STATS_PAWN_MOVE_SEARCHES,		// calls of find_pawn_moves, one per pawn
+	STATS_KNIGHT_MOVE_SEARCHES,
+	STATS_BISHOP_MOVE_SEARCHES,
+	STATS_ROOK_MOVE_SEARCHES,
+	STATS_QUEEN_MOVE_SEARCHES,
+	STATS_KING_MOVE_SEARCHES,
+	STATS_ATTACK_QUERIES,			// calls of attackers_of
+	STATS_ALLOCATIONS,
+	STATS_ALLOCATED_BYTES,
+	STATS_COUNTER_COUNT
+};
+
+enum StatsTimer {
+	STATS_TIMER_LEGAL_MOVES,		// generate_legal_moves
+	STATS_TIMER_SEARCH,				// search_run, traced
+	STATS_TIMER_RENDER_BOARD,		// drawing the board into its texture, traced
+	STATS_TIMER_FRAME,				// a whole frame of the window, traced
+	STATS_TIMER_COUNT
+};
+
+extern const char* const stats_counter_names[STATS_COUNTER_COUNT];
+extern const char* const stats_timer_names[STATS_TIMER_COUNT];
+
+struct StatsTimerTotals {
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+};
+
+struct StatsTotals {
+	uint64_t counters[STATS_COUNTER_COUNT];
+	struct StatsTimerTotals timers[STATS_TIMER_COUNT];
+	int threads;
+	uint64_t dropped_events;		// traced runs left out of the trace for lack of room
+};
+
+#ifdef CHESS_STATS
+
+// Traced runs kept per thread, the rest are only counted
+#define STATS_MAX_EVENTS 65536
+
+struct StatsEvent {
+	uint64_t start_ns;
+	uint32_t duration_ns;
+	uint32_t timer;
+};
+
+/*
+ * One thread's numbers. Only the owner writes them, with relaxed atomic
+ * loads and stores rather than read-modify-writes, so that other threads
+ * can read them while it runs at the cost of a plain add.
+ */
+struct StatsThread {
+	_Alignas(64) _Atomic uint64_t counters[STATS_COUNTER_COUNT];
+	_Atomic uint64_t timer_counts[STATS_TIMER_COUNT];
+	_Atomic uint64_t timer_total_ns[STATS_TIMER_COUNT];
+	_Atomic uint64_t timer_max_ns[STATS_TIMER_COUNT];
+	_Atomic uint32_t event_count;
+	_Atomic uint64_t dropped_events;
+	struct StatsEvent* events;		// STATS_MAX_EVENTS, NULL if they couldn't be allocated
+	int thread_id;
+	struct StatsThread* next;
+};
+
+// A timer running until the end of the enclosing scope
+struct StatsScope {
+	enum StatsTimer timer;
+	uint64_t start_ns;
+};
+
+extern _Thread_local struct StatsThread* stats_current_thread;
+
+// The calling thread's block, chained on its first use
+struct StatsThread* stats_register_thread(void);
+uint64_t stats_now_ns(void);
+void stats_timer_record(enum StatsTimer timer, uint64_t start_ns, uint64_t end_ns);
+
+static inline struct StatsThread* stats_thread(void)
+{
+	struct StatsThread* thread = stats_current_thread;
+	return thread != NULL ? thread : stats_register_thread();
+}
+
+static inline void stats_add(enum StatsCounter counter, uint64_t n)
+{
+	_Atomic uint64_t* value = &stats_thread()->counters[counter];
+	atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+static inline struct StatsScope stats_scope_begin(enum StatsTimer timer)
+{
+	return (struct StatsScope) {timer, stats_now_ns()};
+}
+
+static inline void stats_scope_end(const struct StatsScope* scope)
+{
+	stats_timer_record(scope->timer, scope->start_ns, stats_now_ns());
+}
+
+#define STATS_CONCAT_(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_(a, b)
+
+#define STATS_COUNT(counter) stats_add((counter), 1)
+#define STATS_ADD(counter, n) stats_add((counter), (uint64_t) (n))
+#define STATS_ALLOCATION(bytes) (stats_add(STATS_ALLOCATIONS, 1), stats_add(STATS_ALLOCATED_BYTES, (uint64_t) (bytes)))
+
+// Times the rest of the enclosing block, every way out of it included
+#define STATS_SCOPE(timer) \
+	struct StatsScope STATS_CONCAT(stats_scope_, __LINE__) __attribute__((cleanup(stats_scope_end))) = stats_scope_begin(timer)
+
+#else
+
+#define STATS_COUNT(counter) ((void) 0)
+#define STATS_ADD(counter, n) ((void) 0)
+#define STATS_ALLOCATION(bytes) ((void) 0)
+#define STATS_SCOPE(timer) ((void) 0)
+
+#endif
+
+// Whether this build counts anything
+bool stats_enabled(void);
+
+// Sums of every thread so far, all zero without CHESS_STATS
+void stats_totals(struct StatsTotals* totals);
+
+// Writes the traced runs and the totals as Chrome trace JSON, false if the file can't be written or there are no stats
+bool stats_write_trace(const char* path);
+
+#endif
@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <string.h>
+#include "tt.h"
+#include "stats.h"
+
+// Layout of 'data': move in bits 0-15, score 16-31, depth 32-39, bound 40-41, age 42-47
+static uint64_t pack(uint16_t move, int score, int depth, int bound, uint8_t age)
+{
+	return (uint64_t) move
+		| (uint64_t) (uint16_t) (int16_t) score << 16
+		| (uint64_t) (uint8_t) (int8_t) depth << 32
+		| (uint64_t) bound << 40
+		| (uint64_t) (age & 63) << 42;
+}
+
+static int data_depth(uint64_t data)
+{
+	return (int8_t) (data >> 32);
+}
+
+static int data_age(uint64_t data)
+{
+	return (int) (data >> 42) & 63;
+}
+
+static int data_bound(uint64_t data)
+{
+	return (int) (data >> 40) & 3;
+}
+
+bool tt_init(struct TranspositionTable* tt, size_t size_mb)
+{
+	size_t count = 1;
+	while (count * 2 * sizeof(struct TTBucket) <= size_mb * 1024 * 1024) count *= 2;
+
+	tt->buckets = aligned_alloc(sizeof(struct TTBucket), count * sizeof(struct TTBucket));
+	if (tt->buckets == NULL) return false;
+	STATS_ALLOCATION(count * sizeof(struct TTBucket));
+
+	tt->mask = count - 1;
+	tt->age = 0;
+	tt_clear(tt);
+
+	return true;
+}
+
+void tt_free(struct TranspositionTable* tt)
+{
+	free(tt->buckets);
+	tt->buckets = NULL;
+}
+
+// Not safe while a search is running
+void tt_clear(struct TranspositionTable* tt)
+{
+	memset(tt->buckets, 0, (tt->mask + 1) * sizeof(struct TTBucket));
+}
+
+void tt_new_search(struct TranspositionTable* tt)
+{
+	tt->age = (tt->age + 1) & 63;
+}
+
+bool tt_probe(const struct TranspositionTable* tt, uint64_t key, struct TTHit* hit, struct TTStats* stats)
+{
+	const struct TTBucket* bucket = &tt->buckets[key & tt->mask];
+
+	if (stats) ++stats->probes;
+
+	for (int i = 0; i < TT_BUCKET_SIZE; ++i) {
+		const struct TTEntry* entry = &bucket->entries[i];
+		uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+		uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+
+		if ((check ^ data) != key || data_bound(data) == BOUND_NONE) continue;
+
+		hit->move = (uint16_t) data;
+		hit->score = (int16_t) (data >> 16);
+		hit->depth = data_depth(data);
+		hit->bound = data_bound(data);
+		if (stats) ++stats->hits;
+
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Stores in the entry already holding 'key' if there is one, otherwise over
+ * the least useful entry: the shallowest, with entries from older searches
+ * counting as shallower the older they are.
+ */
+void tt_store(struct TranspositionTable* tt, uint64_t key, int depth, int bound, int score, uint16_t move, struct TTStats* stats)
+{
+	struct TTBucket* bucket = &tt->buckets[key & tt->mask];
+	struct TTEntry* replace = NULL;
+	int replace_value = 0;
+	uint64_t replace_data = 0;
+
+	for (int i = 0; i < TT_BUCKET_SIZE; ++i) {
+		struct TTEntry* entry = &bucket->entries[i];
+		uint64_t data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+		uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+
+		if ((check ^ data) == key) {
+			// Same position: keep the old best move if the new search found none,
+			// and don't let a shallow bound overwrite a deeper result of this search
+			if (move == 0) move = (uint16_t) data;
+			if (bound != BOUND_EXACT && data_age(data) == tt->age && depth + 2 < data_depth(data)) return;
+
+			replace = entry;
+			replace_data = 0;
+			break;
+		}
+
+		int age_distance = (tt->age - data_age(data)) & 63;
+		int value = data_bound(data) == BOUND_NONE ? -1000 : data_depth(data) - 8 * age_distance;
+		if (replace == NULL || value < replace_value) {
+			replace = entry;
+			replace_value = value;
+			replace_data = data;
+		}
+	}
+
+	if (stats) {
+		++stats->stores;
+		if (data_bound(replace_data) != BOUND_NONE) ++stats->collisions;
+	}
+
+	uint64_t data = pack(move, score, depth, bound, tt->age);
+	atomic_store_explicit(&replace->data, data, memory_order_relaxed);
+	atomic_store_explicit(&replace->check, key ^ data, memory_order_relaxed);
+}
+
+int tt_hashfull(const struct TranspositionTable* tt)
+{
+	int used = 0;
+	int buckets = tt->mask + 1 < 250 ? (int) tt->mask + 1 : 250;
+
+	for (int i = 0; i < buckets; ++i) {
+		for (int j = 0; j < TT_BUCKET_SIZE; ++j) {
+			uint64_t data = atomic_load_explicit(&tt->buckets[i].entries[j].data, memory_order_relaxed);
+			if (data_bound(data) != BOUND_NONE && data_age(data) == tt->age) ++used;
+		}
+	}
+
+	return used * 1000 / (buckets * TT_BUCKET_SIZE);
+}
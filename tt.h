@@ -0,0 +1,67 @@
+#ifndef TT_H
+#define TT_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// How the stored score relates to the real one
+#define BOUND_NONE 0
+#define BOUND_UPPER 1	// the real score is at most the stored one
+#define BOUND_LOWER 2	// the real score is at least the stored one
+#define BOUND_EXACT 3
+
+#define TT_BUCKET_SIZE 4
+
+/*
+ * One entry is two 64-bit words: 'data' packs the move, score, depth, bound
+ * and age, and 'check' holds the position key XOR 'data'. Threads read and
+ * write them without locks; an entry torn by two writers racing no longer
+ * XORs back to its key and is simply seen as a miss.
+ */
+struct TTEntry {
+	_Atomic uint64_t check;
+	_Atomic uint64_t data;
+};
+
+// Entries sharing an index, one cache line
+struct TTBucket {
+	_Alignas(64) struct TTEntry entries[TT_BUCKET_SIZE];
+};
+
+struct TranspositionTable {
+	struct TTBucket* buckets;
+	uint64_t mask;			// number of buckets - 1, the count is a power of two
+	uint8_t age;			// goes up with every search, older entries are replaced first
+};
+
+// What a probe found
+struct TTHit {
+	uint16_t move;
+	int score;
+	int depth;
+	int bound;
+};
+
+// Kept by each thread and added up when reporting, so counting costs no shared writes
+struct TTStats {
+	uint64_t probes;
+	uint64_t hits;
+	uint64_t stores;
+	uint64_t collisions;	// stores that evicted another position's entry
+};
+
+// Allocates about 'size_mb' megabytes rounded down to a power of two, returns false if out of memory
+bool tt_init(struct TranspositionTable* tt, size_t size_mb);
+void tt_free(struct TranspositionTable* tt);
+void tt_clear(struct TranspositionTable* tt);
+void tt_new_search(struct TranspositionTable* tt);
+
+bool tt_probe(const struct TranspositionTable* tt, uint64_t key, struct TTHit* hit, struct TTStats* stats);
+void tt_store(struct TranspositionTable* tt, uint64_t key, int depth, int bound, int score, uint16_t move, struct TTStats* stats);
+
+// Used entries of the current search per thousand, sampled from the first buckets
+int tt_hashfull(const struct TranspositionTable* tt);
+
+#endif
@@ -0,0 +1,575 @@
+// gcc -O2 -o gen_magic gen_magic.c && ./gen_magic > magic_tables.h
+// gcc -O2 -pthread -o uci uci.c position.c movegen.c game.c zobrist.c tt.c search.c magic.c eval.c nnue.c book.c bitbase.c stats.c
+// ./uci                                        speaks UCI on stdin and stdout, for any chess GUI
+
+/*
+ * The engine without a window, driven by a GUI through the UCI protocol.
+ * Positions are set up with the rules of 'struct Game', so a move the GUI
+ * sends is only played if it is one of the legal moves. With a BookFile,
+ * one made by mkbook.c (or any Polyglot book when polyglot_random.h was
+ * generated, see gen_polyglot.c), positions in the book are
+ * answered at once with one of its moves instead of a search. With a BitbaseDir (see gen_bitbase.c),
+ * the search knows the result of the small endings it reaches.
+ *
+ * Two threads: the input thread reads stdin and the main thread runs the
+ * commands one after the other, searches included. While a search runs the
+ * input thread answers 'isready' and handles 'stop', 'ponderhit' and 'quit'
+ * itself, everything else waits in a queue for the search to end. It also
+ * keeps the clock of a ponder search once the GUI says the move was played:
+ * it waits for input no longer than the time left and stops the search
+ * when it runs out.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "chess.h"
+
+#define ENGINE_NAME "Chess"
+
+#define DEFAULT_HASH_MB 16
+#define MAX_HASH_MB 65536
+#define MAX_THREADS 256
+
+// Commands waiting for the main thread, and the longest line read (a long game in a 'position' command)
+#define QUEUE_SIZE 64
+#define MAX_LINE 16384
+
+// Time kept for the GUI and the pipe on each move, and moves to plan for when the GUI doesn't say
+#define MOVE_OVERHEAD_MS 30
+#define DEFAULT_MOVES_TO_GO 30
+
+struct Uci {
+	struct Game game;
+	struct TranspositionTable tt;
+	struct SearchPool pool;
+	struct NnueNetwork* network;	// NULL to evaluate with the piece-square tables
+	struct Book book;				// no entries without a BookFile
+	uint64_t random_state;			// for picking book moves
+	struct Bitbases bitbases;
+	int bitbase_count;				// sets mapped from the BitbaseDir, the search doesn't probe without any
+
+	// Shared by both threads
+	pthread_mutex_t mutex;
+	pthread_cond_t changed;			// signalled on every change below
+	char* queue[QUEUE_SIZE];		// commands for the main thread, in order
+	int queue_head;
+	int queue_count;
+	bool searching;					// from the 'go' command until its 'bestmove'
+	bool waiting;					// infinite or ponder search: no 'bestmove' before 'stop' or 'ponderhit'
+	bool pondering;					// the GUI has not said yet whether the move was played
+	bool ponder_hit;				// 'ponderhit' came, maybe before the search started
+	bool stop_requested;			// 'stop' came, maybe before the search started
+	int64_t ponder_budget_ms;		// time for the move once 'ponderhit' comes, 0 for no limit
+	int64_t deadline_ms;			// when the input thread stops the search, 0 if never
+};
+
+static int64_t now_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Writes one line to the GUI, whole even when both threads write at once
+static void uci_send(const char* format, ...)
+{
+	va_list args;
+
+	flockfile(stdout);
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+	putchar('\n');
+	fflush(stdout);
+	funlockfile(stdout);
+}
+
+// Stops the running search for good: a ponder or infinite search then answers at once
+static void request_stop(struct Uci* uci)
+{
+	uci->stop_requested = true;
+	uci->waiting = false;
+	uci->deadline_ms = 0;
+	search_pool_stop(&uci->pool);
+	pthread_cond_broadcast(&uci->changed);
+}
+
+static void push_command(struct Uci* uci, const char* line)
+{
+	char* copy = strdup(line);
+	if (copy == NULL) return;
+
+	while (uci->queue_count == QUEUE_SIZE) pthread_cond_wait(&uci->changed, &uci->mutex);
+	uci->queue[(uci->queue_head + uci->queue_count) % QUEUE_SIZE] = copy;
+	++uci->queue_count;
+	pthread_cond_broadcast(&uci->changed);
+}
+
+// Handles what can't wait for the search and queues the rest, returns false on 'quit'
+static bool handle_input(struct Uci* uci, const char* line)
+{
+	char command[16] = "";
+	sscanf(line, "%15s", command);
+	if (command[0] == '\0') return true;
+
+	bool keep_going = true;
+
+	pthread_mutex_lock(&uci->mutex);
+	if (strcmp(command, "stop") == 0) {
+		if (uci->searching) request_stop(uci);
+	} else if (strcmp(command, "ponderhit") == 0) {
+		if (uci->searching) uci->ponder_hit = true;
+		if (uci->searching && uci->pondering) {
+			uci->pondering = false;
+			uci->waiting = false;
+			if (uci->ponder_budget_ms) uci->deadline_ms = now_ms() + uci->ponder_budget_ms;
+			pthread_cond_broadcast(&uci->changed);
+		}
+	} else if (strcmp(command, "isready") == 0 && uci->searching) {
+		uci_send("readyok");
+	} else {
+		// 'quit' ends the search at once but comes after the commands before it
+		if (strcmp(command, "quit") == 0) {
+			request_stop(uci);
+			keep_going = false;
+		}
+		if (strcmp(command, "go") == 0) {
+			uci->searching = true;
+			uci->stop_requested = false;
+			uci->ponder_hit = false;
+		}
+		push_command(uci, line);
+	}
+	pthread_mutex_unlock(&uci->mutex);
+
+	return keep_going;
+}
+
+/*
+ * Reads stdin with read() rather than stdio, so that poll() knows when a
+ * line is pending, and waits no longer than the deadline of the search.
+ */
+static void* input_main(void* data)
+{
+	struct Uci* uci = data;
+	static char buffer[MAX_LINE];
+	size_t length = 0;
+	bool keep_going = true;
+
+	while (keep_going) {
+		pthread_mutex_lock(&uci->mutex);
+		int64_t deadline = uci->deadline_ms;
+		pthread_mutex_unlock(&uci->mutex);
+
+		int timeout = -1;
+		if (deadline) {
+			int64_t left = deadline - now_ms();
+			timeout = left > 0 ? (int) left : 0;
+		}
+
+		struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+		int ready = poll(&input, 1, timeout);
+		if (ready < 0 && errno != EINTR) break;
+
+		if (ready == 0) {
+			pthread_mutex_lock(&uci->mutex);
+			if (uci->deadline_ms && now_ms() >= uci->deadline_ms) {
+				uci->deadline_ms = 0;
+				search_pool_stop(&uci->pool);
+			}
+			pthread_mutex_unlock(&uci->mutex);
+			continue;
+		}
+		if (ready < 0) continue;
+
+		ssize_t count = read(STDIN_FILENO, buffer + length, sizeof(buffer) - 1 - length);
+		if (count < 0 && errno == EINTR) continue;
+		if (count <= 0) break;
+		length += (size_t) count;
+
+		// Every complete line, what is left of the last one stays for the next read
+		char* start = buffer;
+		char* newline;
+		while (keep_going && (newline = memchr(start, '\n', length - (size_t) (start - buffer))) != NULL) {
+			*newline = '\0';
+			if (newline > start && newline[-1] == '\r') newline[-1] = '\0';
+			keep_going = handle_input(uci, start);
+			start = newline + 1;
+		}
+
+		length -= (size_t) (start - buffer);
+		memmove(buffer, start, length);
+
+		// A line longer than the buffer can't be a command
+		if (length == sizeof(buffer) - 1) length = 0;
+	}
+
+	// The end of the input ends the engine, like 'quit'
+	if (keep_going) handle_input(uci, "quit");
+
+	return NULL;
+}
+
+static char* pop_command(struct Uci* uci)
+{
+	pthread_mutex_lock(&uci->mutex);
+	while (uci->queue_count == 0) pthread_cond_wait(&uci->changed, &uci->mutex);
+
+	char* line = uci->queue[uci->queue_head];
+	uci->queue_head = (uci->queue_head + 1) % QUEUE_SIZE;
+	--uci->queue_count;
+	pthread_cond_broadcast(&uci->changed);
+	pthread_mutex_unlock(&uci->mutex);
+
+	return line;
+}
+
+// position [startpos | fen <fen>] [moves <move>...]
+static void handle_position(struct Uci* uci, char* args)
+{
+	char* save;
+	char* token = strtok_r(args, " \t", &save);
+	char fen[128] = "";
+
+	if (token != NULL && strcmp(token, "fen") == 0) {
+		while ((token = strtok_r(NULL, " \t", &save)) != NULL && strcmp(token, "moves") != 0) {
+			if (strlen(fen) + strlen(token) + 2 > sizeof(fen)) break;
+			if (fen[0] != '\0') strcat(fen, " ");
+			strcat(fen, token);
+		}
+	} else {
+		if (token != NULL && strcmp(token, "startpos") == 0) token = strtok_r(NULL, " \t", &save);
+		strcpy(fen, START_FEN);
+	}
+
+	if (!game_init_fen(&uci->game, fen)) {
+		uci_send("info string invalid fen %s", fen);
+		game_init_fen(&uci->game, START_FEN);
+		return;
+	}
+
+	if (token == NULL || strcmp(token, "moves") != 0) return;
+
+	while ((token = strtok_r(NULL, " \t", &save)) != NULL) {
+		uint16_t m = move_from_string(&uci->game.pos, token);
+		if (m == MOVE_NONE || !game_play(&uci->game, m)) {
+			uci_send("info string illegal move %s", token);
+			return;
+		}
+	}
+}
+
+static void send_iteration(const struct SearchResult* result, void* data)
+{
+	struct Uci* uci = data;
+	char line[256 + MAX_PLY * 6];
+	char name[6];
+
+	// A 'stop' that came before the search cleared its flags
+	pthread_mutex_lock(&uci->mutex);
+	if (uci->stop_requested) search_pool_stop(&uci->pool);
+	pthread_mutex_unlock(&uci->mutex);
+
+	int length = snprintf(line, sizeof(line), "info depth %d seldepth %d score ", result->depth, result->seldepth);
+	if (result->score >= SCORE_MATE_BOUND) {
+		length += snprintf(line + length, sizeof(line) - length, "mate %d", (SCORE_MATE - result->score + 1) / 2);
+	} else if (result->score <= -SCORE_MATE_BOUND) {
+		length += snprintf(line + length, sizeof(line) - length, "mate %d", -(SCORE_MATE + result->score) / 2);
+	} else {
+		length += snprintf(line + length, sizeof(line) - length, "cp %d", result->score);
+	}
+	length += snprintf(line + length, sizeof(line) - length,
+		" nodes %" PRIu64 " nps %" PRIu64 " hashfull %d time %" PRId64 " pv",
+		result->nodes, result->nps, tt_hashfull(&uci->tt), result->time_ms);
+
+	for (int i = 0; i < result->pv_length; ++i) {
+		move_to_string(result->pv[i], name);
+		length += snprintf(line + length, sizeof(line) - length, " %s", name);
+	}
+
+	uci_send("%s", line);
+}
+
+// Share of the clock for this move: an even part of what is left plus most of the increment
+static int64_t move_budget(int64_t time_left, int64_t increment, int moves_to_go)
+{
+	if (moves_to_go <= 0) moves_to_go = DEFAULT_MOVES_TO_GO;
+
+	int64_t budget = time_left / moves_to_go + increment * 3 / 4;
+	if (budget > time_left - MOVE_OVERHEAD_MS) budget = time_left - MOVE_OVERHEAD_MS;
+
+	return budget > 1 ? budget : 1;
+}
+
+// go [wtime ms] [btime ms] [winc ms] [binc ms] [movestogo n] [depth n] [nodes n] [movetime ms] [infinite] [ponder]
+static void handle_go(struct Uci* uci, char* args)
+{
+	struct SearchLimits limits = {0};
+	int64_t time_left[2] = {0, 0};
+	int64_t increment[2] = {0, 0};
+	int64_t move_time = 0;
+	int moves_to_go = 0;
+	bool infinite = false;
+	bool ponder = false;
+	char* save;
+	char* token = strtok_r(args, " \t", &save);
+
+	for (; token != NULL; token = strtok_r(NULL, " \t", &save)) {
+		char* value = NULL;
+		if (strcmp(token, "infinite") == 0) {
+			infinite = true;
+		} else if (strcmp(token, "ponder") == 0) {
+			ponder = true;
+		} else if ((value = strtok_r(NULL, " \t", &save)) == NULL) {
+			break;
+		} else if (strcmp(token, "wtime") == 0) {
+			time_left[PLAYER_WHITE] = atoll(value);
+		} else if (strcmp(token, "btime") == 0) {
+			time_left[PLAYER_BLACK] = atoll(value);
+		} else if (strcmp(token, "winc") == 0) {
+			increment[PLAYER_WHITE] = atoll(value);
+		} else if (strcmp(token, "binc") == 0) {
+			increment[PLAYER_BLACK] = atoll(value);
+		} else if (strcmp(token, "movestogo") == 0) {
+			moves_to_go = atoi(value);
+		} else if (strcmp(token, "depth") == 0) {
+			limits.depth = atoi(value);
+		} else if (strcmp(token, "nodes") == 0) {
+			limits.nodes = strtoull(value, NULL, 10);
+		} else if (strcmp(token, "movetime") == 0) {
+			move_time = atoll(value);
+		}
+	}
+
+	int side = uci->game.pos.side;
+	int64_t budget = 0;
+	if (move_time > 0) {
+		budget = move_time;
+	} else if (time_left[side] > 0) {
+		budget = move_budget(time_left[side], increment[side], moves_to_go);
+	}
+
+	// A ponder search has no clock until 'ponderhit', the input thread keeps it from then on
+	pthread_mutex_lock(&uci->mutex);
+	if (uci->ponder_hit) ponder = false;
+	uci->waiting = (infinite || ponder) && !uci->stop_requested;
+	uci->pondering = ponder;
+	uci->ponder_budget_ms = ponder && !infinite ? budget : 0;
+	pthread_mutex_unlock(&uci->mutex);
+
+	if (!infinite && !ponder) limits.time_ms = budget;
+
+	struct SearchResult result = {0};
+	uint16_t best = MOVE_NONE;
+
+	// A book move costs no time, a ponder or infinite search is analysis and skips the book
+	if (uci->book.count > 0 && !infinite && !ponder) {
+		best = book_pick(&uci->book, &uci->game.pos, &uci->random_state);
+		if (best != MOVE_NONE) uci_send("info string book move");
+	}
+
+	if (best == MOVE_NONE) {
+		search_pool_set_game(&uci->pool, &uci->game);
+		best = search_pool_run(&uci->pool, &limits, &result);
+	}
+
+	pthread_mutex_lock(&uci->mutex);
+	while (uci->waiting) pthread_cond_wait(&uci->changed, &uci->mutex);
+	uci->searching = false;
+	uci->pondering = false;
+	uci->deadline_ms = 0;
+	pthread_mutex_unlock(&uci->mutex);
+
+	char name[6];
+	char ponder_name[6];
+	move_to_string(best, name);
+	if (best == MOVE_NONE) strcpy(name, "0000");
+
+	if (best != MOVE_NONE && result.pv_length > 1 && result.pv[0] == best) {
+		move_to_string(result.pv[1], ponder_name);
+		uci_send("bestmove %s ponder %s", name, ponder_name);
+	} else {
+		uci_send("bestmove %s", name);
+	}
+}
+
+static bool start_pool(struct Uci* uci, int threads)
+{
+	if (!search_pool_init(&uci->pool, threads, &uci->tt)) return false;
+
+	uci->pool.searches[0].on_iteration = send_iteration;
+	uci->pool.searches[0].callback_data = uci;
+	search_pool_set_network(&uci->pool, uci->network);
+	search_pool_set_bitbases(&uci->pool, uci->bitbase_count > 0 ? &uci->bitbases : NULL);
+
+	return true;
+}
+
+// A new pool of 'threads', or of one if they can't be started
+static bool set_threads(struct Uci* uci, int threads)
+{
+	search_pool_free(&uci->pool);
+	if (start_pool(uci, threads)) return true;
+
+	start_pool(uci, 1);
+	return false;
+}
+
+// setoption name <name> [value <value>]
+static void handle_setoption(struct Uci* uci, char* args)
+{
+	char* name = strstr(args, "name ");
+	if (name == NULL) return;
+	name += strlen("name ");
+
+	char* value = strstr(name, " value ");
+	if (value != NULL) {
+		*value = '\0';
+		value += strlen(" value ");
+	}
+
+	if (strcasecmp(name, "Hash") == 0 && value != NULL) {
+		int mb = atoi(value);
+		if (mb < 1) mb = 1;
+		if (mb > MAX_HASH_MB) mb = MAX_HASH_MB;
+
+		// The pool keeps pointing at uci->tt, only its entries move
+		tt_free(&uci->tt);
+		if (!tt_init(&uci->tt, (size_t) mb)) {
+			uci_send("info string can't allocate %d MB, using %d MB", mb, DEFAULT_HASH_MB);
+			tt_init(&uci->tt, DEFAULT_HASH_MB);
+		}
+	} else if (strcasecmp(name, "Threads") == 0 && value != NULL) {
+		int threads = atoi(value);
+		if (threads < 1) threads = 1;
+		if (threads > MAX_THREADS) threads = MAX_THREADS;
+		if (!set_threads(uci, threads)) uci_send("info string can't start %d threads, using 1", threads);
+	} else if (strcasecmp(name, "EvalFile") == 0) {
+		free(uci->network);
+		uci->network = NULL;
+
+		if (value != NULL && value[0] != '\0' && strcmp(value, "<empty>") != 0) {
+			uci->network = malloc(sizeof(*uci->network));
+			if (uci->network == NULL || !nnue_load(uci->network, value)) {
+				uci_send("info string can't load the network %s, using the piece-square tables", value);
+				free(uci->network);
+				uci->network = NULL;
+			}
+		}
+		search_pool_set_network(&uci->pool, uci->network);
+	} else if (strcasecmp(name, "BookFile") == 0) {
+		if (uci->book.data != NULL) book_close(&uci->book);
+
+		if (value != NULL && value[0] != '\0' && strcmp(value, "<empty>") != 0 && !book_open(&uci->book, value)) {
+			uci_send("info string can't read the book %s", value);
+		}
+	} else if (strcasecmp(name, "BitbaseDir") == 0) {
+		search_pool_set_bitbases(&uci->pool, NULL);
+		bitbases_close(&uci->bitbases);
+		uci->bitbase_count = 0;
+
+		if (value != NULL && value[0] != '\0' && strcmp(value, "<empty>") != 0) {
+			uci->bitbase_count = bitbases_open(&uci->bitbases, value);
+			uci_send("info string %d of %d bitbases found in %s", uci->bitbase_count, BITBASE_SET_COUNT, value);
+		}
+		search_pool_set_bitbases(&uci->pool, uci->bitbase_count > 0 ? &uci->bitbases : NULL);
+	} else if (strcasecmp(name, "Ponder") != 0) {
+		uci_send("info string unknown option %s", name);
+	}
+}
+
+// Runs one command from the queue, returns false on 'quit'
+static bool run_command(struct Uci* uci, char* line)
+{
+	char* args = line + strspn(line, " \t");
+	char* command = args;
+	args += strcspn(args, " \t");
+	if (*args != '\0') *args++ = '\0';
+
+	if (strcmp(command, "quit") == 0) {
+		// Nothing to do, the search it may have stopped has answered
+	} else if (strcmp(command, "uci") == 0) {
+		uci_send("id name " ENGINE_NAME);
+		uci_send("id author the " ENGINE_NAME " authors");
+		uci_send("option name Hash type spin default %d min 1 max %d", DEFAULT_HASH_MB, MAX_HASH_MB);
+		uci_send("option name Threads type spin default 1 min 1 max %d", MAX_THREADS);
+		uci_send("option name EvalFile type string default <empty>");
+		uci_send("option name BookFile type string default <empty>");
+		uci_send("option name BitbaseDir type string default <empty>");
+		uci_send("option name Ponder type check default false");
+		uci_send("uciok");
+	} else if (strcmp(command, "isready") == 0) {
+		uci_send("readyok");
+	} else if (strcmp(command, "ucinewgame") == 0) {
+		tt_clear(&uci->tt);
+		search_pool_clear(&uci->pool);
+		game_init_fen(&uci->game, START_FEN);
+	} else if (strcmp(command, "position") == 0) {
+		handle_position(uci, args);
+	} else if (strcmp(command, "go") == 0) {
+		handle_go(uci, args);
+	} else if (strcmp(command, "setoption") == 0) {
+		handle_setoption(uci, args);
+	} else if (strcmp(command, "debug") != 0 && strcmp(command, "register") != 0) {
+		uci_send("info string unknown command %s", command);
+	}
+
+	return strcmp(command, "quit") != 0;
+}
+
+int main(void)
+{
+	if (!slider_attacks_supported()) {
+		fprintf(stderr, "This build uses PEXT, which the processor doesn't support\n");
+		return 1;
+	}
+
+	static struct Uci uci;
+	pthread_t input;
+
+	pthread_mutex_init(&uci.mutex, NULL);
+	pthread_cond_init(&uci.changed, NULL);
+	game_init_fen(&uci.game, START_FEN);
+	uci.random_state = (uint64_t) time(NULL) | 1;
+
+	if (!tt_init(&uci.tt, DEFAULT_HASH_MB) || !start_pool(&uci, 1)) {
+		fprintf(stderr, "Can't allocate the hash table\n");
+		return 1;
+	}
+
+	if (pthread_create(&input, NULL, input_main, &uci) != 0) {
+		fprintf(stderr, "Can't start the input thread\n");
+		return 1;
+	}
+
+	bool keep_going = true;
+	while (keep_going) {
+		char* line = pop_command(&uci);
+		keep_going = run_command(&uci, line);
+		free(line);
+	}
+
+	pthread_join(input, NULL);
+	search_pool_free(&uci.pool);
+	tt_free(&uci.tt);
+	free(uci.network);
+	if (uci.book.data != NULL) book_close(&uci.book);
+	bitbases_close(&uci.bitbases);
+	pthread_mutex_destroy(&uci.mutex);
+	pthread_cond_destroy(&uci.changed);
+
+	return 0;
+}
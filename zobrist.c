@@ -0,0 +1,242 @@
+#include "zobrist.h"
+
+/*
+ * Random keys for the Zobrist hash of a position. They come from a fixed
+ * splitmix64 sequence so keys are the same on every build and machine.
+ */
+
+const uint64_t zobrist_pieces[12][64] = {
+	{
+		0xA2404A1A7FDA9233ULL, 0x3D228DAA11C889C6ULL, 0x0B0D5067049E0292ULL, 0x14AAACB3FB59278BULL,
+		0x1959AC08F19BFA18ULL, 0xD8AA2B6F22ECCEE2ULL, 0xE5810709BC37F765ULL, 0x83D43BDD41BA066BULL,
+		0x7217CDEE664F4B4EULL, 0x23F62199BD19640DULL, 0x1516AE477CD5E77EULL, 0x1BC6457BE2DD6014ULL,
+		0x7403C6E3B1884DF1ULL, 0x2E22D90EAE212147ULL, 0x7399D863F200E341ULL, 0x761E7947E3987656ULL,
+		0x9368F7DA1CC5EA4CULL, 0xD74D6DB8F1146F7CULL, 0x4EA76B99C8C6F5C4ULL, 0x8D0575AB151D0FCFULL,
+		0xEC4E00E2EAD77F08ULL, 0x8DCDBA10F0FB56F4ULL, 0xFB9D3776C3935A3AULL, 0x28B3BF5520DDDF02ULL,
+		0x7F26FA6201819FBDULL, 0x7BE29901F710720BULL, 0x03B04DCFD0ED8A17ULL, 0x185E812EAE9CDA38ULL,
+		0x56FE3BF9D507E791ULL, 0xB0F19A9682549827ULL, 0x1A75D83F9F20BABDULL, 0x046C6CAA7827986CULL,
+		0xE738E9466D016E5AULL, 0x74302B33C97426FCULL, 0xDD17BC4D20339E79ULL, 0x9229978DF9DA5B4CULL,
+		0x150464B9936FE744ULL, 0xAD25538B23217240ULL, 0x3EF6F7D8F0DD6F69ULL, 0x9E74BC06808ED021ULL,
+		0xCFA31535C9D647A5ULL, 0x65C4470B4398F798ULL, 0xB8713F4BB8D36BE1ULL, 0x03C0E4ED98F20130ULL,
+		0x03578CD49FA5D93AULL, 0x83716F2C2C61B333ULL, 0x891864D59F1B72A6ULL, 0x20C4921B6156FB83ULL,
+		0xCDDAA96CDD1AC934ULL, 0xD8F5B7DD9B95ECB3ULL, 0x8BAADFCBCE17A248ULL, 0xEE19E987BA93EBC5ULL,
+		0x71D8366FDAA43D1AULL, 0xC3437D0C8D22BB61ULL, 0x6D167809C682B682ULL, 0x08454681EDEC102BULL,
+		0xBB22CB790C6AEACDULL, 0xC7C3381939E008DEULL, 0x0EF31F993D683614ULL, 0x28FBB0752B062B4AULL,
+		0x0F83F9C60CD64D88ULL, 0x74A8C4457648EF81ULL, 0x0A99CB948108C33EULL, 0x2D49BF6A6F1FF65CULL,
+	},
+	{
+		0x97DDB99A455E874BULL, 0xB0BCEC2C629B8307ULL, 0xB7707B2CB9EB90C5ULL, 0xA8AA4C2783E3A9F3ULL,
+		0x910EDDE3F989A56AULL, 0xF5A26207C52F1F3FULL, 0xE23C2BE574414C8EULL, 0xE6930847AA80803DULL,
+		0xA902569FB4D28C9AULL, 0xF4F4FC274F60279FULL, 0xCCA10713F82742D3ULL, 0x49AC421B5F562827ULL,
+		0x6303CABF328EA6C7ULL, 0xBE8506DD900E15A6ULL, 0x1F57CB2A27597879ULL, 0x118866DFF83E664CULL,
+		0xBF1DB8862DE09B1FULL, 0x505B68A3B33B6670ULL, 0x554B7EA3F78637E1ULL, 0xAB6C4338B722779FULL,
+		0x78534448B788A1FBULL, 0x74F8EF50D1E58544ULL, 0xEE51FD3B52A3236DULL, 0xCCB6511298BFE628ULL,
+		0x44FE7EF9E1A368E2ULL, 0x731D056E9C25DB7CULL, 0xB19B149C06214527ULL, 0x4EB0E0B0CEC53CF7ULL,
+		0x1D0E674DAAB3113FULL, 0x753977F02FED6C16ULL, 0xE928388496779A87ULL, 0x4FD0B5A4498F7B9EULL,
+		0xFCE4783CE30C4924ULL, 0x4435073949301887ULL, 0x5FC6EC42CC413C5DULL, 0xCC3D6A12509F1DE9ULL,
+		0x265A9B52D8BF1BF0ULL, 0xC261B0C098111D98ULL, 0x442A78904B78C604ULL, 0x6056CE07FE62C367ULL,
+		0x6989F67D6620A969ULL, 0xF19482B06EE54B61ULL, 0x9B5109703EECDAACULL, 0xB23219B1AFFEF901ULL,
+		0xE5DA84E453E5187CULL, 0xD4F0420D7D7A4644ULL, 0x6F691DFFD524B6EAULL, 0x7899F1C51A5F0289ULL,
+		0x6253B3CB5F31D0E2ULL, 0xE817B97D9AC071CAULL, 0x142851CCB0A50549ULL, 0xDD37AE5258477B15ULL,
+		0xAE7C86D24F948104ULL, 0x5623ED42EB7EF7F0ULL, 0xB0A0F8AAEBC8BD9AULL, 0x3A5EF94FF5807A98ULL,
+		0x0BF3C05ADAA5261DULL, 0xC65C17A26C9B4901ULL, 0x49415F4EAE467F13ULL, 0x220D56A6667DBC1FULL,
+		0x040D51813665F7EBULL, 0x116B43ED6C484DE3ULL, 0x2A956A3871CD5792ULL, 0x1A87AEE1BC232B83ULL,
+	},
+	{
+		0x746F618BD872A73BULL, 0x55D51A0CB4173860ULL, 0xF32D8C2589F374B7ULL, 0x281CB5142EB7E379ULL,
+		0x34B2FC0EE17A1D4AULL, 0x270D4F99E626E163ULL, 0x16F68B46988B6C09ULL, 0x28EEB519D493812CULL,
+		0x559650D770D7E308ULL, 0xA5892FDFAE97134AULL, 0xD5DBE8E1438707A3ULL, 0x8CC7A3EF97CE7382ULL,
+		0x385375AE65B3F0A8ULL, 0x1B4AB04933D5B6C8ULL, 0x129A2455D65E7C93ULL, 0xA48A24DDEAC28A01ULL,
+		0xEB7D9459A3DDACB1ULL, 0xA6B3EDC7C6388892ULL, 0x7525785C804328D0ULL, 0x19A564C2B6CED304ULL,
+		0x33FBFDDE34B0D174ULL, 0x63B6C81CA5E4B703ULL, 0x302B0D28358E4D57ULL, 0x0AD963EBED72B9FAULL,
+		0x21F45E4AE5BED875ULL, 0x700EADD73D5BFD55ULL, 0xB5DE4D072630292DULL, 0x1E2A5546608BCA5DULL,
+		0x36C2C565986219C5ULL, 0x4D195D25B44BFF5AULL, 0xCF4522B2A815E77EULL, 0x00E6F1D649DF796EULL,
+		0x98C7F5C73F834BC5ULL, 0xB137518154D8CCB3ULL, 0xCAF42A5646DE5880ULL, 0x56CDBBE137414486ULL,
+		0x19A283658B0B3266ULL, 0x1F809EE8CC2DE0B8ULL, 0x1796DF55482EF396ULL, 0xCE297D5833BC323AULL,
+		0xCFE95EA68DBB2BC2ULL, 0x94E6A0F18A152A98ULL, 0xFE990357DA691B23ULL, 0x2C87DECE9BC3F098ULL,
+		0x102991B8E16F424BULL, 0xC721C515DBB68026ULL, 0xA3275E7A9110649CULL, 0xC4DCED564934DDB8ULL,
+		0x0D6E6B906BDB753CULL, 0x82C7A56D9956A5F9ULL, 0x2B1F3AF438A8572AULL, 0xC0DC9BC0E4C2E273ULL,
+		0xA28D34BD4127DE34ULL, 0xC17AC4F6B789BA75ULL, 0x02F7779850716E90ULL, 0x1B78A45596FFAAA7ULL,
+		0x41C153A0F837C7DCULL, 0x8B41700C0B8B5C5BULL, 0xDAD4B7012B0D0543ULL, 0x6612AB5A8548B7DEULL,
+		0x4190422C99285C47ULL, 0xFC03A1FE4379DB85ULL, 0xEEEBEF0239083CA3ULL, 0x238A6D83D4DD9E99ULL,
+	},
+	{
+		0x8E2C6FA51A7123FFULL, 0x23E41F7A8A6E5A65ULL, 0xC7CA2B97997CDA6DULL, 0x1896DA4E84AF3C3BULL,
+		0x71399AAC9A629E76ULL, 0x5616A88BCC983E02ULL, 0xF1CC791FDBBAD67AULL, 0x77ABD70D5DE13AF7ULL,
+		0xB69A4863B19FE7FEULL, 0xF7346A7DA3F385DEULL, 0x181CF0E2B59597E1ULL, 0xC339EE779F1D3C1FULL,
+		0x4EE40B5246AC6437ULL, 0x162B0CBB0D9A3809ULL, 0x60CF061B1D7E5C77ULL, 0x5F7B7DC4A49EB465ULL,
+		0xB4636C2FBC4219D8ULL, 0xD602D69FE412C0F6ULL, 0x1D7A9F0C781FA4EDULL, 0x37B59429DB0CF299ULL,
+		0xBB70FABCECBEFE50ULL, 0xA46FFAEBD4A6F118ULL, 0x80FDA2660729B42AULL, 0xED0BED2669CC4438ULL,
+		0xD6A3DEA568795324ULL, 0x17C4917E3581A018ULL, 0x6CF357C2F35812A0ULL, 0x4260D5C6BC0F456DULL,
+		0x70EB40AAD0B2573FULL, 0x58B750BD6756F57BULL, 0x12C87E1FE58D952AULL, 0x160B108ECB7CD50FULL,
+		0x548085B6F40E82DFULL, 0xD84724199C4C88D2ULL, 0x7AE7398F764E2124ULL, 0x166014D6C8446D68ULL,
+		0x2D423E5D9EE074C2ULL, 0xA96A78A79D611A18ULL, 0xB1015552FBC20440ULL, 0xD63FD6AB24D510ECULL,
+		0x90296A549D195C83ULL, 0x5C7BF8BCEBC5508DULL, 0x317999CEF090751CULL, 0x1FE37FDDD910B723ULL,
+		0x4D12FEF476F62121ULL, 0x4866DE5D0975D600ULL, 0x494E5D65B1678814ULL, 0xA15C06856F7DB438ULL,
+		0x5FF741112BC3A391ULL, 0x8F9FA039440F9BE2ULL, 0x7B4BA490C77D60B9ULL, 0x590A54E792F58D7FULL,
+		0x589C2F4900CF0D1DULL, 0x03B0F40B1A381105ULL, 0x9D4D7828E93C7497ULL, 0xC7FC5843406A32BBULL,
+		0x50B0DB657102CFC8ULL, 0xE3F7400066F9F4AEULL, 0xE60806DD10CDA3DBULL, 0x011875BA0D8650C1ULL,
+		0x93E5CB3EF1BCEF56ULL, 0x0E5DF7533CAFB505ULL, 0xC5C80B882852B799ULL, 0x24565E8AE0B8AB8AULL,
+	},
+	{
+		0x746AA260EFDE5017ULL, 0x17C2AD719D558091ULL, 0xD1CB065100C192D3ULL, 0xBED888608E754E7FULL,
+		0xADDCF5393F32B36FULL, 0x92EFBC26FAFFF6DCULL, 0xD4358F6D99491B50ULL, 0xE6470B8A6B947C14ULL,
+		0x28F69950DAC77DB0ULL, 0x903A6AA104234CD5ULL, 0xBCED792E14C9A191ULL, 0xE3875557B779CBC2ULL,
+		0xA7E52E2440A80C07ULL, 0xB59F0D6B7EF1F9A2ULL, 0xEEB7E2CA22272AF1ULL, 0x8E17675BE58D45F9ULL,
+		0xF8FD191ADAB7D077ULL, 0x7020679DE0EF608AULL, 0x32EFE628A0C728A8ULL, 0x9E65E90C6E3D7BCAULL,
+		0x10FE24ED4F9F58BBULL, 0x8C77EDB7801DD0C6ULL, 0xB648F23669E00A78ULL, 0x7E15EA44EC8233F6ULL,
+		0x22BDB5DA5427A2ACULL, 0x81B146259B4946D1ULL, 0x5B165C94136A4926ULL, 0xAD15F929BB7B6213ULL,
+		0x26847F5DE409B692ULL, 0xCB4646888E639319ULL, 0x5D6FE9AD561B1640ULL, 0x41FFD91081251F88ULL,
+		0xBA62BE6BDC86513EULL, 0x167C6A0CF1DF7BF6ULL, 0xBBECFB129860B30BULL, 0x62B2CD79438712C4ULL,
+		0x20D74174DDCA045BULL, 0x06B295153846036DULL, 0x7AAD8B0DAF63BF73ULL, 0xD69C96CD0141638DULL,
+		0xA970071E15F30A12ULL, 0x3E81222429F114ADULL, 0xFFB9E524F4C55BC1ULL, 0x6CEA064334745106ULL,
+		0xDE53B85C305509D4ULL, 0xEF79395E187E5C0FULL, 0x0310FEADD5C6E3ECULL, 0x255D6B5A9AED718DULL,
+		0x4F576CD547706B61ULL, 0x38E310BAF8CCA433ULL, 0x8A3311263AA5C073ULL, 0xEC955E50F711E310ULL,
+		0x9A0B29A1D1AC242DULL, 0x085490E6BCD26C6EULL, 0xAF304FF33F2588B3ULL, 0x71542B514B3929FFULL,
+		0xC0FF37A97DDD68BBULL, 0xA4C4F6BDE0420BEAULL, 0x997BE0ECEF4D0494ULL, 0x9BF8AFD0E479725CULL,
+		0x60220B5187496B7AULL, 0x5D1B47CF00970AE9ULL, 0x4021F97F1B83B187ULL, 0x30078C857C2D80C3ULL,
+	},
+	{
+		0xC63A581675B8163CULL, 0x60000A28B0688EC4ULL, 0x66F43BD739145E36ULL, 0x588014BD3274665EULL,
+		0x19A95A4ED7C0E95BULL, 0x4DF5FE55B5F681F8ULL, 0xC9CEDFE263A9E35CULL, 0xC8589D70D8F305CEULL,
+		0x675E2A1427975DDBULL, 0xD8570F772489E8EBULL, 0x29C0F9CC888BBC7DULL, 0x0B256D2E9E5B8A56ULL,
+		0x5C506F1D88B2469AULL, 0x1BA9AEEE967ABB61ULL, 0x336B8B2F6C5A2345ULL, 0x00BB038C169AF01BULL,
+		0x9A2F51DA7E522EAEULL, 0x0591C9DE0EEF6A9AULL, 0x615F65EECB9DE407ULL, 0x93BE9820A7924492ULL,
+		0x3AD50977311D2295ULL, 0xA3913B8125003B0EULL, 0xBB30B8D04744F28AULL, 0x8D46D44B6D1AC070ULL,
+		0x28CC0A9D8B431FE5ULL, 0x6312B23F8A05AA79ULL, 0xDF8BF52EBC239987ULL, 0x98483DE872ADFDA9ULL,
+		0x24448E3F88F76BFAULL, 0x5D21A1AFA44FD6E0ULL, 0xDAA74436BA91106BULL, 0x2003BC9A9A40A930ULL,
+		0xE5D333003B5F369FULL, 0x2BAB4CF173885E63ULL, 0x39E6F9BD968785B6ULL, 0x3F279C1281EA7AF8ULL,
+		0xCF56378026A40082ULL, 0xD593C52209E8C606ULL, 0x8852B79E9B5932C7ULL, 0xB382E10CAA23C301ULL,
+		0x7EE51EE90EE3646CULL, 0x768CCAB4D59BF030ULL, 0x2146AE316F9EC8B0ULL, 0x3C72CF046A479D5AULL,
+		0x15D21D4AD1A88FF6ULL, 0x916B5895A7F2EF3FULL, 0x712C557F31504D43ULL, 0x620E95D9497CD547ULL,
+		0xAFDB13B07F82BC66ULL, 0x9C07652447CF43DFULL, 0x26E43D984F58026FULL, 0x948FC8AAFCC89A08ULL,
+		0xC2F0A63E0528BDC0ULL, 0xD93C6BFAC752BC42ULL, 0xEEF5D5F7F2990DA7ULL, 0x791A06DD7766B8B8ULL,
+		0x1039C20368A0107DULL, 0x8985695B5D6707E0ULL, 0x97ABF0496C28CCA5ULL, 0x94BE941D1D4EA40EULL,
+		0xA99C2669D7725077ULL, 0x71597FC2AAD104E6ULL, 0x1535265AB77D6049ULL, 0xFFDF1EF1CE0C200FULL,
+	},
+	{
+		0x3A3A6EB42FA80733ULL, 0x5C01AF71EA368D0EULL, 0x2CF7238207251C14ULL, 0x6CAE2A9654F3C2BEULL,
+		0xBD8123DA9E7D0544ULL, 0x8426C8250DFD4936ULL, 0x75B731D84D560B9DULL, 0x03DFCA67A45D33DCULL,
+		0xC47347973E0602C4ULL, 0xAB1C7D1CC30E25DEULL, 0x4F0A6D737555DD4BULL, 0x6F4EC82CB34FDF33ULL,
+		0xA23C6FBA81008739ULL, 0x8F0F35F2B88AC1F9ULL, 0x44FFF2D85485652DULL, 0xC5564DE55363A1BEULL,
+		0x7BF091C1B56B774DULL, 0x54BC272862D83B17ULL, 0x4CB10744BA039F96ULL, 0x971CAD6DD7C88D20ULL,
+		0x5B5D4440FE177240ULL, 0x9FC124770D364C59ULL, 0xA9550B8C8EA37E61ULL, 0x0FB60907BC7F010BULL,
+		0xDC233AC6786C9EF7ULL, 0xC48AFC53CA64A001ULL, 0x146482B222B77EF5ULL, 0xF0CF43D3A4FD3467ULL,
+		0xF926781B38CE0B0DULL, 0x8D1C87B0CE55DC4BULL, 0xD0E565AC375BBDF4ULL, 0x8CDF7BF0BE91604BULL,
+		0xDBD30CA537152926ULL, 0x4E219D2E985F2AC6ULL, 0x5A51788157D1CDB7ULL, 0x58B103E759ED1A58ULL,
+		0xBBEC005DF53FC44FULL, 0xDCCFD7785CF481A4ULL, 0x58843BF8C471546EULL, 0xA44CF2694423A59BULL,
+		0x584CFDDD349A7DFEULL, 0xAA86C3B50A2927EEULL, 0xB67E06221AF1D60BULL, 0x4AC9923570DD2DFDULL,
+		0xC00C53FEE6A800B5ULL, 0xB3BB34B7CBD60516ULL, 0xA4F0866C0EB3B45CULL, 0x6983C84AF870C1BFULL,
+		0x93552D6EA9304EC2ULL, 0xE8A63FED27473F49ULL, 0x9E75E7837CEF1D70ULL, 0xC60C942275D93F82ULL,
+		0xD2D7FAF59F2AA77EULL, 0xA4380AB6FB378144ULL, 0xE39C0FA167FF633EULL, 0xC3CC4059D9B07CDDULL,
+		0xDFCFBA4253CCE4F4ULL, 0xE3888EFC4B8042CDULL, 0x55CBAA9DDEAD9242ULL, 0x8052DE5EB00D666AULL,
+		0xE0E8E8975F8B0179ULL, 0x248BAC77FD8F85BDULL, 0xD3EB916748A01F20ULL, 0x98C3585980981929ULL,
+	},
+	{
+		0xF7FCF69B99727C7AULL, 0x577AFDE8CB6BA19FULL, 0x6214F9090613AD5EULL, 0x27248F31AAFCB59AULL,
+		0x1DD7F894EB4E86A2ULL, 0x3E65AB549CA302B4ULL, 0xEDB5669A6A39745EULL, 0xC52ED1864399854BULL,
+		0xF8C7FA119315333AULL, 0xE3574CCAE610B32EULL, 0x080167756FE0395CULL, 0x4CF6C2A4FB04A40EULL,
+		0x91EF29C14387D198ULL, 0x7E27010B03FB2DAEULL, 0xD30A7EAF9F780865ULL, 0xD75B6AB9ECAA2472ULL,
+		0xA79D0DFA0D73A295ULL, 0x02B1392F74302810ULL, 0xF54D64757FF64ABFULL, 0x11BD4E3E783AC7E4ULL,
+		0xEB477113EDA68EEBULL, 0x194C7846EC030578ULL, 0x4EDE8CE4EA323E2BULL, 0x196653BF51EA6E68ULL,
+		0xA2C49D3D04795492ULL, 0x4E4B92A6FE1248CAULL, 0x633F471811EB8EE6ULL, 0xD832836C836A6B40ULL,
+		0xA67D9DC686D9415CULL, 0x3775634A5C2549EFULL, 0xB2D4922E841AAC79ULL, 0xF4C89787E770940DULL,
+		0x2323DC1ED20CF5DFULL, 0xF3C84E12202D0A75ULL, 0x438F6CDBC3CBDE6BULL, 0x901EC4184FA709ACULL,
+		0x09CF249CF26596DDULL, 0xF57AA02CECE11B1DULL, 0x4CBEACE47D374EF3ULL, 0x81FAD21BB03E4180ULL,
+		0x4DEBA77560F5A033ULL, 0x028DCD6C5A7236D0ULL, 0xBB42E8176EB64E13ULL, 0x877F8A9565EB1FEBULL,
+		0x051BC0257E42721FULL, 0xE6CF1BEF87D2CA63ULL, 0xF1D821732DE86BF6ULL, 0x9E5FF3FE44B4191AULL,
+		0x6C4D972B5CE953CEULL, 0x1CC904F669991B26ULL, 0x1D8E606AA82976BBULL, 0x8BA427EB2D20C0E5ULL,
+		0x7DE9DFE409BCD73CULL, 0xE1600D4DCD2B6859ULL, 0x64F56F28669A93CBULL, 0x0FE2639A4CC130F0ULL,
+		0xA2ECA961759B601BULL, 0x99FD7F93D30473AFULL, 0x5C339E9D62F9F32CULL, 0xAE3433A6DABA4577ULL,
+		0xC758BF3FD7B7A586ULL, 0x98223516FFE6A625ULL, 0x52C15D3A312159E3ULL, 0xD8E6DF70E56019A8ULL,
+	},
+	{
+		0xD9A035C013BCE84EULL, 0x2CCE161B976E1945ULL, 0xA014E180BAA650ACULL, 0xCC020214A62F1800ULL,
+		0xE82F4676291BA171ULL, 0x815739B509FD778BULL, 0xC2B4480C7AF3821FULL, 0x6FF3147684F718D9ULL,
+		0xE74BBF40D05CB4F7ULL, 0xC3D934AD2AA8D758ULL, 0x7A9E8B555BEB3DCBULL, 0x8CD43A349F803D00ULL,
+		0x533A0DA4317581F5ULL, 0x685C02E6F9DA1C22ULL, 0x33EAE0D68E05E1A0ULL, 0x84C72B9AC262DE3EULL,
+		0x793F32BE4E774147ULL, 0x374FA3B2F92CA11BULL, 0x1882C2E819446DF0ULL, 0x49131E8612B2B339ULL,
+		0x7E484084E40385EAULL, 0xC8C3AE7719A42AB4ULL, 0x4B1265A1B82BAE60ULL, 0x2CAF8444E6E69A11ULL,
+		0xC156BC1BEEBEF320ULL, 0x128EACA10CD39F4FULL, 0x1E5ACB48BF456E8AULL, 0x459F002753E5B942ULL,
+		0xB827598EBCD9E681ULL, 0xDDC91A58440A0154ULL, 0xEC2802E516E0857BULL, 0x76ABEFCAF9FC992AULL,
+		0x01BE93E0AF379ED7ULL, 0x4602124BC74E70A3ULL, 0xE48664D116D03DD6ULL, 0xF7B62ECB9631E422ULL,
+		0x39C297E0F39C05AEULL, 0x0B036C04501AB42BULL, 0xC2EE20E349874A00ULL, 0x11B0F61D195D23F2ULL,
+		0x9273D0973ECDB3F1ULL, 0x245B2F7CBCA838ABULL, 0x06AEBD6EFC3F6336ULL, 0xAF9517333507063CULL,
+		0x2CB19DCD4BF8AB12ULL, 0x8410045472F94088ULL, 0xF659D2175707363AULL, 0x31D258391F6599DEULL,
+		0x4737D36FD0BE5486ULL, 0xC7C7F9CE7AFDA7B7ULL, 0xA016ACD8029D6143ULL, 0x7BA757C6846D0F70ULL,
+		0x6F0DA692A509B08FULL, 0xBBADAE2F32EDDEE2ULL, 0x6A0DB9D3E5F99233ULL, 0xD493B7B0B7DBFC0CULL,
+		0x9BB3264C13D29529ULL, 0x071C22BA970550E9ULL, 0xDEB85537A8C96CE1ULL, 0xA5ACA56796C68607ULL,
+		0x5E9221638319592CULL, 0x47F03EFE8FBCABD0ULL, 0xE5877F086F5F8E2FULL, 0x2EE21DBEEAE7C633ULL,
+	},
+	{
+		0xBC148C12B386003EULL, 0xAE0576D0257A36DFULL, 0xC2BBB99CDD819F1AULL, 0x736CDD3ED98C2134ULL,
+		0xF18EE18B7985A4E7ULL, 0x5D2E9A1F4EB731F6ULL, 0x3974387F71158EF7ULL, 0x4EC451CBEF93B717ULL,
+		0xCC5F1C799034F825ULL, 0x21E2E740DF3043FBULL, 0x9579E1721EB58C0BULL, 0x3DDDF30971A2BB65ULL,
+		0xD5029B76A95AAE22ULL, 0xA78F0338F076F253ULL, 0x77ED42935D39863DULL, 0x02520895CEF49B05ULL,
+		0x2C8C0D3ABA641151ULL, 0x59D47737B02F388FULL, 0x2122C5D56128CA41ULL, 0x290A17FC1CB3F3D9ULL,
+		0x580022F6B31FA663ULL, 0xF00C4538B4CB8FDEULL, 0x9B6F9CBD6A6BEF58ULL, 0x407FA8EC4F79331AULL,
+		0x761C0D61E929D384ULL, 0xF89069FC176DE349ULL, 0x80A452DDE862C4E7ULL, 0x18D16E6C5044A914ULL,
+		0xA3585F7B949C14C8ULL, 0x3A85375F5B932DFCULL, 0x2F87496A37EC0970ULL, 0x0DF3CEAAED878435ULL,
+		0x0BFD7062004C7036ULL, 0x372B2999FBBB37C2ULL, 0xFF486D1D43DB2CC8ULL, 0x47B2BF47F2718EF4ULL,
+		0xBA4A555B338EC891ULL, 0xFAE1CCEE79FEC96AULL, 0x07A9B537DF258EA8ULL, 0xC798B855BB7207EDULL,
+		0x8AD0FEE9E502D9FCULL, 0xC5571F74D78180DFULL, 0x48E930F7585EC903ULL, 0x9998DB8F62964F79ULL,
+		0x3B290F2CDFA30E14ULL, 0xFCED01250D3DFB8CULL, 0x60B4E0B413908903ULL, 0x2D942FE0E53AED89ULL,
+		0x7E8DBDEB1213B90AULL, 0x0F6506519EF19728ULL, 0xE9C0EC8D2DFD808BULL, 0xBCBF54BBBC1586EFULL,
+		0x8C4D591AEF41ABBCULL, 0x8EB0C7331905AE8CULL, 0x35FB921647D96DE8ULL, 0x5D13DBF5CBA953AAULL,
+		0x8D09E66BD4E61BA2ULL, 0x5D598D4CDEF856E9ULL, 0xA6CD8A448D3F0AD9ULL, 0x7076AC35033A0084ULL,
+		0x74EA2F8F20DBDFC4ULL, 0x828F2FB6071D9BD0ULL, 0x340F198781B30C3FULL, 0xC2506180F7F85150ULL,
+	},
+	{
+		0x9BDB6B22F7B6C987ULL, 0x778DB6D966B8B8BDULL, 0xA46132647DCBF446ULL, 0xE002439AB2CFD466ULL,
+		0x6057726E5B4D3E6EULL, 0x9494A708F85F6B33ULL, 0x1BB060BDF828BC74ULL, 0xA08E41120E57699CULL,
+		0xBBB59A05DC295350ULL, 0x9F507C084B0F262AULL, 0xB8595245DD3F0B80ULL, 0xB801B045E932B579ULL,
+		0x6D62DD6DB89AF552ULL, 0x5BD56593731177A9ULL, 0x77A553F82C19D496ULL, 0xF5C9816128B7F187ULL,
+		0x597EDC87E7F4BFF6ULL, 0x50199F777B7D9A27ULL, 0x1B11C855490B0A6BULL, 0xC883EB105C2ED823ULL,
+		0x5579195B24D59BACULL, 0x0EC0CF1CE5EC315BULL, 0xEACC02B34146861AULL, 0xC5403FE2D2B09A83ULL,
+		0x8EB94D32923639C1ULL, 0xE6C5915E2F514FFBULL, 0x740950D180EDBC1BULL, 0x936B9F46D03E3F05ULL,
+		0x9FDC39F0A183C50FULL, 0x5612138363DB33B5ULL, 0xCF0957E4C81AE526ULL, 0xBC2F513DDB6E6632ULL,
+		0xA824934ECED45A30ULL, 0xC09899BDD2D3AB1DULL, 0x4AB369E602062090ULL, 0x19D7C9B07B70B2E5ULL,
+		0xE1EA8C6514BE741AULL, 0xF39E6FC21B7C30B2ULL, 0x127DCBC34786A92DULL, 0x207ED35325E5E678ULL,
+		0x97206923CC33146DULL, 0x9B72DB4BC3DC4899ULL, 0x976D9A3640488CD8ULL, 0x0BC99D68B7B1D1D5ULL,
+		0x0D2A19612C1DDAD6ULL, 0x0E442D658A773BB6ULL, 0x8688E6287ED567D8ULL, 0x26FEF4B95B99A9E1ULL,
+		0xB234A8DFBCD4442DULL, 0x7000F65990E67DFBULL, 0xD678143776900315ULL, 0x2859B25AE6204951ULL,
+		0x4BD6A4E621AAF456ULL, 0x2218B0C5243E7482ULL, 0x409A4FEE946787C4ULL, 0xF7BD03CC94A08B08ULL,
+		0x6EA345CBD3C7F833ULL, 0x2BC6A3051BE5FBB2ULL, 0xCF10953F038BB636ULL, 0xC07A9149D1D5DD33ULL,
+		0xDF93088959606967ULL, 0x07D6CB6629C6DCF5ULL, 0x537F1C1EF131D5CBULL, 0xC629EFEE8ACBE1A9ULL,
+	},
+	{
+		0xABE68652FA8FE53CULL, 0x2BDAA84A571FEFACULL, 0xBCFB3F745EBFDF01ULL, 0x58DCF4349E083D5EULL,
+		0x3195352ECABCD999ULL, 0xD6DD85B040CB1117ULL, 0x78321AEE1AB916D8ULL, 0xF257FEFD9AC04068ULL,
+		0xC50BE573761F52E6ULL, 0xF91291D9DA9B32C6ULL, 0xE933C01FCADF674BULL, 0x43E17369B34A35F7ULL,
+		0x6DE6DB31A187CD95ULL, 0xA9B0FD1586990BBCULL, 0xF7970865B23F6C65ULL, 0xB5A632D8356ED9A1ULL,
+		0xC803DC629FC6060DULL, 0xC4BF6DB99F3BC924ULL, 0x4D88792013875766ULL, 0x249DD604E7E1A1C9ULL,
+		0xC6DC2ECB4D59A20EULL, 0xCDA43DCF6FE7A97EULL, 0x19C62FF2974AE532ULL, 0xD510CD372960D93AULL,
+		0xED5C869665ECFD3AULL, 0xE5D8C1880FA244EAULL, 0xEABEC951C7BB6F92ULL, 0x74F5284E20E3BA79ULL,
+		0xA6265B9C9FDF38F0ULL, 0xE0E09D9658F21535ULL, 0xB09C77B0E28A80C4ULL, 0xA8CC9811C1BC07D3ULL,
+		0xA1A5AE4886981C09ULL, 0x9D577561C0EC5F6FULL, 0x72AE2A8B06134F6DULL, 0x66027F1A001B3992ULL,
+		0x5381C4DB09C7CE84ULL, 0xA1B8EE9D4FDBC17FULL, 0x02E8F1E5118A4D84ULL, 0x411D22F42070B59FULL,
+		0xE86C3C3F41159891ULL, 0xD7623738B5EB00E8ULL, 0x08F4140FC0424963ULL, 0x30DC0585B614DE8FULL,
+		0xD9EA920A8B21CC4CULL, 0x83DD84BB8EE24EE1ULL, 0x428C02B5660AE789ULL, 0x4B2819ECB49AC8F0ULL,
+		0xBBD9D543BD4BCB68ULL, 0x6B4192685998767FULL, 0xF33ABF6B956528EBULL, 0x4B9A3E199142ADFBULL,
+		0xF2EA55F375C27A7CULL, 0xF0C10730E632E850ULL, 0x2E2A822013112048ULL, 0xAFB0623C1630AF57ULL,
+		0x440B7C5A8D93CE29ULL, 0xE80B29FCB3A3F6CAULL, 0x910329F72BD54381ULL, 0xA93DAB8303BDE105ULL,
+		0x76DD41B69B921BC3ULL, 0x03529E96D40D022AULL, 0xC1EF9DF4804AC124ULL, 0xBEEA7775B27322E6ULL,
+	},
+};
+
+// Indexed by the whole set of rights, no rights adds nothing to the key
+const uint64_t zobrist_castling[16] = {
+	0x0000000000000000ULL, 0x997150DE6CA22C38ULL, 0x3AF6BF43BDECECD0ULL, 0xB71470B9C83DF0C4ULL,
+	0x7A441AD4CF879223ULL, 0x3813A4FACB8CA6ECULL, 0x9354680BFA56DEEDULL, 0x36C5801C866ED7BFULL,
+	0xDB23698BA94CE7BCULL, 0xE25EE0481D3AAB88ULL, 0xCA20D6F43FE8EC03ULL, 0xDF15DA709AC73160ULL,
+	0x4DCD6412DD97445EULL, 0x49D3A55315C34440ULL, 0xCA04E093D120CD0EULL, 0x44488A6516FF173FULL,
+};
+
+// Indexed by the column of the en passant square
+const uint64_t zobrist_en_passant[8] = {
+	0x5C86BB9AC48F8731ULL, 0x89D375B7CAAAC1A8ULL, 0x9EDD1D7224E05E44ULL, 0x0B4DDFDD2329B22AULL,
+	0x87B3CD2D8779C362ULL, 0xCEEF9EAB7941A1DDULL, 0x0C3705901D640C61ULL, 0xA2FF04F1CE0E6743ULL,
+};
+
+// Added when black is to move
+const uint64_t zobrist_side = 0x2DC84C4F98E462C8ULL;
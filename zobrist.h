@@ -0,0 +1,16 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+
+/*
+ * A position's key is the XOR of one random number per piece on its square,
+ * per set of castling rights, per en passant column and for the side to move.
+ * Making a move only XORs in and out what changed.
+ */
+extern const uint64_t zobrist_pieces[12][64];
+extern const uint64_t zobrist_castling[16];
+extern const uint64_t zobrist_en_passant[8];
+extern const uint64_t zobrist_side;
+
+#endif